@@ -1,16 +1,22 @@
 #include "devices/input.h"
 #include <debug.h>
+#include <poll.h>
 #include "devices/intq.h"
 #include "devices/serial.h"
+#include "threads/waitq.h"
 
 /* Stores keys from the keyboard and serial port. */
 static struct intq buffer;
 
+/* Woken when a key is added to the buffer. */
+static struct waitq waitq;
+
 /* Initializes the input buffer. */
 void
 input_init (void) 
 {
   intq_init (&buffer);
+  waitq_init (&waitq);
 }
 
 /* Adds a key to the input buffer.
@@ -23,6 +29,7 @@ input_putc (uint8_t key)
 
   intq_putc (&buffer, key);
   serial_notify ();
+  waitq_wake (&waitq);
 }
 
 /* Retrieves a key from the input buffer.
@@ -50,3 +57,21 @@ input_full (void)
   ASSERT (intr_get_level () == INTR_OFF);
   return intq_full (&buffer);
 }
+
+/* Returns POLLIN if a key is waiting in the input buffer,
+   otherwise 0.  If W is nonnull, first registers it, using
+   entry E, to be woken when a key arrives. */
+unsigned
+input_poll (struct waiter *w, struct waitq_entry *e)
+{
+  enum intr_level old_level;
+  bool empty;
+
+  if (w != NULL)
+    waitq_add (&waitq, w, e);
+  old_level = intr_disable ();
+  empty = intq_empty (&buffer);
+  intr_set_level (old_level);
+
+  return empty ? 0 : POLLIN;
+}
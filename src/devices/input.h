@@ -4,9 +4,13 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+struct waiter;
+struct waitq_entry;
+
 void input_init (void);
 void input_putc (uint8_t);
 uint8_t input_getc (void);
 bool input_full (void);
+unsigned input_poll (struct waiter *, struct waitq_entry *);
 
 #endif /* devices/input.h */
@@ -7,12 +7,19 @@
 #include "threads/io.h"
 #include "threads/thread.h"
 #ifdef USERPROG
+#include "userprog/elf.h"
 #include "userprog/exception.h"
+#include "userprog/pagedir.h"
+#include "userprog/syscall.h"
 #endif
 #ifdef FILESYS
 #include "devices/block.h"
 #include "filesys/filesys.h"
 #endif
+#ifdef VM
+#include "vm/share.h"
+#include "vm/swap.h"
+#endif
 
 /* Keyboard control register port. */
 #define CONTROL_REG 0x64
@@ -137,5 +144,12 @@ print_stats (void)
   kbd_print_stats ();
 #ifdef USERPROG
   exception_print_stats ();
+  pagedir_print_stats ();
+  syscall_print_stats ();
+  elf_print_stats ();
+#endif
+#ifdef VM
+  share_print_stats ();
+  swap_print_stats ();
 #endif
 }
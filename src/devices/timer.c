@@ -1,12 +1,18 @@
 #include "devices/timer.h"
+#include <cpuid.h>
 #include <debug.h>
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
+#include <tsc.h>
 #include "devices/pit.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/waitq.h"
+#ifdef USERPROG
+#include "userprog/vdata.h"
+#endif
   
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -24,11 +30,19 @@ static int64_t ticks;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Number of TSC cycles per timer tick, or 0 if the CPU has no
+   TSC.  Initialized by timer_calibrate(). */
+static uint64_t tsc_per_tick;
+
+/* Number of ticks over which the TSC is measured. */
+#define TSC_CALIBRATE_TICKS 4
+
 static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
 static void real_time_delay (int64_t num, int32_t denom);
+static void calibrate_tsc (void);
 
 /* Sets up the timer to interrupt TIMER_FREQ times per second,
    and registers the corresponding interrupt. */
@@ -64,6 +78,17 @@ timer_calibrate (void)
       loops_per_tick |= test_bit;
 
   printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+
+  if (cpuid_features () & CPUID_TSC)
+    calibrate_tsc ();
+}
+
+/* Returns the number of TSC cycles per second, or 0 if the CPU
+   has no TSC. */
+uint64_t
+timer_tsc_freq (void)
+{
+  return tsc_per_tick * TIMER_FREQ;
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -173,6 +198,9 @@ timer_interrupt (struct intr_frame *args UNUSED)
 {
   ticks++;
   thread_tick ();
+#ifdef USERPROG
+  vdata_tick (ticks);
+#endif
 
   if (thread_mlfqs) {
     thread_increment_recent_cpu();
@@ -186,6 +214,26 @@ timer_interrupt (struct intr_frame *args UNUSED)
   }
 
   thread_wakeup (ticks);
+  waiter_tick (ticks);
+}
+
+/* Measures tsc_per_tick by counting TSC cycles across
+   TSC_CALIBRATE_TICKS timer ticks, starting and ending just
+   after a tick. */
+static void
+calibrate_tsc (void)
+{
+  int64_t start;
+  uint64_t start_tsc;
+
+  start = ticks;
+  while (ticks == start)
+    barrier ();
+  start = ticks;
+  start_tsc = rdtsc ();
+  while (ticks - start < TSC_CALIBRATE_TICKS)
+    barrier ();
+  tsc_per_tick = (rdtsc () - start_tsc) / TSC_CALIBRATE_TICKS;
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -11,6 +11,7 @@
 
 void timer_init (void);
 void timer_calibrate (void);
+uint64_t timer_tsc_freq (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
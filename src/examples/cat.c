@@ -1,6 +1,7 @@
 /* cat.c
 
-   Prints files specified on command line to the console. */
+   Prints files specified on command line to the console, or
+   copies standard input if there are none. */
 
 #include <stdio.h>
 #include <syscall.h>
@@ -10,25 +11,31 @@ main (int argc, char *argv[])
 {
   bool success = true;
   int i;
+
+  if (argc < 2)
+    {
+      char buf[512];
+      int n;
+
+      while ((n = read (STDIN_FILENO, buf, sizeof buf)) > 0)
+        fwrite (buf, 1, n, stdout);
+      return EXIT_SUCCESS;
+    }
   
   for (i = 1; i < argc; i++) 
     {
-      int fd = open (argv[i]);
-      if (fd < 0) 
+      FILE *file = fopen (argv[i], "r");
+      int c;
+
+      if (file == NULL) 
         {
           printf ("%s: open failed\n", argv[i]);
           success = false;
           continue;
         }
-      for (;;) 
-        {
-          char buffer[1024];
-          int bytes_read = read (fd, buffer, sizeof buffer);
-          if (bytes_read == 0)
-            break;
-          write (STDOUT_FILENO, buffer, bytes_read);
-        }
-      close (fd);
+      while ((c = getc (file)) != EOF)
+        putchar (c);
+      fclose (file);
     }
   return success ? EXIT_SUCCESS : EXIT_FAILURE;
 }
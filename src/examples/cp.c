@@ -1,50 +1,116 @@
-/* cat.c
+/* cp.c
 
-Copies one file to another. */
+Copies one file to another.  Reads and writes go through the
+system call ring a batch at a time, so that several of them are
+in flight at once for the price of one system call. */
 
+#include <ring.h>
 #include <stdio.h>
 #include <syscall.h>
+#include <syscall-nr.h>
+
+/* Number of blocks read or written in one batch. */
+#define BATCH_BLOCKS 8
+
+/* Size of a block. */
+#define BLOCK_SIZE RING_IO_MAX
+
+static struct ring *ring;
+static char buffers[BATCH_BLOCKS][BLOCK_SIZE];
+
+/* Reads (if NR is SYS_READ) or writes (if NR is SYS_WRITE) the
+   CNT bytes at offset OFS in the file open as FD, in blocks,
+   all at once.  Returns true if successful. */
+static bool
+transfer (int nr, int fd, unsigned ofs, unsigned cnt)
+{
+  unsigned block_cnt = 0;
+  unsigned i;
+  bool success = true;
+
+  for (i = 0; i * BLOCK_SIZE < cnt; i++)
+    {
+      struct ring_sqe *sqe = &ring->sq[ring->sq_tail % RING_SQ_SIZE];
+      unsigned size = cnt - i * BLOCK_SIZE;
+
+      sqe->nr = nr;
+      sqe->args[0] = fd;
+      sqe->args[1] = (int) buffers[i];
+      sqe->args[2] = size < BLOCK_SIZE ? size : BLOCK_SIZE;
+      sqe->ofs = ofs + i * BLOCK_SIZE;
+      sqe->user_data = sqe->args[2];
+      ring->sq_tail++;
+      block_cnt++;
+    }
+
+  if (ring_enter (block_cnt, block_cnt) != (int) block_cnt)
+    return false;
+  for (i = 0; i < block_cnt; i++)
+    {
+      volatile struct ring_cqe *cqe;
+
+      cqe = &ring->cq[ring->cq_head % RING_CQ_SIZE];
+      if (cqe->result != (int) cqe->user_data)
+        success = false;
+      ring->cq_head++;
+    }
+  return success;
+}
 
 int
-main (int argc, char *argv[]) 
+main (int argc, char *argv[])
 {
   int in_fd, out_fd;
+  unsigned size, ofs;
 
-  if (argc != 3) 
+  if (argc != 3)
     {
       printf ("usage: cp OLD NEW\n");
       return EXIT_FAILURE;
     }
 
+  ring = ring_setup ();
+  if (ring == NULL)
+    {
+      printf ("cp: ring_setup failed\n");
+      return EXIT_FAILURE;
+    }
+
   /* Open input file. */
   in_fd = open (argv[1]);
-  if (in_fd < 0) 
+  if (in_fd < 0)
     {
       printf ("%s: open failed\n", argv[1]);
       return EXIT_FAILURE;
     }
+  size = filesize (in_fd);
 
   /* Create and open output file. */
-  if (!create (argv[2], filesize (in_fd))) 
+  if (!create (argv[2], size))
     {
       printf ("%s: create failed\n", argv[2]);
       return EXIT_FAILURE;
     }
   out_fd = open (argv[2]);
-  if (out_fd < 0) 
+  if (out_fd < 0)
     {
       printf ("%s: open failed\n", argv[2]);
       return EXIT_FAILURE;
     }
 
   /* Copy data. */
-  for (;;) 
+  for (ofs = 0; ofs < size; ofs += sizeof buffers)
     {
-      char buffer[1024];
-      int bytes_read = read (in_fd, buffer, sizeof buffer);
-      if (bytes_read == 0)
-        break;
-      if (write (out_fd, buffer, bytes_read) != bytes_read) 
+      unsigned cnt = size - ofs;
+      if (cnt > sizeof buffers)
+        cnt = sizeof buffers;
+
+      if (!transfer (SYS_READ, in_fd, ofs, cnt))
+        {
+          printf ("%s: read failed\n", argv[1]);
+          return EXIT_FAILURE;
+        }
+      if (!transfer (SYS_WRITE, out_fd, ofs, cnt))
         {
           printf ("%s: write failed\n", argv[2]);
           return EXIT_FAILURE;
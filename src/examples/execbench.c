@@ -0,0 +1,78 @@
+/* execbench.c
+
+   Measures how long it takes to run a program: to create a
+   process, load the program into it, let it run, and learn that
+   it has exited, with exec() and wait().  The first run, which
+   may have to read the program from disk, is reported apart from
+   the rest.
+
+   Optional arguments: number of runs (default 1000), then the
+   program to run (default "true") followed by its arguments. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+#include <tsc.h>
+
+/* Runs CMD_LINE once and waits for it to exit.  Returns false if
+   it could not be started. */
+static bool
+run (const char *cmd_line)
+{
+  pid_t pid = exec (cmd_line);
+  if (pid == PID_ERROR)
+    return false;
+  wait (pid);
+  return true;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int cnt = argc > 1 ? atoi (argv[1]) : 1000;
+  char program[128] = "true";
+  uint64_t start, first, rest;
+  int i;
+
+  if (cnt <= 0)
+    {
+      printf ("usage: execbench [RUNS [PROGRAM [ARG...]]]\n");
+      return EXIT_FAILURE;
+    }
+
+  /* Put the program's command line back together. */
+  if (argc > 2)
+    {
+      strlcpy (program, argv[2], sizeof program);
+      for (i = 3; i < argc; i++)
+        {
+          strlcat (program, " ", sizeof program);
+          strlcat (program, argv[i], sizeof program);
+        }
+    }
+
+  start = rdtsc ();
+  if (!run (program))
+    {
+      printf ("execbench: %s: exec failed\n", program);
+      return EXIT_FAILURE;
+    }
+  first = rdtsc () - start;
+
+  start = rdtsc ();
+  for (i = 1; i < cnt; i++)
+    if (!run (program))
+      {
+        printf ("execbench: %s: exec failed after %d runs\n", program, i);
+        return EXIT_FAILURE;
+      }
+  rest = rdtsc () - start;
+
+  printf ("first run: %"PRIu64" cycles\n", first);
+  if (cnt > 1)
+    printf ("%d more runs: %"PRIu64" cycles per run\n",
+            cnt - 1, rest / (cnt - 1));
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+/* heapbench.c
+
+   Measures the speed of malloc() and free() and how well they use
+   the heap.  Allocates and frees blocks of random sizes, mostly
+   small with a tail of larger ones, keeping up to SLOTS of them
+   live at once, and reports the cycles per operation and the
+   peak live data as a fraction of the peak heap size.  Finally
+   frees everything and reports how much of the heap is left.
+
+   Optional arguments: number of operations (default 100000) and
+   random seed (default 1). */
+
+#include <inttypes.h>
+#include <malloc.h>
+#include <random.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include <tsc.h>
+
+/* Most blocks live at once. */
+#define SLOTS 1024
+
+/* Live blocks and their sizes. */
+static char *blocks[SLOTS];
+static size_t sizes[SLOTS];
+
+/* Returns a random block size: 80% are 1 to 256 bytes, 15% are
+   up to 4 kB, and 5% are up to 32 kB. */
+static size_t
+random_size (void)
+{
+  unsigned long r = random_ulong ();
+  unsigned pct = r % 100;
+
+  r /= 100;
+  if (pct < 80)
+    return r % 256 + 1;
+  else if (pct < 95)
+    return r % 4096 + 1;
+  else
+    return r % 32768 + 1;
+}
+
+/* Returns the current size of the heap, given its START. */
+static size_t
+heap_size (char *start)
+{
+  return (char *) sbrk (0) - start;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int cnt = argc > 1 ? atoi (argv[1]) : 100000;
+  char *start = sbrk (0);
+  size_t live = 0, peak_live = 0, peak_heap = 0;
+  uint64_t begin, cycles;
+  int i;
+
+  if (cnt <= 0)
+    {
+      printf ("usage: heapbench [OPERATIONS [SEED]]\n");
+      return EXIT_FAILURE;
+    }
+  random_init (argc > 2 ? atoi (argv[2]) : 1);
+
+  begin = rdtsc ();
+  for (i = 0; i < cnt; i++)
+    {
+      size_t slot = random_ulong () % SLOTS;
+
+      if (blocks[slot] != NULL)
+        {
+          free (blocks[slot]);
+          blocks[slot] = NULL;
+          live -= sizes[slot];
+        }
+      else
+        {
+          sizes[slot] = random_size ();
+          blocks[slot] = malloc (sizes[slot]);
+          if (blocks[slot] == NULL)
+            {
+              printf ("heapbench: out of memory after %d operations\n", i);
+              return EXIT_FAILURE;
+            }
+
+          /* Touch both ends, as a real user would. */
+          blocks[slot][0] = blocks[slot][sizes[slot] - 1] = 1;
+          live += sizes[slot];
+          if (live > peak_live)
+            peak_live = live;
+        }
+
+      /* Sample the heap size now and then; asking every time
+         would add a system call to each operation. */
+      if (i % 256 == 0 && heap_size (start) > peak_heap)
+        peak_heap = heap_size (start);
+    }
+  cycles = rdtsc () - begin;
+  if (heap_size (start) > peak_heap)
+    peak_heap = heap_size (start);
+
+  printf ("%d operations, %"PRIu64" cycles per operation\n",
+          cnt, cycles / cnt);
+  printf ("peak live data %zu bytes, peak heap %zu bytes (%zu%% used)\n",
+          peak_live, peak_heap,
+          peak_heap > 0 ? (size_t) ((uint64_t) peak_live * 100 / peak_heap)
+          : 0);
+
+  for (i = 0; i < SLOTS; i++)
+    free (blocks[i]);
+  printf ("heap after freeing everything: %zu bytes\n", heap_size (start));
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,77 @@
+/* nullsys.c
+
+   Measures the round trip into the kernel and back for a system
+   call that does no work, entering the kernel with "int $0x30"
+   and, if the CPU supports it, with "sysenter".  The system call
+   is tell() on a file handle that is not open.
+
+   Optional argument: number of calls to time (default 100000). */
+
+#include <cpuid.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include <syscall-nr.h>
+#include <tsc.h>
+
+/* Makes the null system call with "int $0x30". */
+static void
+null_int (void)
+{
+  int retval;
+  asm volatile ("pushl $-1; pushl %[number]; int $0x30; addl $8, %%esp"
+                : "=a" (retval)
+                : [number] "i" (SYS_TELL)
+                : "memory");
+}
+
+/* Makes the null system call with "sysenter". */
+static void
+null_sysenter (void)
+{
+  int retval;
+  asm volatile ("pushl $-1; pushl %[number]; "
+                "movl %%esp, %%ecx; movl $1f, %%edx; sysenter; "
+                "1: addl $8, %%esp"
+                : "=a" (retval)
+                : [number] "i" (SYS_TELL)
+                : "ecx", "edx", "memory");
+}
+
+/* Times CNT calls to CALL and prints the average. */
+static void
+measure (const char *name, void (*call) (void), int cnt)
+{
+  uint64_t start, cycles;
+  int i;
+
+  /* Fault in everything the loop touches first. */
+  call ();
+
+  start = rdtsc ();
+  for (i = 0; i < cnt; i++)
+    call ();
+  cycles = rdtsc () - start;
+
+  printf ("%-8s %"PRIu64" cycles per call\n", name, cycles / cnt);
+}
+
+int
+main (int argc, char *argv[])
+{
+  int cnt = argc > 1 ? atoi (argv[1]) : 100000;
+
+  if (cnt <= 0)
+    {
+      printf ("usage: nullsys [CALLS]\n");
+      return EXIT_FAILURE;
+    }
+
+  measure ("int", null_int, cnt);
+  if (cpuid_has_sysenter ())
+    measure ("sysenter", null_sysenter, cnt);
+  else
+    printf ("sysenter not supported\n");
+  return EXIT_SUCCESS;
+}
@@ -3,8 +3,12 @@
 #include <string.h>
 #include <syscall.h>
 
+/* Maximum number of commands in a pipeline. */
+#define MAX_STAGES 8
+
 static void read_line (char line[], size_t);
 static bool backspace (char **pos, char line[]);
+static void run_pipeline (char *command);
 
 int
 main (void)
@@ -31,19 +35,87 @@ main (void)
           /* Empty command. */
         }
       else
-        {
-          pid_t pid = exec (command);
-          if (pid != PID_ERROR)
-            printf ("\"%s\": exit code %d\n", command, wait (pid));
-          else
-            printf ("exec failed\n");
-        }
+        run_pipeline (command);
     }
 
   printf ("Shell exiting.");
   return EXIT_SUCCESS;
 }
 
+/* Runs COMMAND, which may be several commands separated by `|',
+   each with its standard output connected to the standard input
+   of the next through a pipe, then waits for all of them. */
+static void
+run_pipeline (char *command)
+{
+  char *stages[MAX_STAGES];
+  pid_t pids[MAX_STAGES];
+  int stage_cnt = 0;
+  int in_fd = -1;
+  char *stage, *save_ptr;
+  int i;
+
+  for (stage = strtok_r (command, "|", &save_ptr); stage != NULL;
+       stage = strtok_r (NULL, "|", &save_ptr))
+    {
+      char *end;
+
+      if (stage_cnt >= MAX_STAGES)
+        {
+          printf ("too many commands in pipeline\n");
+          return;
+        }
+      while (*stage == ' ')
+        stage++;
+      for (end = stage + strlen (stage); end > stage && end[-1] == ' '; )
+        *--end = '\0';
+      stages[stage_cnt++] = stage;
+    }
+
+  /* Our own output must not end up in a pipe. */
+  fflush (stdout);
+
+  for (i = 0; i < stage_cnt; i++)
+    {
+      int fds[2] = {-1, -1};
+
+      if (i + 1 < stage_cnt && !pipe (fds))
+        {
+          printf ("pipe failed\n");
+          stage_cnt = i;
+          break;
+        }
+
+      /* The child inherits our standard input and output, so
+         redirect them for the moment it takes to start it. */
+      if (in_fd >= 0)
+        dup2 (in_fd, STDIN_FILENO);
+      if (fds[1] >= 0)
+        dup2 (fds[1], STDOUT_FILENO);
+      pids[i] = exec (stages[i]);
+      if (in_fd >= 0)
+        {
+          close (STDIN_FILENO);
+          close (in_fd);
+        }
+      if (fds[1] >= 0)
+        {
+          close (STDOUT_FILENO);
+          close (fds[1]);
+        }
+      in_fd = fds[0];
+
+      if (pids[i] == PID_ERROR)
+        printf ("\"%s\": exec failed\n", stages[i]);
+    }
+  if (in_fd >= 0)
+    close (in_fd);
+
+  for (i = 0; i < stage_cnt; i++)
+    if (pids[i] != PID_ERROR)
+      printf ("\"%s\": exit code %d\n", stages[i], wait (pids[i]));
+}
+
 /* Reads a line of input from the user into LINE, which has room
    for SIZE bytes.  Handles backspace and Ctrl+U in the ways
    expected by Unix users.  On return, LINE will always be
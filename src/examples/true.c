@@ -0,0 +1,11 @@
+/* true.c
+
+   Does nothing, successfully. */
+
+#include <syscall.h>
+
+int
+main (void)
+{
+  return EXIT_SUCCESS;
+}
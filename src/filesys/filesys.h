@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include "filesys/off_t.h"
+#include "threads/synch.h"
 
 /* Sectors of system file inodes. */
 #define FREE_MAP_SECTOR 0       /* Free map file inode sector. */
@@ -11,6 +12,12 @@
 /* Block device that contains the file system. */
 extern struct block *fs_device;
 
+/* Serializes file system operations on behalf of user programs.
+   Opening, closing, and reading inodes is safe without it, so
+   that paging can read executables and mapped files without
+   waiting for a system call that is blocked on the disk. */
+extern struct lock filesys_lock;
+
 void filesys_init (bool format);
 void filesys_done (void);
 bool filesys_create (const char *name, off_t initial_size);
@@ -0,0 +1,66 @@
+#ifndef __LIB_CPUID_H
+#define __LIB_CPUID_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Feature bits that CPUID reports in EDX for EAX=1.
+   See [IA32-v2a] "CPUID--CPU Identification". */
+#define CPUID_PSE 0x00000008    /* Page size extensions. */
+#define CPUID_TSC 0x00000010    /* Time-stamp counter. */
+#define CPUID_SEP 0x00000800    /* SYSENTER and SYSEXIT. */
+
+/* Executes CPUID for EAX=1 and stores its signature, from EAX,
+   into *SIGNATURE and its feature bits, from EDX, into
+   *FEATURES.  Both are 0 if the CPU is too old to have CPUID,
+   which is the case if the ID flag in EFLAGS cannot be
+   changed. */
+static inline void
+cpuid_identify (uint32_t *signature, uint32_t *features)
+{
+  uint32_t flags, toggled;
+  uint32_t eax = 1, ebx, ecx, edx;
+
+  /* 0x00200000 is the ID flag. */
+  asm volatile ("pushfl; popl %0; movl %0, %1; xorl %2, %1; "
+                "pushl %1; popfl; pushfl; popl %1; pushl %0; popfl"
+                : "=&r" (flags), "=&r" (toggled) : "i" (0x00200000));
+  if (((flags ^ toggled) & 0x00200000) == 0)
+    {
+      *signature = *features = 0;
+      return;
+    }
+
+  asm volatile ("cpuid" : "+a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx));
+  *signature = eax;
+  *features = edx;
+}
+
+/* Returns the feature bits that CPUID reports in EDX for EAX=1,
+   or 0 if the CPU does not have CPUID. */
+static inline uint32_t
+cpuid_features (void)
+{
+  uint32_t signature, features;
+  cpuid_identify (&signature, &features);
+  return features;
+}
+
+/* Returns true if the CPU supports SYSENTER and SYSEXIT.  The
+   first Pentium Pro models claim to support them but do not.
+   See [IA32-v2b] "SYSENTER". */
+static inline bool
+cpuid_has_sysenter (void)
+{
+  uint32_t signature, features;
+  unsigned family, model, stepping;
+
+  cpuid_identify (&signature, &features);
+  family = (signature >> 8) & 0xf;
+  model = (signature >> 4) & 0xf;
+  stepping = signature & 0xf;
+  return ((features & CPUID_SEP) != 0
+          && !(family == 6 && model < 3 && stepping < 3));
+}
+
+#endif /* lib/cpuid.h */
@@ -0,0 +1,11 @@
+#ifndef __LIB_FCNTL_H
+#define __LIB_FCNTL_H
+
+/* Commands for fcntl(). */
+#define F_GETFD 1               /* Get descriptor flags. */
+#define F_SETFD 2               /* Set descriptor flags. */
+
+/* Descriptor flags. */
+#define FD_CLOEXEC 0x01         /* Not inherited by exec(). */
+
+#endif /* lib/fcntl.h */
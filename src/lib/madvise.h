@@ -0,0 +1,15 @@
+#ifndef __LIB_MADVISE_H
+#define __LIB_MADVISE_H
+
+/* Advice for the madvise() system call about how a range of the
+   address space will be used. */
+enum madvise_advice
+  {
+    MADV_NORMAL,                /* No special treatment. */
+    MADV_RANDOM,                /* Expect random access: no readahead. */
+    MADV_SEQUENTIAL,            /* Expect sequential access. */
+    MADV_WILLNEED,              /* Expect access soon: prefetch now. */
+    MADV_DONTNEED               /* Contents not needed: discard. */
+  };
+
+#endif /* lib/madvise.h */
@@ -0,0 +1,11 @@
+#ifndef __LIB_OOM_H
+#define __LIB_OOM_H
+
+/* Range of a process's OOM score adjustment, as set with the
+   oom_adjust() system call.  A process at OOM_ADJ_MIN is never
+   killed for lack of memory; one at OOM_ADJ_MAX is killed
+   first. */
+#define OOM_ADJ_MIN (-1000)
+#define OOM_ADJ_MAX 1000
+
+#endif /* lib/oom.h */
@@ -0,0 +1,22 @@
+#ifndef __LIB_POLL_H
+#define __LIB_POLL_H
+
+/* Events for poll(). */
+#define POLLIN 0x01             /* Data to read, or end of file. */
+#define POLLOUT 0x02            /* Writing will not block. */
+#define POLLERR 0x04            /* Error, e.g. a pipe without readers. */
+#define POLLHUP 0x08            /* Pipe without writers. */
+#define POLLNVAL 0x10           /* Descriptor is not open. */
+
+/* Most descriptors that one poll() call accepts. */
+#define POLL_MAX 32
+
+/* A descriptor for poll() to watch. */
+struct pollfd
+  {
+    int fd;                     /* Descriptor, or negative to skip. */
+    short events;               /* Events of interest. */
+    short revents;              /* Events that occurred. */
+  };
+
+#endif /* lib/poll.h */
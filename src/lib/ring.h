@@ -0,0 +1,61 @@
+#ifndef __LIB_RING_H
+#define __LIB_RING_H
+
+/* User virtual address at which ring_setup() maps a process's
+   system call ring, just above the kernel data page. */
+#define RING_ADDR ((void *) 0x00011000)
+
+/* Number of entries in the submission and completion queues.
+   Both must be powers of 2. */
+#define RING_SQ_SIZE 64
+#define RING_CQ_SIZE 128
+
+/* Most bytes transferred by one read or write submitted through
+   the ring.  Longer requests are cut short. */
+#define RING_IO_MAX 4096
+
+/* A submission queue entry: one system call to make.
+
+   SYS_READ and SYS_WRITE are carried out asynchronously by
+   kernel threads, at file offset OFS instead of the file's
+   current position, which they leave unchanged.  The data to
+   write is copied when the request is submitted, so its buffer
+   may be reused at once, but a read's buffer must not be
+   touched until its completion arrives.
+
+   SYS_OPEN, SYS_CLOSE, SYS_SEEK, SYS_TELL, SYS_FILESIZE,
+   SYS_CREATE, and SYS_REMOVE are made at once, when they are
+   submitted.  Any other system call completes with result -1. */
+struct ring_sqe
+  {
+    int nr;                     /* System call number, SYS_*. */
+    int args[3];                /* Arguments, as for the system call. */
+    unsigned ofs;               /* File offset for reads and writes. */
+    unsigned user_data;         /* Passed through to the completion. */
+  };
+
+/* A completion queue entry: the result of one system call. */
+struct ring_cqe
+  {
+    unsigned user_data;         /* From the submission. */
+    int result;                 /* System call's return value. */
+  };
+
+/* A system call ring, shared between a process and the kernel.
+
+   Indexes run freely and are reduced modulo the queue size.
+   The process adds entries to SQ at SQ_TAIL and passes them to
+   ring_enter(), which consumes them at SQ_HEAD.  The kernel adds
+   completions to CQ at CQ_TAIL, possibly while the process is
+   running, and the process consumes them at CQ_HEAD. */
+struct ring
+  {
+    volatile unsigned sq_head;  /* Written by the kernel. */
+    unsigned sq_tail;           /* Written by the process. */
+    unsigned cq_head;           /* Written by the process. */
+    volatile unsigned cq_tail;  /* Written by the kernel. */
+    struct ring_sqe sq[RING_SQ_SIZE];
+    volatile struct ring_cqe cq[RING_CQ_SIZE];
+  };
+
+#endif /* lib/ring.h */
@@ -28,7 +28,29 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Extensions. */
+    SYS_VMSTAT,                 /* Obtain paging statistics. */
+    SYS_MADVISE,                /* Advise on use of a memory range. */
+    SYS_OOM_ADJUST,             /* Set out-of-memory score adjustment. */
+    SYS_READV,                  /* Read from a file into several buffers. */
+    SYS_WRITEV,                 /* Write to a file from several buffers. */
+    SYS_PREAD,                  /* Read from a file at a given offset. */
+    SYS_PWRITE,                 /* Write to a file at a given offset. */
+    SYS_RING_SETUP,             /* Map the system call ring. */
+    SYS_RING_ENTER,             /* Submit and wait for ring entries. */
+    SYS_SBRK,                   /* Grow or shrink the heap. */
+    SYS_PIPE,                   /* Create a pipe. */
+    SYS_DUP2,                   /* Duplicate a file descriptor. */
+    SYS_POLL,                   /* Wait for descriptors to be ready. */
+    SYS_THREAD_CREATE,          /* Start a thread in this process. */
+    SYS_THREAD_EXIT,            /* End the current thread. */
+    SYS_THREAD_JOIN,            /* Wait for a thread to end. */
+    SYS_FUTEX_WAIT,             /* Sleep on a user address. */
+    SYS_FUTEX_WAKE,             /* Wake threads sleeping on an address. */
+    SYS_DUP,                    /* Duplicate a file descriptor. */
+    SYS_FCNTL                   /* Get or set descriptor flags. */
   };
 
 #endif /* lib/syscall-nr.h */
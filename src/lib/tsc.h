@@ -0,0 +1,17 @@
+#ifndef __LIB_TSC_H
+#define __LIB_TSC_H
+
+#include <stdint.h>
+
+/* Returns the CPU's time-stamp counter, which counts cycles
+   since the CPU was reset. */
+static inline uint64_t
+rdtsc (void)
+{
+  /* See [IA32-v2b] "RDTSC". */
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+#endif /* lib/tsc.h */
@@ -0,0 +1,487 @@
+#include <malloc.h>
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+
+/* A heap allocator for user programs.
+
+   The heap is memory obtained from the kernel with sbrk(),
+   divided into blocks.  Each block starts with a header that
+   gives its size and says whether it, and the block just before
+   it, are in use.
+
+   Requests of up to SMALL_MAX bytes are rounded up to a power of
+   2, their "size class", and each class keeps its own list of
+   free blocks.  Small blocks are never split or merged: freeing
+   one pushes it onto its class's list, and the next request for
+   that class pops it off again.  When a class runs out, a slab
+   of SLAB_SIZE bytes is allocated as a large block and divided
+   into blocks of that class.
+
+   Larger requests are served from "bins" of free blocks, one per
+   power-of-2 range of sizes.  The search starts at the bin for
+   the request's size and moves to bigger ones, taking the first
+   block that fits and splitting off what it does not need.  A
+   freed large block is merged with the free blocks on either
+   side of it: the header of the block after a free block holds
+   the free block's size, so its start can be found.  When no
+   free block fits, the heap grows.  When the free block at the
+   top of the heap grows past TRIM_THRESHOLD bytes, most of it
+   is given back to the kernel.
+
+   The end of each region of the heap is marked by a header of
+   size 0 that is always in use, so that blocks never merge past
+   it. */
+
+/* Block header. */
+struct block
+  {
+    size_t prev_size;           /* Size of previous block, if free. */
+    size_t size;                /* Size, with header, plus BLOCK_* flags. */
+  };
+
+/* Flags in a block header's `size'. */
+#define BLOCK_USED 1            /* Block is in use. */
+#define PREV_USED 2             /* Previous block is in use. */
+#define BLOCK_FLAGS (BLOCK_USED | PREV_USED)
+
+/* Free block. */
+struct free_block
+  {
+    struct block hdr;           /* Header. */
+    struct free_block *next;    /* Next block in free list. */
+    struct free_block *prev;    /* Previous block, for large blocks. */
+  };
+
+/* Alignment of blocks, and of the data in them. */
+#define ALIGN 8
+
+/* Size of a block header. */
+#define HDR_SIZE (sizeof (struct block))
+
+/* Small blocks. */
+#define CLASS_CNT 7                     /* Classes of 8 to 512 bytes. */
+#define SMALL_MAX (8 << (CLASS_CNT - 1)) /* Largest small request. */
+#define SLAB_SIZE 4096                  /* Bytes divided at a time. */
+
+/* Large blocks. */
+#define LARGE_MIN (SMALL_MAX + ALIGN + HDR_SIZE) /* Smallest block. */
+#define BIN_CNT 23                      /* Bins up to 2 GB and beyond. */
+
+/* Heap growth and shrinkage. */
+#define HEAP_PAGE 4096                  /* Page size. */
+#define GROW_MIN (8 * HEAP_PAGE)        /* Least growth at a time. */
+#define TRIM_THRESHOLD (32 * HEAP_PAGE) /* Free top size to trim at. */
+
+/* Largest request we try to satisfy. */
+#define SIZE_LIMIT (INTPTR_MAX - 2 * HEAP_PAGE)
+
+static struct free_block *small_free[CLASS_CNT]; /* Free small blocks. */
+static struct free_block *bins[BIN_CNT];         /* Free large blocks. */
+static uint8_t *heap_end;       /* End of the latest heap region. */
+
+static void *small_alloc (size_t);
+static bool small_refill (size_t class);
+static size_t small_class (size_t);
+static void *large_alloc (size_t);
+static void large_free (struct block *);
+static void shrink_block (struct block *, size_t size);
+static size_t block_size (const struct block *);
+static struct block *next_block (struct block *);
+static void mark_used (struct block *);
+static void mark_free (struct block *);
+static struct free_block *bin_find (size_t size);
+static size_t bin_index (size_t size);
+static void bin_insert (struct free_block *);
+static void bin_remove (struct free_block *);
+static bool heap_grow (size_t size);
+static void heap_trim (struct block *);
+
+/* Obtains and returns a new block of at least SIZE bytes.
+   Returns a null pointer if SIZE is zero or if memory is not
+   available. */
+void *
+malloc (size_t size)
+{
+  if (size == 0)
+    return NULL;
+  else if (size <= SMALL_MAX)
+    return small_alloc (size);
+  else
+    return large_alloc (size);
+}
+
+/* Allocates and return A times B bytes initialized to zeroes.
+   Returns a null pointer if memory is not available. */
+void *
+calloc (size_t a, size_t b)
+{
+  size_t size = a * b;
+  void *p;
+
+  if (b != 0 && size / b != a)
+    return NULL;
+  p = malloc (size);
+  if (p != NULL)
+    memset (p, 0, size);
+  return p;
+}
+
+/* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly
+   moving it in the process.
+   If successful, returns the new block; on failure, returns a
+   null pointer.
+   A call with null OLD_BLOCK is equivalent to malloc(NEW_SIZE).
+   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK). */
+void *
+realloc (void *old_block, size_t new_size)
+{
+  struct block *b;
+  size_t old_size;
+  void *new_block;
+
+  if (new_size == 0)
+    {
+      free (old_block);
+      return NULL;
+    }
+  if (old_block == NULL)
+    return malloc (new_size);
+
+  b = (struct block *) old_block - 1;
+  old_size = block_size (b) - HDR_SIZE;
+  if (block_size (b) >= LARGE_MIN
+      && new_size > SMALL_MAX && new_size <= SIZE_LIMIT)
+    {
+      /* Resize a large block in place if it, together with a
+         free block after it, is big enough. */
+      size_t size = ROUND_UP (new_size, ALIGN) + HDR_SIZE;
+      struct block *next = next_block (b);
+
+      if (size > block_size (b) && !(next->size & BLOCK_USED)
+          && block_size (b) + block_size (next) >= size)
+        {
+          bin_remove ((struct free_block *) next);
+          b->size += block_size (next);
+          next_block (b)->size |= PREV_USED;
+        }
+      if (size <= block_size (b))
+        {
+          shrink_block (b, size);
+          return old_block;
+        }
+    }
+  else if (new_size <= old_size)
+    return old_block;
+
+  new_block = malloc (new_size);
+  if (new_block != NULL)
+    {
+      memcpy (new_block, old_block,
+              old_size < new_size ? old_size : new_size);
+      free (old_block);
+    }
+  return new_block;
+}
+
+/* Frees block P, which must have been previously allocated with
+   malloc(), calloc(), or realloc(). */
+void
+free (void *p)
+{
+  struct block *b;
+
+  if (p == NULL)
+    return;
+
+  b = (struct block *) p - 1;
+  ASSERT (b->size & BLOCK_USED);
+  if (block_size (b) < LARGE_MIN)
+    {
+      struct free_block *fb = (struct free_block *) b;
+      size_t class = small_class (block_size (b) - HDR_SIZE);
+
+      b->size &= ~BLOCK_USED;
+      fb->next = small_free[class];
+      small_free[class] = fb;
+    }
+  else
+    large_free (b);
+}
+
+/* Small blocks. */
+
+/* Allocates a small block of at least SIZE bytes, which must be
+   between 1 and SMALL_MAX. */
+static void *
+small_alloc (size_t size)
+{
+  size_t class = small_class (size);
+  struct free_block *fb;
+
+  if (small_free[class] == NULL && !small_refill (class))
+    return NULL;
+  fb = small_free[class];
+  small_free[class] = fb->next;
+  fb->hdr.size |= BLOCK_USED;
+  return &fb->hdr + 1;
+}
+
+/* Divides a new slab into free blocks of size class CLASS.
+   Returns false if memory is not available. */
+static bool
+small_refill (size_t class)
+{
+  size_t size = (8 << class) + HDR_SIZE;
+  uint8_t *slab = large_alloc (SLAB_SIZE);
+  size_t ofs;
+
+  if (slab == NULL)
+    return false;
+
+  /* Push the blocks in reverse, so that they are handed out in
+     address order. */
+  for (ofs = SLAB_SIZE / size * size; ofs >= size; ofs -= size)
+    {
+      struct free_block *fb = (struct free_block *) (slab + ofs - size);
+      fb->hdr.size = size;
+      fb->next = small_free[class];
+      small_free[class] = fb;
+    }
+  return true;
+}
+
+/* Returns the size class for a request of SIZE bytes. */
+static size_t
+small_class (size_t size)
+{
+  size_t class = 0;
+
+  ASSERT (size > 0 && size <= SMALL_MAX);
+  while ((size_t) (8 << class) < size)
+    class++;
+  return class;
+}
+
+/* Large blocks. */
+
+/* Allocates a large block of at least SIZE bytes. */
+static void *
+large_alloc (size_t size)
+{
+  struct free_block *fb;
+
+  if (size > SIZE_LIMIT)
+    return NULL;
+  size = ROUND_UP (size, ALIGN) + HDR_SIZE;
+
+  fb = bin_find (size);
+  if (fb == NULL)
+    {
+      if (!heap_grow (size))
+        return NULL;
+      fb = bin_find (size);
+      ASSERT (fb != NULL);
+    }
+  bin_remove (fb);
+  mark_used (&fb->hdr);
+  shrink_block (&fb->hdr, size);
+  return &fb->hdr + 1;
+}
+
+/* Frees large block B, merging it with free neighbors. */
+static void
+large_free (struct block *b)
+{
+  struct block *next = next_block (b);
+
+  if (!(next->size & BLOCK_USED))
+    {
+      bin_remove ((struct free_block *) next);
+      b->size += block_size (next);
+    }
+  if (!(b->size & PREV_USED))
+    {
+      struct block *prev = (struct block *) ((uint8_t *) b - b->prev_size);
+      bin_remove ((struct free_block *) prev);
+      prev->size += block_size (b);
+      b = prev;
+    }
+  mark_free (b);
+  heap_trim (b);
+  bin_insert ((struct free_block *) b);
+}
+
+/* Cuts in-use large block B down to SIZE bytes, freeing the rest
+   as a block of its own, if the rest is big enough to be a large
+   block. */
+static void
+shrink_block (struct block *b, size_t size)
+{
+  size_t rest = block_size (b) - size;
+
+  if (rest >= LARGE_MIN)
+    {
+      struct block *r = (struct block *) ((uint8_t *) b + size);
+      b->size -= rest;
+      r->size = rest | BLOCK_USED | PREV_USED;
+      large_free (r);
+    }
+}
+
+/* Returns the size of block B, including its header. */
+static size_t
+block_size (const struct block *b)
+{
+  return b->size & ~BLOCK_FLAGS;
+}
+
+/* Returns the block following large block B. */
+static struct block *
+next_block (struct block *b)
+{
+  return (struct block *) ((uint8_t *) b + block_size (b));
+}
+
+/* Marks large block B as in use. */
+static void
+mark_used (struct block *b)
+{
+  b->size |= BLOCK_USED;
+  next_block (b)->size |= PREV_USED;
+}
+
+/* Marks large block B as free. */
+static void
+mark_free (struct block *b)
+{
+  struct block *next = next_block (b);
+
+  b->size &= ~BLOCK_USED;
+  next->size &= ~PREV_USED;
+  next->prev_size = block_size (b);
+}
+
+/* Returns a free large block of at least SIZE bytes, or a null
+   pointer if there is none. */
+static struct free_block *
+bin_find (size_t size)
+{
+  size_t bin;
+
+  for (bin = bin_index (size); bin < BIN_CNT; bin++)
+    {
+      struct free_block *fb;
+
+      for (fb = bins[bin]; fb != NULL; fb = fb->next)
+        if (block_size (&fb->hdr) >= size)
+          return fb;
+    }
+  return NULL;
+}
+
+/* Returns the bin for large blocks of SIZE bytes.  Bin 0 holds
+   blocks smaller than 1 kB, bin 1 blocks of 1 kB to 2 kB, and so
+   on. */
+static size_t
+bin_index (size_t size)
+{
+  size_t bin = 0;
+
+  for (size >>= 10; size > 0 && bin < BIN_CNT - 1; size >>= 1)
+    bin++;
+  return bin;
+}
+
+/* Adds free large block FB to its bin. */
+static void
+bin_insert (struct free_block *fb)
+{
+  struct free_block **head = &bins[bin_index (block_size (&fb->hdr))];
+
+  fb->prev = NULL;
+  fb->next = *head;
+  if (*head != NULL)
+    (*head)->prev = fb;
+  *head = fb;
+}
+
+/* Removes free large block FB from its bin. */
+static void
+bin_remove (struct free_block *fb)
+{
+  if (fb->prev != NULL)
+    fb->prev->next = fb->next;
+  else
+    bins[bin_index (block_size (&fb->hdr))] = fb->next;
+  if (fb->next != NULL)
+    fb->next->prev = fb->prev;
+}
+
+/* Heap growth and shrinkage. */
+
+/* Grows the heap to add a free large block of at least SIZE
+   bytes.  Returns false if the kernel will not grow the heap. */
+static bool
+heap_grow (size_t size)
+{
+  size_t amount = ROUND_UP (size + HDR_SIZE + ALIGN, HEAP_PAGE);
+  uint8_t *start;
+  struct block *b, *end;
+
+  if (amount < GROW_MIN)
+    amount = GROW_MIN;
+  start = sbrk (amount);
+  if (start == (void *) -1)
+    return false;
+
+  if (start == heap_end)
+    {
+      /* The new memory follows the heap: the old end marker
+         becomes the new block's header. */
+      b = (struct block *) (heap_end - HDR_SIZE);
+      b->size = amount | (b->size & PREV_USED) | BLOCK_USED;
+    }
+  else
+    {
+      /* Someone else moved the break, or this is the first
+         growth: start a new region. */
+      b = (struct block *) ROUND_UP ((uintptr_t) start, ALIGN);
+      b->size = (ROUND_DOWN (start + amount - HDR_SIZE - (uint8_t *) b,
+                             ALIGN)
+                 | BLOCK_USED | PREV_USED);
+    }
+  end = next_block (b);
+  end->size = BLOCK_USED | PREV_USED;
+  heap_end = (uint8_t *) (end + 1);
+
+  large_free (b);
+  return true;
+}
+
+/* Gives most of free large block B back to the kernel if it is
+   at the top of the heap and at least TRIM_THRESHOLD bytes
+   long.  B must not be in a bin. */
+static void
+heap_trim (struct block *b)
+{
+  struct block *end = next_block (b);
+
+  if ((uint8_t *) (end + 1) == heap_end
+      && block_size (b) >= TRIM_THRESHOLD
+      && sbrk (0) == heap_end)
+    {
+      size_t release = ROUND_DOWN (block_size (b) - GROW_MIN, HEAP_PAGE);
+
+      if (sbrk (-(intptr_t) release) != (void *) -1)
+        {
+          b->size -= release;
+          heap_end -= release;
+          end = next_block (b);
+          end->prev_size = block_size (b);
+          end->size = BLOCK_USED;
+        }
+    }
+}
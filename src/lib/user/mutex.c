@@ -0,0 +1,61 @@
+#include <mutex.h>
+#include <syscall.h>
+
+/* Mutexes.
+
+   A mutex is a futex that is 0 while unlocked, 1 while locked,
+   and 2 while locked with threads that may be waiting for it.
+   Locking and unlocking an uncontended mutex take one atomic
+   instruction each and no system call.  A thread that finds the
+   mutex locked sets it to 2 and sleeps in futex_wait() until it
+   manages to take it, and unlocking a mutex that was 2 wakes
+   one sleeper with futex_wake(). */
+
+/* Initializes M as unlocked. */
+void
+mutex_init (struct mutex *m) 
+{
+  m->state = 0;
+}
+
+/* Locks M, waiting until it is unlocked if necessary. */
+void
+mutex_lock (struct mutex *m) 
+{
+  int c = __sync_val_compare_and_swap (&m->state, 0, 1);
+
+  if (c != 0)
+    {
+      /* Contended.  Mark M as having waiters, and sleep until we
+         find it unlocked while doing so.  Once we have waited,
+         we cannot know whether others still are, so we leave M
+         marked when we take it. */
+      if (c != 2)
+        c = __sync_lock_test_and_set (&m->state, 2);
+      while (c != 0)
+        {
+          futex_wait (&m->state, 2);
+          c = __sync_lock_test_and_set (&m->state, 2);
+        }
+    }
+}
+
+/* Locks M if it is unlocked, without waiting.  Returns true if
+   successful, false if M was locked. */
+bool
+mutex_trylock (struct mutex *m) 
+{
+  return __sync_val_compare_and_swap (&m->state, 0, 1) == 0;
+}
+
+/* Unlocks M, which the running thread must have locked, and
+   wakes a thread waiting for it, if any may be. */
+void
+mutex_unlock (struct mutex *m) 
+{
+  if (__sync_fetch_and_sub (&m->state, 1) != 1)
+    {
+      __sync_lock_release (&m->state);
+      futex_wake (&m->state, 1);
+    }
+}
@@ -4,4 +4,48 @@
 int hprintf (int, const char *, ...) PRINTF_FORMAT (2, 3);
 int vhprintf (int, const char *, va_list) PRINTF_FORMAT (2, 0);
 
+/* Buffered streams. */
+typedef struct stream FILE;
+
+/* Returned by character input functions at end of file or on
+   error. */
+#define EOF (-1)
+
+/* Size of a stream's buffer. */
+#define BUFSIZ 512
+
+/* Most streams open at once, counting stdin and stdout. */
+#define FOPEN_MAX 8
+
+/* Buffering modes. */
+#define _IOFBF 0                /* Full buffering. */
+#define _IOLBF 1                /* Line buffering. */
+#define _IONBF 2                /* No buffering. */
+
+extern FILE *stdin;
+extern FILE *stdout;
+
+FILE *fopen (const char *file, const char *mode);
+FILE *fdopen (int fd, const char *mode);
+int fclose (FILE *);
+int fflush (FILE *);
+int setvbuf (FILE *, char *buf, int mode, size_t size);
+int fileno (FILE *);
+int feof (FILE *);
+int ferror (FILE *);
+
+int fgetc (FILE *);
+int getchar (void);
+char *fgets (char *, int size, FILE *);
+size_t fread (void *, size_t size, size_t cnt, FILE *);
+
+int fputc (int, FILE *);
+int fputs (const char *, FILE *);
+size_t fwrite (const void *, size_t size, size_t cnt, FILE *);
+int fprintf (FILE *, const char *, ...) PRINTF_FORMAT (2, 3);
+int vfprintf (FILE *, const char *, va_list) PRINTF_FORMAT (2, 0);
+
+#define getc(STREAM) fgetc (STREAM)
+#define putc(C, STREAM) fputc (C, STREAM)
+
 #endif /* lib/user/stdio.h */
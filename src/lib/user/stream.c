@@ -0,0 +1,490 @@
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+
+/* Buffered streams.
+
+   Each stream buffers the data moving between the program and
+   its file, so that a program that reads or writes a character
+   at a time makes a system call only once per buffer, or once
+   per line for a line-buffered stream.
+
+   A stream is either reading, with BUF holding data read from
+   the file ahead of the program, or writing, with BUF holding
+   data that the program has written but that has not yet gone
+   to the file, or idle, with BUF empty.  Switching from reading
+   to writing seeks back over the data read ahead.
+
+   stdout is line buffered.  stdin is unbuffered, because a read
+   from the console waits until every byte asked for has been
+   typed.  Streams opened on files are fully buffered.  Every
+   stream is flushed when the program calls exit(). */
+
+/* What a stream is doing. */
+enum stream_state
+  {
+    IDLE,                       /* BUF is empty. */
+    READING,                    /* BUF holds data read ahead. */
+    WRITING                     /* BUF holds data not yet written. */
+  };
+
+/* A stream. */
+struct stream
+  {
+    bool in_use;                /* Open? */
+    int fd;                     /* File descriptor. */
+    bool readable;              /* Opened for reading? */
+    bool writable;              /* Opened for writing? */
+    int mode;                   /* _IOFBF, _IOLBF, or _IONBF. */
+    enum stream_state state;    /* What BUF holds. */
+    bool eof;                   /* End of file reached? */
+    bool error;                 /* Error occurred? */
+    char *buf;                  /* Buffer. */
+    size_t size;                /* Size of BUF. */
+    size_t pos;                 /* Next byte of BUF to read or write. */
+    size_t end;                 /* End of data in BUF, if reading. */
+  };
+
+static char buffers[FOPEN_MAX][BUFSIZ];
+
+static struct stream streams[FOPEN_MAX] =
+  {
+    {true, STDIN_FILENO, true, false, _IONBF, IDLE, false, false,
+     buffers[0], BUFSIZ, 0, 0},
+    {true, STDOUT_FILENO, false, true, _IOLBF, IDLE, false, false,
+     buffers[1], BUFSIZ, 0, 0},
+  };
+
+FILE *stdin = &streams[0];
+FILE *stdout = &streams[1];
+
+static bool parse_mode (const char *mode, bool *readable, bool *writable,
+                        bool *append);
+static bool begin_read (FILE *);
+static bool begin_write (FILE *);
+static bool fill (FILE *);
+static bool flush_output (FILE *);
+static void drop_input (FILE *);
+static bool write_all (FILE *, const char *, size_t);
+
+/* Opens FILE, which must exist, and returns a stream for it, or
+   a null pointer on failure.  MODE is "r" to read, "w" to write,
+   "a" to write at the end, or any of these followed by "+" to
+   both read and write.  Since files have a fixed size, "w"
+   neither creates nor truncates FILE. */
+FILE *
+fopen (const char *file, const char *mode)
+{
+  bool readable, writable, append;
+  FILE *s;
+  int fd;
+
+  if (!parse_mode (mode, &readable, &writable, &append))
+    return NULL;
+  fd = open (file);
+  if (fd < 0)
+    return NULL;
+  if (append)
+    seek (fd, filesize (fd));
+
+  s = fdopen (fd, mode);
+  if (s == NULL)
+    close (fd);
+  return s;
+}
+
+/* Returns a stream for file descriptor FD, which is used as
+   described for fopen(), or a null pointer if MODE is invalid or
+   too many streams are open. */
+FILE *
+fdopen (int fd, const char *mode)
+{
+  bool readable, writable, append;
+  size_t i;
+
+  if (!parse_mode (mode, &readable, &writable, &append))
+    return NULL;
+  for (i = 0; i < FOPEN_MAX; i++)
+    {
+      FILE *s = &streams[i];
+      if (!s->in_use)
+        {
+          s->in_use = true;
+          s->fd = fd;
+          s->readable = readable;
+          s->writable = writable;
+          s->mode = _IOFBF;
+          s->state = IDLE;
+          s->eof = s->error = false;
+          s->buf = buffers[i];
+          s->size = BUFSIZ;
+          s->pos = s->end = 0;
+          return s;
+        }
+    }
+  return NULL;
+}
+
+/* Flushes and closes stream S, and closes its file.  Returns 0
+   if successful, EOF if flushing failed. */
+int
+fclose (FILE *s)
+{
+  int retval = fflush (s);
+  close (s->fd);
+  s->in_use = false;
+  return retval;
+}
+
+/* Writes out the data buffered for writing to S, or drops the
+   data read ahead by S, or does so for every open stream if S is
+   null.  Returns 0 if successful, EOF if a write failed. */
+int
+fflush (FILE *s)
+{
+  int retval = 0;
+
+  if (s == NULL)
+    {
+      size_t i;
+
+      for (i = 0; i < FOPEN_MAX; i++)
+        if (streams[i].in_use && fflush (&streams[i]) == EOF)
+          retval = EOF;
+      return retval;
+    }
+
+  if (s->state == WRITING)
+    {
+      if (!flush_output (s))
+        retval = EOF;
+    }
+  else if (s->state == READING)
+    drop_input (s);
+  return retval;
+}
+
+/* Sets S's buffering MODE to _IOFBF, _IOLBF, or _IONBF.  S then
+   uses the SIZE bytes at BUF as its buffer, unless BUF is null.
+   Must be called before any other operation on S.  Returns 0 if
+   successful, nonzero otherwise. */
+int
+setvbuf (FILE *s, char *buf, int mode, size_t size)
+{
+  if (s->state != IDLE || (mode != _IOFBF && mode != _IOLBF
+                           && mode != _IONBF))
+    return -1;
+  s->mode = mode;
+  if (buf != NULL && size > 0)
+    {
+      s->buf = buf;
+      s->size = size;
+    }
+  return 0;
+}
+
+/* Returns S's file descriptor. */
+int
+fileno (FILE *s)
+{
+  return s->fd;
+}
+
+/* Returns nonzero if S has reached end of file. */
+int
+feof (FILE *s)
+{
+  return s->eof;
+}
+
+/* Returns nonzero if an operation on S has failed. */
+int
+ferror (FILE *s)
+{
+  return s->error;
+}
+
+/* Reads and returns one character from S, or EOF at end of file
+   or on error. */
+int
+fgetc (FILE *s)
+{
+  if (!begin_read (s) || (s->pos >= s->end && !fill (s)))
+    return EOF;
+  return (unsigned char) s->buf[s->pos++];
+}
+
+/* Reads and returns one character from stdin, or EOF. */
+int
+getchar (void)
+{
+  return fgetc (stdin);
+}
+
+/* Reads a line from S into the SIZE bytes at DST, including its
+   new-line character if it fits, and null-terminates it.
+   Returns DST, or a null pointer if end of file or an error
+   came before any character was read. */
+char *
+fgets (char *dst, int size, FILE *s)
+{
+  int i;
+
+  if (size <= 0)
+    return NULL;
+  for (i = 0; i < size - 1; )
+    {
+      int c = fgetc (s);
+      if (c == EOF)
+        break;
+      dst[i++] = c;
+      if (c == '\n')
+        break;
+    }
+  if (i == 0 && size > 1)
+    return NULL;
+  dst[i] = '\0';
+  return dst;
+}
+
+/* Reads up to CNT elements of SIZE bytes each from S into BUF.
+   Returns the number of whole elements read. */
+size_t
+fread (void *buf_, size_t size, size_t cnt, FILE *s)
+{
+  char *buf = buf_;
+  size_t total = size * cnt;
+  size_t done = 0;
+
+  if (total == 0 || !begin_read (s))
+    return 0;
+  while (done < total)
+    {
+      size_t chunk;
+
+      if (s->pos >= s->end)
+        {
+          /* Read large requests straight into BUF. */
+          if (total - done >= s->size)
+            {
+              int n = read (s->fd, buf + done, total - done);
+              if (n <= 0)
+                {
+                  if (n < 0)
+                    s->error = true;
+                  else
+                    s->eof = true;
+                  break;
+                }
+              done += n;
+              continue;
+            }
+          if (!fill (s))
+            break;
+        }
+
+      chunk = s->end - s->pos;
+      if (chunk > total - done)
+        chunk = total - done;
+      memcpy (buf + done, s->buf + s->pos, chunk);
+      s->pos += chunk;
+      done += chunk;
+    }
+  return done / size;
+}
+
+/* Writes C to S.  Returns C, or EOF on error. */
+int
+fputc (int c, FILE *s)
+{
+  if (!begin_write (s))
+    return EOF;
+  s->buf[s->pos++] = c;
+  if (s->pos >= s->size
+      || s->mode == _IONBF
+      || (s->mode == _IOLBF && c == '\n'))
+    {
+      if (!flush_output (s))
+        return EOF;
+    }
+  return (unsigned char) c;
+}
+
+/* Writes string STR to S, without a new-line.  Returns a
+   nonnegative value if successful, EOF on error. */
+int
+fputs (const char *str, FILE *s)
+{
+  size_t length = strlen (str);
+  return length == 0 || fwrite (str, length, 1, s) == 1 ? 0 : EOF;
+}
+
+/* Writes CNT elements of SIZE bytes each from BUF to S.
+   Returns the number of elements written. */
+size_t
+fwrite (const void *buf_, size_t size, size_t cnt, FILE *s)
+{
+  const char *buf = buf_;
+  size_t total = size * cnt;
+  size_t i;
+
+  if (total == 0 || !begin_write (s))
+    return 0;
+
+  /* Write large requests straight from BUF. */
+  if (total >= s->size)
+    return flush_output (s) && write_all (s, buf, total) ? cnt : 0;
+
+  for (i = 0; i < total; i++)
+    if (fputc (buf[i], s) == EOF)
+      return i / size;
+  return cnt;
+}
+
+/* Auxiliary data for vfprintf_helper(). */
+struct vfprintf_aux
+  {
+    FILE *stream;               /* Output stream. */
+    int char_cnt;               /* Characters written so far. */
+  };
+
+/* Writes C to the stream in AUX. */
+static void
+vfprintf_helper (char c, void *aux_)
+{
+  struct vfprintf_aux *aux = aux_;
+  fputc (c, aux->stream);
+  aux->char_cnt++;
+}
+
+/* Formats the printf() format specification FORMAT with
+   arguments given in ARGS and writes the output to S.  Returns
+   the number of characters written. */
+int
+vfprintf (FILE *s, const char *format, va_list args)
+{
+  struct vfprintf_aux aux;
+
+  aux.stream = s;
+  aux.char_cnt = 0;
+  __vprintf (format, args, vfprintf_helper, &aux);
+  return aux.char_cnt;
+}
+
+/* Like printf(), but writes output to S. */
+int
+fprintf (FILE *s, const char *format, ...)
+{
+  va_list args;
+  int retval;
+
+  va_start (args, format);
+  retval = vfprintf (s, format, args);
+  va_end (args);
+
+  return retval;
+}
+
+/* Parses fopen() mode string MODE into *READABLE, *WRITABLE,
+   and *APPEND.  Returns false if MODE is invalid. */
+static bool
+parse_mode (const char *mode, bool *readable, bool *writable, bool *append)
+{
+  *readable = *mode == 'r';
+  *writable = *mode == 'w' || *mode == 'a';
+  *append = *mode == 'a';
+  if (!*readable && !*writable)
+    return false;
+  if (strchr (mode + 1, '+') != NULL)
+    *readable = *writable = true;
+  return true;
+}
+
+/* Prepares S for reading.  Returns false if S cannot be read. */
+static bool
+begin_read (FILE *s)
+{
+  if (!s->readable)
+    {
+      s->error = true;
+      return false;
+    }
+  if (s->state == WRITING && !flush_output (s))
+    return false;
+  s->state = READING;
+  return true;
+}
+
+/* Prepares S for writing.  Returns false if S cannot be
+   written. */
+static bool
+begin_write (FILE *s)
+{
+  if (!s->writable)
+    {
+      s->error = true;
+      return false;
+    }
+  if (s->state == READING)
+    drop_input (s);
+  s->state = WRITING;
+  return true;
+}
+
+/* Refills S's buffer, which must be empty, from its file.
+   Returns false at end of file or on error. */
+static bool
+fill (FILE *s)
+{
+  int n = read (s->fd, s->buf, s->mode == _IONBF ? 1 : s->size);
+
+  s->pos = 0;
+  s->end = n > 0 ? n : 0;
+  if (n == 0)
+    s->eof = true;
+  else if (n < 0)
+    s->error = true;
+  return n > 0;
+}
+
+/* Writes out the data in S's buffer and leaves S idle.  Returns
+   false if the data could not all be written. */
+static bool
+flush_output (FILE *s)
+{
+  bool success = write_all (s, s->buf, s->pos);
+  s->pos = 0;
+  s->state = IDLE;
+  return success;
+}
+
+/* Drops the data that S has read ahead, moving its file's
+   position back to where the program has read up to, and
+   leaves S idle. */
+static void
+drop_input (FILE *s)
+{
+  if (s->end > s->pos && s->fd != STDIN_FILENO)
+    seek (s->fd, tell (s->fd) - (s->end - s->pos));
+  s->pos = s->end = 0;
+  s->state = IDLE;
+}
+
+/* Writes the SIZE bytes in BUF to S's file.  Returns true if
+   successful, false on error. */
+static bool
+write_all (FILE *s, const char *buf, size_t size)
+{
+  while (size > 0)
+    {
+      int n = write (s->fd, buf, size);
+      if (n <= 0)
+        {
+          s->error = true;
+          return false;
+        }
+      buf += n;
+      size -= n;
+    }
+  return true;
+}
@@ -1,31 +1,60 @@
 #include <syscall.h>
+#include <cpuid.h>
+#include <stdio.h>
 #include "../syscall-nr.h"
 
+/* A system call pushes its arguments and number on the stack and
+   enters the kernel with "sysenter", if the CPU supports it, or
+   "int $0x30", which is much slower, if not.  "sysenter" saves
+   nothing for the return, so the stack pointer is passed in %ecx
+   and the return address in %edx, which the call clobbers. */
+
+static bool use_sysenter (void);
+static void thread_start (thread_func *, void *aux) NO_RETURN;
+
+/* Pushes the operands in PUSHES, which are described by the asm
+   input operands in the remaining arguments, enters the kernel,
+   pops POP_BYTES bytes off the stack, and stores the system
+   call's return value into RETVAL. */
+#define syscall_asm(RETVAL, PUSHES, POP_BYTES, ...)                     \
+        do                                                              \
+          {                                                             \
+            if (use_sysenter ())                                        \
+              asm volatile                                              \
+                (PUSHES "movl %%esp, %%ecx; movl $1f, %%edx; "          \
+                 "sysenter; 1: addl $" #POP_BYTES ", %%esp"             \
+                   : "=a" (RETVAL)                                      \
+                   : __VA_ARGS__                                        \
+                   : "ecx", "edx", "memory");                           \
+            else                                                        \
+              asm volatile                                              \
+                (PUSHES "int $0x30; addl $" #POP_BYTES ", %%esp"        \
+                   : "=a" (RETVAL)                                      \
+                   : __VA_ARGS__                                        \
+                   : "memory");                                         \
+          }                                                             \
+        while (0)
+
 /* Invokes syscall NUMBER, passing no arguments, and returns the
    return value as an `int'. */
 #define syscall0(NUMBER)                                        \
         ({                                                      \
           int retval;                                           \
-          asm volatile                                          \
-            ("pushl %[number]; int $0x30; addl $4, %%esp"       \
-               : "=a" (retval)                                  \
-               : [number] "i" (NUMBER)                          \
-               : "memory");                                     \
+          syscall_asm (retval, "pushl %[number]; ", 4,          \
+                       [number] "i" (NUMBER));                  \
           retval;                                               \
         })
 
 /* Invokes syscall NUMBER, passing argument ARG0, and returns the
    return value as an `int'. */
-#define syscall1(NUMBER, ARG0)                                           \
-        ({                                                               \
-          int retval;                                                    \
-          asm volatile                                                   \
-            ("pushl %[arg0]; pushl %[number]; int $0x30; addl $8, %%esp" \
-               : "=a" (retval)                                           \
-               : [number] "i" (NUMBER),                                  \
-                 [arg0] "g" (ARG0)                                       \
-               : "memory");                                              \
-          retval;                                                        \
+#define syscall1(NUMBER, ARG0)                                  \
+        ({                                                      \
+          int retval;                                           \
+          syscall_asm (retval,                                  \
+                       "pushl %[arg0]; pushl %[number]; ", 8,   \
+                       [number] "i" (NUMBER),                   \
+                       [arg0] "g" (ARG0));                      \
+          retval;                                               \
         })
 
 /* Invokes syscall NUMBER, passing arguments ARG0 and ARG1, and
@@ -33,14 +62,12 @@
 #define syscall2(NUMBER, ARG0, ARG1)                            \
         ({                                                      \
           int retval;                                           \
-          asm volatile                                          \
-            ("pushl %[arg1]; pushl %[arg0]; "                   \
-             "pushl %[number]; int $0x30; addl $12, %%esp"      \
-               : "=a" (retval)                                  \
-               : [number] "i" (NUMBER),                         \
-                 [arg0] "r" (ARG0),                             \
-                 [arg1] "r" (ARG1)                              \
-               : "memory");                                     \
+          syscall_asm (retval,                                  \
+                       "pushl %[arg1]; pushl %[arg0]; "         \
+                       "pushl %[number]; ", 12,                 \
+                       [number] "i" (NUMBER),                   \
+                       [arg0] "r" (ARG0),                       \
+                       [arg1] "r" (ARG1));                      \
           retval;                                               \
         })
 
@@ -49,18 +76,48 @@
 #define syscall3(NUMBER, ARG0, ARG1, ARG2)                      \
         ({                                                      \
           int retval;                                           \
-          asm volatile                                          \
-            ("pushl %[arg2]; pushl %[arg1]; pushl %[arg0]; "    \
-             "pushl %[number]; int $0x30; addl $16, %%esp"      \
-               : "=a" (retval)                                  \
-               : [number] "i" (NUMBER),                         \
-                 [arg0] "r" (ARG0),                             \
-                 [arg1] "r" (ARG1),                             \
-                 [arg2] "r" (ARG2)                              \
-               : "memory");                                     \
+          syscall_asm (retval,                                  \
+                       "pushl %[arg2]; pushl %[arg1]; "         \
+                       "pushl %[arg0]; pushl %[number]; ", 16,  \
+                       [number] "i" (NUMBER),                   \
+                       [arg0] "r" (ARG0),                       \
+                       [arg1] "r" (ARG1),                       \
+                       [arg2] "r" (ARG2));                      \
           retval;                                               \
         })
 
+/* Invokes syscall NUMBER, passing arguments ARG0, ARG1, ARG2,
+   and ARG3, and returns the return value as an `int'.  ARG3 is
+   pushed first, so it may be in memory, even relative to %esp,
+   which frees a register for the others. */
+#define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3)                \
+        ({                                                      \
+          int retval;                                           \
+          syscall_asm (retval,                                  \
+                       "pushl %[arg3]; pushl %[arg2]; "         \
+                       "pushl %[arg1]; pushl %[arg0]; "         \
+                       "pushl %[number]; ", 20,                 \
+                       [number] "i" (NUMBER),                   \
+                       [arg0] "r" (ARG0),                       \
+                       [arg1] "r" (ARG1),                       \
+                       [arg2] "r" (ARG2),                       \
+                       [arg3] "g" (ARG3));                      \
+          retval;                                               \
+        })
+
+/* Returns true if system calls should use "sysenter".  The
+   kernel enables it under the same conditions. */
+static bool
+use_sysenter (void)
+{
+  /* 0 if not yet known, 1 if not, 2 if so. */
+  static int state;
+
+  if (state == 0)
+    state = cpuid_has_sysenter () ? 2 : 1;
+  return state == 2;
+}
+
 void
 halt (void) 
 {
@@ -71,6 +128,7 @@ halt (void)
 void
 exit (int status)
 {
+  fflush (NULL);
   syscall1 (SYS_EXIT, status);
   NOT_REACHED ();
 }
@@ -182,3 +240,131 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+bool
+vmstat (struct vmstat *vs) 
+{
+  return syscall1 (SYS_VMSTAT, vs);
+}
+
+int
+madvise (void *addr, size_t length, int advice) 
+{
+  return syscall3 (SYS_MADVISE, addr, length, advice);
+}
+
+int
+oom_adjust (int adj) 
+{
+  return syscall1 (SYS_OOM_ADJUST, adj);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iovcnt) 
+{
+  return syscall3 (SYS_READV, fd, iov, iovcnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iovcnt) 
+{
+  return syscall3 (SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int
+pread (int fd, void *buffer, unsigned size, unsigned offset) 
+{
+  return syscall4 (SYS_PREAD, fd, buffer, size, offset);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned size, unsigned offset) 
+{
+  return syscall4 (SYS_PWRITE, fd, buffer, size, offset);
+}
+
+struct ring *
+ring_setup (void) 
+{
+  return (struct ring *) syscall0 (SYS_RING_SETUP);
+}
+
+int
+ring_enter (unsigned to_submit, unsigned min_complete) 
+{
+  return syscall2 (SYS_RING_ENTER, to_submit, min_complete);
+}
+
+void *
+sbrk (intptr_t increment) 
+{
+  return (void *) syscall1 (SYS_SBRK, increment);
+}
+
+bool
+pipe (int fds[2]) 
+{
+  return syscall1 (SYS_PIPE, fds);
+}
+
+int
+dup (int fd) 
+{
+  return syscall1 (SYS_DUP, fd);
+}
+
+int
+dup2 (int old_fd, int new_fd) 
+{
+  return syscall2 (SYS_DUP2, old_fd, new_fd);
+}
+
+int
+fcntl (int fd, int cmd, int arg) 
+{
+  return syscall3 (SYS_FCNTL, fd, cmd, arg);
+}
+
+int
+poll (struct pollfd *fds, unsigned nfds, int timeout) 
+{
+  return syscall3 (SYS_POLL, fds, nfds, timeout);
+}
+
+tid_t
+thread_create (thread_func *func, void *aux) 
+{
+  return syscall3 (SYS_THREAD_CREATE, thread_start, func, aux);
+}
+
+/* Where a thread started by thread_create() begins. */
+static void
+thread_start (thread_func *func, void *aux) 
+{
+  thread_exit (func (aux));
+}
+
+void
+thread_exit (int status) 
+{
+  syscall1 (SYS_THREAD_EXIT, status);
+  NOT_REACHED ();
+}
+
+int
+thread_join (tid_t tid) 
+{
+  return syscall1 (SYS_THREAD_JOIN, tid);
+}
+
+int
+futex_wait (int *addr, int val) 
+{
+  return syscall2 (SYS_FUTEX_WAIT, addr, val);
+}
+
+int
+futex_wake (int *addr, int cnt) 
+{
+  return syscall2 (SYS_FUTEX_WAKE, addr, cnt);
+}
@@ -3,11 +3,27 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <madvise.h>
+#include <oom.h>
+#include <poll.h>
+#include <ring.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <uio.h>
+#include <vmstat.h>
 
 /* Process identifier. */
 typedef int pid_t;
 #define PID_ERROR ((pid_t) -1)
 
+/* Thread identifier. */
+typedef int tid_t;
+#define TID_ERROR ((tid_t) -1)
+
+/* A function run by a thread started with thread_create().  Its
+   return value becomes the thread's exit status. */
+typedef int thread_func (void *aux);
+
 /* Map region identifier. */
 typedef int mapid_t;
 #define MAP_FAILED ((mapid_t) -1)
@@ -45,4 +61,32 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Extensions. */
+bool vmstat (struct vmstat *);
+int madvise (void *addr, size_t length, int advice);
+int oom_adjust (int adj);
+int readv (int fd, const struct iovec *, int iovcnt);
+int writev (int fd, const struct iovec *, int iovcnt);
+int pread (int fd, void *buffer, unsigned length, unsigned offset);
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset);
+struct ring *ring_setup (void);
+int ring_enter (unsigned to_submit, unsigned min_complete);
+void *sbrk (intptr_t increment);
+bool pipe (int fds[2]);
+int dup (int fd);
+int dup2 (int old_fd, int new_fd);
+int fcntl (int fd, int cmd, int arg);
+int poll (struct pollfd *, unsigned nfds, int timeout);
+tid_t thread_create (thread_func *, void *aux);
+void thread_exit (int status) NO_RETURN;
+int thread_join (tid_t);
+int futex_wait (int *addr, int val);
+int futex_wake (int *addr, int cnt);
+
+/* Answered from the kernel data page, without a system call. */
+pid_t getpid (void);
+int64_t get_ticks (void);
+uint64_t get_time_ns (void);
+uint64_t get_tsc_freq (void);
+
 #endif /* lib/user/syscall.h */
@@ -0,0 +1,74 @@
+#include <syscall.h>
+#include <tsc.h>
+#include <vdata.h>
+
+/* The kernel data page, which the kernel updates under our
+   feet. */
+static const volatile struct vdata *const vdata = VDATA_ADDR;
+
+/* Copies a consistent snapshot of the kernel data page into
+   *VD. */
+static void
+read_vdata (struct vdata *vd)
+{
+  uint32_t seq;
+
+  do
+    {
+      seq = vdata->seq;
+      asm volatile ("" : : : "memory");
+      *vd = *vdata;
+      asm volatile ("" : : : "memory");
+    }
+  while ((seq & 1) != 0 || vdata->seq != seq);
+}
+
+/* Returns the process ID of the calling process. */
+pid_t
+getpid (void)
+{
+  /* A single aligned word is always read consistently. */
+  return vdata->pid;
+}
+
+/* Returns the number of timer ticks since the OS booted. */
+int64_t
+get_ticks (void)
+{
+  struct vdata vd;
+
+  read_vdata (&vd);
+  return vd.ticks;
+}
+
+/* Returns the number of nanoseconds since the OS booted.  The
+   time is interpolated between timer ticks with the TSC, if the
+   CPU has one, and is never less than a previously returned
+   value. */
+uint64_t
+get_time_ns (void)
+{
+  struct vdata vd;
+  uint64_t ns, cycles, tick_cycles;
+
+  read_vdata (&vd);
+  ns = (uint64_t) vd.ticks * 1000000000 / vd.timer_freq;
+  if (vd.tsc_freq == 0)
+    return ns;
+
+  /* Count at most one tick's worth of cycles, so that the next
+     tick never moves the time backward. */
+  cycles = rdtsc () - vd.tick_tsc;
+  tick_cycles = vd.tsc_freq / vd.timer_freq;
+  if (cycles > tick_cycles)
+    cycles = tick_cycles;
+  return ns + cycles * 1000000000 / vd.tsc_freq;
+}
+
+/* Returns the number of TSC cycles per second, or 0 if the CPU
+   has no TSC. */
+uint64_t
+get_tsc_freq (void)
+{
+  return vdata->tsc_freq;
+}
@@ -0,0 +1,27 @@
+#ifndef __LIB_VDATA_H
+#define __LIB_VDATA_H
+
+#include <stdint.h>
+
+/* User virtual address of the kernel data page, which the kernel
+   maps read-only into every process so that user programs can
+   read the values in it without a system call. */
+#define VDATA_ADDR ((const void *) 0x00010000)
+
+/* Contents of the kernel data page.
+
+   The kernel makes SEQ odd while it updates the other members
+   and even again afterward.  A reader copies the members it
+   wants between two reads of SEQ and retries if SEQ was odd or
+   changed in between. */
+struct vdata
+  {
+    uint32_t seq;               /* Sequence counter. */
+    uint32_t timer_freq;        /* Timer ticks per second. */
+    int64_t ticks;              /* Timer ticks since boot. */
+    uint64_t tsc_freq;          /* TSC cycles per second, or 0. */
+    uint64_t tick_tsc;          /* TSC at the latest tick. */
+    int pid;                    /* Process ID of the running process. */
+  };
+
+#endif /* lib/vdata.h */
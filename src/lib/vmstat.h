@@ -0,0 +1,18 @@
+#ifndef __LIB_VMSTAT_H
+#define __LIB_VMSTAT_H
+
+/* Paging statistics for one process, as reported by the
+   vmstat() system call.  Sizes are in pages. */
+struct vmstat
+  {
+    unsigned minor_faults;      /* Faults resolved without I/O. */
+    unsigned major_faults;      /* Faults that had to read a disk. */
+    unsigned swap_ins;          /* Pages read back from swap. */
+    unsigned swap_outs;         /* Pages evicted to swap. */
+    unsigned rss;               /* Resident set size. */
+    unsigned swapped;           /* Pages in swap. */
+    unsigned peak_rss;          /* Largest resident set size so far. */
+    unsigned wss;               /* Estimated working set size. */
+  };
+
+#endif /* lib/vmstat.h */
@@ -0,0 +1,131 @@
+/* Measures how much it costs to sweep through all of physical
+   memory through the kernel's mapping of it, one word per page,
+   with the kernel's own page directory and with a copy of it
+   that uses only 4 kB pages.
+
+   Each access of the sweep touches a different page, so with
+   4 kB pages almost every access misses in the TLB, while a 4 MB
+   page needs only one TLB entry for 1,024 pages.  Run with more
+   than 4 MB of memory ("pintos --mem=64 -- run tlb-sweep"), since
+   the first 4 MB holds the kernel's code and is always mapped
+   with 4 kB pages, and compare against "-nopse".
+
+   This is a benchmark, not a test: it prints timings but checks
+   nothing. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <tsc.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/loader.h"
+#include "threads/palloc.h"
+#include "threads/pte.h"
+#include "threads/vaddr.h"
+
+/* Number of times memory is swept per measurement. */
+#define SWEEPS 16
+
+static uint32_t *small_page_dir (void);
+static uint64_t time_sweeps (uint32_t *pd);
+static void free_page_dir (uint32_t *pd);
+
+void
+test_tlb_sweep (void)
+{
+  size_t large_cnt = 0;
+  uint64_t large_cycles, small_cycles;
+  uint32_t *pd;
+  size_t i;
+
+  for (i = pd_no (PHYS_BASE); i < PGSIZE / sizeof *init_page_dir; i++)
+    if (init_page_dir[i] & PTE_PS)
+      large_cnt++;
+  msg ("kernel maps %"PRIu32" pages of RAM with %zu 4 MB pages",
+       init_ram_pages, large_cnt);
+
+  pd = small_page_dir ();
+  if (pd == NULL)
+    {
+      msg ("out of memory for page tables");
+      return;
+    }
+
+  large_cycles = time_sweeps (init_page_dir);
+  small_cycles = time_sweeps (pd);
+  free_page_dir (pd);
+
+  msg ("%d sweeps with kernel page directory: %"PRIu64" cycles",
+       SWEEPS, large_cycles);
+  msg ("%d sweeps with 4 kB pages only: %"PRIu64" cycles",
+       SWEEPS, small_cycles);
+}
+
+/* Returns a copy of init_page_dir in which every large page is
+   split into 4 kB pages, or a null pointer if memory runs out. */
+static uint32_t *
+small_page_dir (void)
+{
+  uint32_t *pd = palloc_get_page (0);
+  size_t i;
+
+  if (pd == NULL)
+    return NULL;
+  memcpy (pd, init_page_dir, PGSIZE);
+  for (i = pd_no (PHYS_BASE); i < PGSIZE / sizeof *pd; i++)
+    if (pd[i] & PTE_PS)
+      {
+        uint8_t *vaddr = (uint8_t *) (i << PDSHIFT);
+        uint32_t *pt = palloc_get_page (0);
+        size_t j;
+
+        if (pt == NULL)
+          {
+            free_page_dir (pd);
+            return NULL;
+          }
+        for (j = 0; j < PGSIZE / sizeof *pt; j++)
+          pt[j] = pte_create_kernel (vaddr + j * PGSIZE, true);
+        pd[i] = pde_create (pt);
+      }
+  return pd;
+}
+
+/* Frees PD, which small_page_dir() returned, and the page tables
+   it created. */
+static void
+free_page_dir (uint32_t *pd)
+{
+  size_t i;
+
+  for (i = pd_no (PHYS_BASE); i < PGSIZE / sizeof *pd; i++)
+    if ((init_page_dir[i] & PTE_PS) && pd[i] != init_page_dir[i])
+      palloc_free_page (pde_get_pt (pd[i]));
+  palloc_free_page (pd);
+}
+
+/* Switches to page directory PD, sweeps all of RAM SWEEPS times,
+   switches back, and returns the number of cycles the sweeps
+   took.  Interrupts are off throughout, so that nothing else
+   runs under PD or disturbs the TLB. */
+static uint64_t
+time_sweeps (uint32_t *pd)
+{
+  enum intr_level old_level = intr_disable ();
+  volatile uint32_t sum = 0;
+  uint64_t start, cycles;
+  size_t i, page;
+
+  asm volatile ("movl %0, %%cr3" : : "r" (vtop (pd)) : "memory");
+  start = rdtsc ();
+  for (i = 0; i < SWEEPS; i++)
+    for (page = 0; page < init_ram_pages; page++)
+      sum += *(uint32_t *) ptov (page * PGSIZE);
+  cycles = rdtsc () - start;
+  asm volatile ("movl %0, %%cr3" : : "r" (vtop (init_page_dir)) : "memory");
+  intr_set_level (old_level);
+
+  return cycles;
+}
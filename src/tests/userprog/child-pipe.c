@@ -0,0 +1,26 @@
+/* Child process run by pipe test.
+
+   Writes CHILD_PIPE_SIZE bytes of a known pattern to its
+   standard output, which the parent redirects to a pipe, in a
+   single call. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/userprog/child-pipe.h"
+
+static char buf[CHILD_PIPE_SIZE];
+
+int
+main (void) 
+{
+  size_t i;
+
+  test_name = "child-pipe";
+
+  for (i = 0; i < sizeof buf; i++)
+    buf[i] = child_pipe_byte (i);
+  if (write (STDOUT_FILENO, buf, sizeof buf) != sizeof buf)
+    return 1;
+  return 0;
+}
@@ -0,0 +1,16 @@
+#ifndef TESTS_USERPROG_CHILD_PIPE_H
+#define TESTS_USERPROG_CHILD_PIPE_H
+
+#include <stddef.h>
+
+/* Number of bytes that child-pipe writes. */
+#define CHILD_PIPE_SIZE 12288
+
+/* Returns the byte that child-pipe writes at offset OFS. */
+static inline char
+child_pipe_byte (size_t ofs)
+{
+  return ofs * 7 + ofs / 251;
+}
+
+#endif /* tests/userprog/child-pipe.h */
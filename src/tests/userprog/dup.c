@@ -0,0 +1,53 @@
+/* Checks that new descriptors get the lowest free handle, that
+   dup() and dup2() work, including dup2() to a high handle, that
+   a handle and its duplicate share one file position, and that
+   fcntl() sets and clears close-on-exec. */
+
+#include <fcntl.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Number of descriptors to open at once, enough to grow the
+   descriptor table. */
+#define OPEN_CNT 40
+
+void
+test_main (void) 
+{
+  int handles[OPEN_CNT];
+  int handle, copy, i;
+
+  for (i = 0; i < OPEN_CNT; i++)
+    if ((handles[i] = open ("sample.txt")) < 2)
+      fail ("open \"sample.txt\" failed");
+  msg ("open \"sample.txt\" %d times", OPEN_CNT);
+  close (handles[7]);
+  close (handles[3]);
+  CHECK (open ("sample.txt") == handles[3], "reuse lowest free handle");
+  CHECK (open ("sample.txt") == handles[7], "reuse next free handle");
+  for (i = 1; i < OPEN_CNT; i++)
+    close (handles[i]);
+  handle = handles[0];
+
+  CHECK ((copy = dup (handle)) > 1 && copy != handle, "dup");
+  check_file_handle (copy, "sample.txt", sample, sizeof sample - 1);
+  CHECK (tell (handle) == sizeof sample - 1, "dup shares file position");
+  close (copy);
+  CHECK (dup (copy) == -1, "dup closed handle fails");
+
+  seek (handle, 0);
+  CHECK (dup2 (handle, 100) == 100, "dup2 to handle 100");
+  check_file_handle (100, "sample.txt", sample, sizeof sample - 1);
+  close (100);
+  CHECK (dup2 (handle, 1000000) == -1, "dup2 to huge handle fails");
+
+  CHECK (fcntl (handle, F_GETFD, 0) == 0, "not close-on-exec");
+  CHECK (fcntl (handle, F_SETFD, FD_CLOEXEC) == 0, "set close-on-exec");
+  CHECK (fcntl (handle, F_GETFD, 0) == FD_CLOEXEC, "close-on-exec");
+  copy = dup (handle);
+  CHECK (fcntl (copy, F_GETFD, 0) == 0, "dup clears close-on-exec");
+  close (copy);
+  CHECK (fcntl (copy, F_GETFD, 0) == -1, "fcntl on closed handle fails");
+}
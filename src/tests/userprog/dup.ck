@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(dup) begin
+(dup) open "sample.txt" 40 times
+(dup) reuse lowest free handle
+(dup) reuse next free handle
+(dup) dup
+(dup) verified contents of "sample.txt"
+(dup) dup shares file position
+(dup) dup closed handle fails
+(dup) dup2 to handle 100
+(dup) verified contents of "sample.txt"
+(dup) dup2 to huge handle fails
+(dup) not close-on-exec
+(dup) set close-on-exec
+(dup) close-on-exec
+(dup) dup clears close-on-exec
+(dup) fcntl on closed handle fails
+(dup) end
+dup: exit(0)
+EOF
+pass;
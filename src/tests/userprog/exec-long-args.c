@@ -0,0 +1,25 @@
+/* Executes child-simple with more arguments than fit on its
+   initial stack page, which must make exec return -1, then runs
+   it again with none to make sure that exec and wait still
+   work. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* 1000 arguments need about 2 kB for their strings and 4 kB for
+   argv[], more than one page. */
+static char cmd_line[16 + 1000 * 2];
+
+void
+test_main (void) 
+{
+  int i;
+
+  strlcpy (cmd_line, "child-simple", sizeof cmd_line);
+  for (i = 0; i < 1000; i++)
+    strlcat (cmd_line, " x", sizeof cmd_line);
+  msg ("exec(\"child-simple x x ...\"): %d", exec (cmd_line));
+  msg ("wait(exec()) = %d", wait (exec ("child-simple")));
+}
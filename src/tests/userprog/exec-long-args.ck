@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF', <<'EOF']);
+(exec-long-args) begin
+child-simple: exit(-1)
+(exec-long-args) exec("child-simple x x ..."): -1
+(child-simple) run
+child-simple: exit(81)
+(exec-long-args) wait(exec()) = 81
+(exec-long-args) end
+exec-long-args: exit(0)
+EOF
+(exec-long-args) begin
+(exec-long-args) exec("child-simple x x ..."): -1
+child-simple: exit(-1)
+(child-simple) run
+child-simple: exit(81)
+(exec-long-args) wait(exec()) = 81
+(exec-long-args) end
+exec-long-args: exit(0)
+EOF
+pass;
@@ -0,0 +1,35 @@
+/* Runs a copy of a program, then overwrites the copy's ELF
+   header and tries to run it again.  The second run must fail,
+   even though the kernel has loaded the program before. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[512];
+  int src, dst, size, ofs;
+
+  CHECK ((src = open ("child-simple")) > 1, "open \"child-simple\"");
+  size = filesize (src);
+  CHECK (create ("child-copy", size), "create \"child-copy\"");
+  CHECK ((dst = open ("child-copy")) > 1, "open \"child-copy\"");
+  for (ofs = 0; ofs < size; ofs += sizeof buf)
+    {
+      int cnt = read (src, buf, sizeof buf);
+      if (cnt <= 0 || write (dst, buf, cnt) != cnt)
+        fail ("copy failed at offset %d", ofs);
+    }
+  close (src);
+  close (dst);
+  CHECK (wait (exec ("child-copy")) == 81, "run \"child-copy\"");
+
+  memset (buf, 0, sizeof buf);
+  CHECK ((dst = open ("child-copy")) > 1, "open \"child-copy\"");
+  CHECK (write (dst, buf, 64) == 64, "overwrite ELF header");
+  close (dst);
+  CHECK (wait (exec ("child-copy")) == -1, "run \"child-copy\" again");
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(exec-rewrite) begin
+(exec-rewrite) open "child-simple"
+(exec-rewrite) create "child-copy"
+(exec-rewrite) open "child-copy"
+(exec-rewrite) run "child-copy"
+(child-simple) run
+child-copy: exit(81)
+(exec-rewrite) open "child-copy"
+(exec-rewrite) overwrite ELF header
+(exec-rewrite) run "child-copy" again
+load: child-copy: error loading executable
+child-copy: exit(-1)
+(exec-rewrite) end
+exec-rewrite: exit(0)
+EOF
+pass;
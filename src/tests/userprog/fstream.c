@@ -0,0 +1,53 @@
+/* Writes a file through a buffered stream, checking that the
+   data reaches the file only when the stream is flushed, then
+   reads it back a line at a time, and writes a line to stdout
+   a piece at a time. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static const char *lines[] = {"first line\n", "second line\n", "last line\n"};
+
+void
+test_main (void) 
+{
+  char expected[64] = "";
+  char buf[64];
+  FILE *file;
+  size_t size, i;
+  int handle;
+
+  for (i = 0; i < sizeof lines / sizeof *lines; i++)
+    strlcat (expected, lines[i], sizeof expected);
+  size = strlen (expected);
+
+  CHECK (create ("test.txt", size), "create \"test.txt\"");
+  CHECK ((file = fopen ("test.txt", "w")) != NULL, "fopen \"test.txt\"");
+  for (i = 0; i < sizeof lines / sizeof *lines; i++)
+    fprintf (file, "%s", lines[i]);
+
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+  CHECK (read (handle, buf, size) == (int) size
+         && memchr (buf, 'f', size) == NULL, "nothing written yet");
+
+  CHECK (fflush (file) == 0, "fflush");
+  CHECK (pread (handle, buf, size, 0) == (int) size
+         && !memcmp (buf, expected, size), "data written by fflush");
+  fclose (file);
+  close (handle);
+
+  CHECK ((file = fopen ("test.txt", "r")) != NULL, "fopen \"test.txt\"");
+  for (i = 0; i < sizeof lines / sizeof *lines; i++)
+    if (fgets (buf, sizeof buf, file) == NULL || strcmp (buf, lines[i]))
+      fail ("line %zu differs", i);
+  CHECK (fgetc (file) == EOF && feof (file), "read all lines");
+  fclose (file);
+
+  printf ("(fstream) line written ");
+  for (i = 0; i < 5; i++)
+    putchar ("piece"[i]);
+  puts (" by piece");
+}
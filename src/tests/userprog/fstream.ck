@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fstream) begin
+(fstream) create "test.txt"
+(fstream) fopen "test.txt"
+(fstream) open "test.txt"
+(fstream) nothing written yet
+(fstream) fflush
+(fstream) data written by fflush
+(fstream) fopen "test.txt"
+(fstream) read all lines
+(fstream) line written piece by piece
+(fstream) end
+fstream: exit(0)
+EOF
+pass;
@@ -0,0 +1,34 @@
+/* Checks futex_wait() with a stale value and futex_wake() with
+   no waiters, then sleeps on a futex until another thread
+   changes it and wakes us. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static int flag;
+
+static int
+set_flag (void *aux UNUSED)
+{
+  flag = 1;
+  futex_wake (&flag, 1);
+  return 0;
+}
+
+void
+test_main (void) 
+{
+  int value = 0;
+  tid_t tid;
+
+  CHECK (futex_wait (&value, 1) == -1, "wait with wrong value");
+  CHECK (futex_wake (&value, 1) == 0, "wake with no waiters");
+
+  CHECK ((tid = thread_create (set_flag, NULL)) != TID_ERROR,
+         "create thread");
+  while (flag == 0)
+    futex_wait (&flag, 0);
+  msg ("woken");
+  CHECK (thread_join (tid) == 0, "join thread");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex) begin
+(futex) wait with wrong value
+(futex) wake with no waiters
+(futex) create thread
+(futex) woken
+(futex) join thread
+(futex) end
+futex: exit(0)
+EOF
+pass;
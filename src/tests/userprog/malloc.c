@@ -0,0 +1,100 @@
+/* Allocates blocks of many sizes with malloc(), fills each with
+   its own pattern, and checks that no block overwrote another.
+   Then resizes and frees them, and checks that allocating and
+   freeing the same blocks over and over does not keep growing the
+   heap. */
+
+#include <malloc.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define BLOCK_CNT 64
+
+static char *blocks[BLOCK_CNT];
+
+/* Returns the size of block I. */
+static size_t
+block_size (int i)
+{
+  return (i % 8 == 7 ? 4096 * (i / 8 + 1) : 1 << (i % 8 + 2)) + i;
+}
+
+/* Allocates and fills every block. */
+static void
+allocate_all (void)
+{
+  int i;
+
+  for (i = 0; i < BLOCK_CNT; i++)
+    {
+      blocks[i] = malloc (block_size (i));
+      if (blocks[i] == NULL)
+        fail ("malloc (%zu) failed", block_size (i));
+      memset (blocks[i], i, block_size (i));
+    }
+}
+
+/* Checks that the first SIZE bytes of block I all hold I. */
+static void
+check_block (int i, size_t size)
+{
+  size_t j;
+
+  for (j = 0; j < size; j++)
+    if (blocks[i][j] != (char) i)
+      fail ("byte %zu of block %d is %d", j, i, blocks[i][j]);
+}
+
+void
+test_main (void) 
+{
+  char *heap_end;
+  char *p;
+  int i;
+
+  allocate_all ();
+  for (i = 0; i < BLOCK_CNT; i++)
+    check_block (i, block_size (i));
+  msg ("allocated %d blocks", BLOCK_CNT);
+
+  for (i = 0; i < BLOCK_CNT; i += 2)
+    free (blocks[i]);
+  for (i = 1; i < BLOCK_CNT; i += 2)
+    {
+      blocks[i] = realloc (blocks[i], block_size (i) * 2);
+      if (blocks[i] == NULL)
+        fail ("realloc of block %d failed", i);
+      check_block (i, block_size (i));
+    }
+  msg ("resized odd blocks");
+
+  p = calloc (100, 100);
+  CHECK (p != NULL, "calloc (100, 100)");
+  for (i = 0; i < 100 * 100; i++)
+    if (p[i] != 0)
+      fail ("byte %d of calloc'd block is %d", i, p[i]);
+  free (p);
+
+  for (i = 1; i < BLOCK_CNT; i += 2)
+    free (blocks[i]);
+  msg ("freed all blocks");
+
+  heap_end = NULL;
+  for (i = 0; i < 10; i++)
+    {
+      int j;
+
+      allocate_all ();
+      if (heap_end == NULL)
+        heap_end = sbrk (0);
+      else if ((char *) sbrk (0) > heap_end)
+        fail ("heap grew in round %d", i + 1);
+      for (j = 0; j < BLOCK_CNT; j++)
+        free (blocks[j]);
+    }
+  msg ("heap did not grow");
+
+  CHECK (malloc (0x7fffffff) == NULL, "malloc of 2 GB fails");
+}
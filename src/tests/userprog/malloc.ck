@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(malloc) begin
+(malloc) allocated 64 blocks
+(malloc) resized odd blocks
+(malloc) calloc (100, 100)
+(malloc) freed all blocks
+(malloc) heap did not grow
+(malloc) malloc of 2 GB fails
+(malloc) end
+malloc: exit(0)
+EOF
+pass;
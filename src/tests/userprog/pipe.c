@@ -0,0 +1,55 @@
+/* Passes data through pipes, first within this process and then
+   from a child process whose standard output is redirected to a
+   pipe.  The child writes more than a pipe holds, so it must wait
+   for this process to read. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/userprog/child-pipe.h"
+
+void
+test_main (void) 
+{
+  static char buf[CHILD_PIPE_SIZE / 5];
+  int fds[2];
+  size_t total;
+  int n;
+
+  CHECK (pipe (fds), "create pipe");
+  CHECK (write (fds[1], "hello", 6) == 6, "write to pipe");
+  CHECK (read (fds[0], buf, sizeof buf) == 6, "read from pipe");
+  if (strcmp (buf, "hello"))
+    fail ("read \"%s\" instead of \"hello\"", buf);
+  CHECK (read (fds[1], buf, 1) == -1, "read from write end fails");
+  CHECK (write (fds[0], buf, 1) == -1, "write to read end fails");
+  close (fds[1]);
+  CHECK (read (fds[0], buf, sizeof buf) == 0,
+         "end of file after closing write end");
+  CHECK (pipe (fds), "create pipe");
+  close (fds[0]);
+  CHECK (write (fds[1], buf, 1) == -1, "write with no reader fails");
+  close (fds[1]);
+
+  CHECK (pipe (fds), "create pipe");
+  CHECK (dup2 (fds[1], STDOUT_FILENO) == STDOUT_FILENO,
+         "dup2 write end to stdout");
+  n = exec ("child-pipe");
+  close (STDOUT_FILENO);
+  close (fds[1]);
+  CHECK (n != PID_ERROR, "exec \"child-pipe\"");
+
+  total = 0;
+  while ((n = read (fds[0], buf, sizeof buf)) > 0)
+    {
+      int i;
+
+      for (i = 0; i < n; i++, total++)
+        if (buf[i] != child_pipe_byte (total))
+          fail ("byte %zu differs", total);
+    }
+  CHECK (n == 0, "read %zu bytes", total);
+  close (fds[0]);
+}
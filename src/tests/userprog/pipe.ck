@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe) begin
+(pipe) create pipe
+(pipe) write to pipe
+(pipe) read from pipe
+(pipe) read from write end fails
+(pipe) write to read end fails
+(pipe) end of file after closing write end
+(pipe) create pipe
+(pipe) write with no reader fails
+(pipe) create pipe
+(pipe) dup2 write end to stdout
+(pipe) exec "child-pipe"
+child-pipe: exit(0)
+(pipe) read 12288 bytes
+(pipe) end
+pipe: exit(0)
+EOF
+pass;
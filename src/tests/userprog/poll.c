@@ -0,0 +1,67 @@
+/* Polls pipes, a file, and a bad descriptor, then sleeps in
+   poll() until a child process writes to a pipe. */
+
+#include <poll.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  struct pollfd pfds[3];
+  char buf[512];
+  int fds[2];
+  pid_t pid;
+
+  CHECK (pipe (fds), "create pipe");
+  pfds[0].fd = fds[0];
+  pfds[0].events = POLLIN;
+  pfds[1].fd = fds[1];
+  pfds[1].events = POLLOUT;
+  CHECK (poll (pfds, 2, 0) == 1, "poll empty pipe");
+  if (pfds[0].revents != 0 || pfds[1].revents != POLLOUT)
+    fail ("bad events %#x, %#x", pfds[0].revents, pfds[1].revents);
+  CHECK (poll (pfds, 1, 50) == 0, "poll empty pipe with timeout");
+
+  CHECK (write (fds[1], "x", 1) == 1, "write to pipe");
+  CHECK (poll (pfds, 1, -1) == 1, "poll pipe with data");
+  if (pfds[0].revents != POLLIN)
+    fail ("bad events %#x", pfds[0].revents);
+  CHECK (read (fds[0], buf, sizeof buf) == 1, "read from pipe");
+
+  close (fds[1]);
+  CHECK (poll (pfds, 1, -1) == 1, "poll pipe without writers");
+  if (pfds[0].revents != (POLLIN | POLLHUP))
+    fail ("bad events %#x", pfds[0].revents);
+  close (fds[0]);
+
+  CHECK (create ("data", 512), "create \"data\"");
+  CHECK ((pfds[0].fd = open ("data")) > 1, "open \"data\"");
+  pfds[0].events = POLLIN | POLLOUT;
+  pfds[1].fd = 1234;
+  pfds[1].events = POLLIN;
+  pfds[2].fd = -1;
+  CHECK (poll (pfds, 3, 0) == 2, "poll file and bad descriptors");
+  if (pfds[0].revents != (POLLIN | POLLOUT) || pfds[1].revents != POLLNVAL
+      || pfds[2].revents != 0)
+    fail ("bad events %#x, %#x, %#x",
+          pfds[0].revents, pfds[1].revents, pfds[2].revents);
+  close (pfds[0].fd);
+
+  CHECK (pipe (fds), "create pipe");
+  dup2 (fds[1], STDOUT_FILENO);
+  pid = exec ("child-pipe");
+  close (STDOUT_FILENO);
+  close (fds[1]);
+  CHECK (pid != PID_ERROR, "exec \"child-pipe\"");
+  pfds[0].fd = fds[0];
+  pfds[0].events = POLLIN;
+  CHECK (poll (pfds, 1, -1) == 1, "wait for child's output");
+  if (!(pfds[0].revents & POLLIN))
+    fail ("bad events %#x", pfds[0].revents);
+  while (read (fds[0], buf, sizeof buf) > 0)
+    continue;
+  close (fds[0]);
+}
@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(poll) begin
+(poll) create pipe
+(poll) poll empty pipe
+(poll) poll empty pipe with timeout
+(poll) write to pipe
+(poll) poll pipe with data
+(poll) read from pipe
+(poll) poll pipe without writers
+(poll) create "data"
+(poll) open "data"
+(poll) poll file and bad descriptors
+(poll) create pipe
+(poll) exec "child-pipe"
+(poll) wait for child's output
+child-pipe: exit(0)
+(poll) end
+poll: exit(0)
+EOF
+pass;
@@ -0,0 +1,43 @@
+/* Writes two blocks of a file out of order with pwrite() and
+   reads them back with pread(), checking that neither moves the
+   file position, which ordinary reads and writes then use. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define BLOCK_SIZE 512
+
+static char blocks[2][BLOCK_SIZE];
+static char buf[BLOCK_SIZE];
+
+void
+test_main (void) 
+{
+  int handle;
+
+  memset (blocks[0], 'a', BLOCK_SIZE);
+  memset (blocks[1], 'b', BLOCK_SIZE);
+
+  CHECK (create ("test.dat", sizeof blocks), "create \"test.dat\"");
+  CHECK ((handle = open ("test.dat")) > 1, "open \"test.dat\"");
+
+  CHECK (pwrite (handle, blocks[1], BLOCK_SIZE, BLOCK_SIZE) == BLOCK_SIZE,
+         "pwrite second block");
+  CHECK (pwrite (handle, blocks[0], BLOCK_SIZE, 0) == BLOCK_SIZE,
+         "pwrite first block");
+  CHECK (tell (handle) == 0, "file position unchanged");
+
+  CHECK (pread (handle, buf, BLOCK_SIZE, BLOCK_SIZE) == BLOCK_SIZE,
+         "pread second block");
+  compare_bytes (buf, blocks[1], BLOCK_SIZE, BLOCK_SIZE, "test.dat");
+  CHECK (pread (handle, buf, BLOCK_SIZE, sizeof blocks) == 0,
+         "pread at end of file");
+  CHECK (tell (handle) == 0, "file position unchanged");
+
+  CHECK (read (handle, buf, BLOCK_SIZE) == BLOCK_SIZE, "read first block");
+  compare_bytes (buf, blocks[0], BLOCK_SIZE, 0, "test.dat");
+  CHECK (pread (handle, buf, 1, 0) == 1 && tell (handle) == BLOCK_SIZE,
+         "pread leaves position after read");
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread) begin
+(pread) create "test.dat"
+(pread) open "test.dat"
+(pread) pwrite second block
+(pread) pwrite first block
+(pread) file position unchanged
+(pread) pread second block
+(pread) pread at end of file
+(pread) file position unchanged
+(pread) read first block
+(pread) pread leaves position after read
+(pread) end
+pread: exit(0)
+EOF
+pass;
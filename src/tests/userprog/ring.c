@@ -0,0 +1,103 @@
+/* Opens a file, writes it, reads it back, and closes it, all
+   through the system call ring, with several reads or writes
+   in flight at once. */
+
+#include <ring.h>
+#include <string.h>
+#include <syscall.h>
+#include <syscall-nr.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define BLOCK_CNT 4
+#define BLOCK_SIZE 512
+
+static struct ring *ring;
+static char wbuf[BLOCK_CNT][BLOCK_SIZE];
+static char rbuf[BLOCK_CNT][BLOCK_SIZE];
+
+/* Queues system call NR with the given arguments, file offset
+   OFS, and USER_DATA in the submission queue. */
+static void
+queue (int nr, int arg0, int arg1, int arg2, unsigned ofs,
+       unsigned user_data)
+{
+  struct ring_sqe *sqe = &ring->sq[ring->sq_tail % RING_SQ_SIZE];
+
+  sqe->nr = nr;
+  sqe->args[0] = arg0;
+  sqe->args[1] = arg1;
+  sqe->args[2] = arg2;
+  sqe->ofs = ofs;
+  sqe->user_data = user_data;
+  ring->sq_tail++;
+}
+
+/* Submits the CNT queued system calls, whose user data must
+   range from 0 to CNT - 1, waits for all of them to complete,
+   and stores the result of the one with user data I into
+   RESULTS[I]. */
+static void
+complete (int cnt, int results[])
+{
+  int i;
+
+  if (ring_enter (cnt, cnt) != cnt)
+    fail ("ring_enter submitted too few entries");
+  for (i = 0; i < cnt; i++)
+    {
+      volatile struct ring_cqe *cqe;
+
+      if (ring->cq_head == ring->cq_tail)
+        fail ("completion missing");
+      cqe = &ring->cq[ring->cq_head % RING_CQ_SIZE];
+      if (cqe->user_data >= (unsigned) cnt)
+        fail ("bad user data %u in completion", cqe->user_data);
+      results[cqe->user_data] = cqe->result;
+      ring->cq_head++;
+    }
+}
+
+void
+test_main (void) 
+{
+  int results[BLOCK_CNT];
+  int handle;
+  int i;
+
+  ring = ring_setup ();
+  CHECK (ring == RING_ADDR, "ring_setup");
+  CHECK (create ("ring.dat", sizeof wbuf), "create \"ring.dat\"");
+
+  queue (SYS_OPEN, (int) "ring.dat", 0, 0, 0, 0);
+  complete (1, results);
+  handle = results[0];
+  CHECK (handle > 1, "open \"ring.dat\" through ring");
+
+  msg ("write %d blocks through ring", BLOCK_CNT);
+  for (i = 0; i < BLOCK_CNT; i++) 
+    {
+      memset (wbuf[i], 'a' + i, BLOCK_SIZE);
+      queue (SYS_WRITE, handle, (int) wbuf[i], BLOCK_SIZE,
+             i * BLOCK_SIZE, i);
+    }
+  complete (BLOCK_CNT, results);
+  for (i = 0; i < BLOCK_CNT; i++) 
+    if (results[i] != BLOCK_SIZE)
+      fail ("write of block %d returned %d", i, results[i]);
+
+  msg ("read %d blocks through ring", BLOCK_CNT);
+  for (i = 0; i < BLOCK_CNT; i++) 
+    queue (SYS_READ, handle, (int) rbuf[i], BLOCK_SIZE, i * BLOCK_SIZE, i);
+  complete (BLOCK_CNT, results);
+  for (i = 0; i < BLOCK_CNT; i++) 
+    if (results[i] != BLOCK_SIZE)
+      fail ("read of block %d returned %d", i, results[i]);
+  compare_bytes (rbuf, wbuf, sizeof rbuf, 0, "ring.dat");
+
+  CHECK (tell (handle) == 0, "file position unchanged");
+
+  queue (SYS_CLOSE, handle, 0, 0, 0, 0);
+  complete (1, results);
+  CHECK (read (handle, rbuf, 1) == -1, "close through ring");
+}
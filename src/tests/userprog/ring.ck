@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring) begin
+(ring) ring_setup
+(ring) create "ring.dat"
+(ring) open "ring.dat" through ring
+(ring) write 4 blocks through ring
+(ring) read 4 blocks through ring
+(ring) file position unchanged
+(ring) close through ring
+(ring) end
+ring: exit(0)
+EOF
+pass;
@@ -0,0 +1,47 @@
+/* Grows the heap with sbrk(), checking that the new memory reads
+   as zeros and can be written, then shrinks it again and checks
+   that the break cannot be moved below the start of the heap or
+   into the stack. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define GROWTH 10000
+
+/* Fails unless the SIZE bytes at BUF are all zero. */
+static void
+check_zero (const char *buf, size_t size)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    if (buf[i] != 0)
+      fail ("byte %zu of heap is %d instead of 0", i, buf[i]);
+}
+
+void
+test_main (void) 
+{
+  char *start = sbrk (0);
+  size_t i;
+
+  CHECK (start != (void *) -1, "sbrk (0)");
+  CHECK (sbrk (GROWTH) == start, "sbrk (%d)", GROWTH);
+  CHECK (sbrk (0) == start + GROWTH, "break moved");
+  check_zero (start, GROWTH);
+  for (i = 0; i < GROWTH; i++)
+    start[i] = i;
+  for (i = 0; i < GROWTH; i++)
+    if (start[i] != (char) i)
+      fail ("byte %zu of heap changed", i);
+
+  CHECK (sbrk (-GROWTH) == start + GROWTH, "sbrk (%d)", -GROWTH);
+  CHECK (sbrk (-1) == (void *) -1, "sbrk below start of heap fails");
+  CHECK (sbrk (INTPTR_MAX) == (void *) -1, "sbrk into stack fails");
+  CHECK (sbrk (0) == start, "break unchanged");
+
+  CHECK (sbrk (GROWTH) == start, "sbrk (%d) again", GROWTH);
+  check_zero (start, GROWTH);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sbrk) begin
+(sbrk) sbrk (0)
+(sbrk) sbrk (10000)
+(sbrk) break moved
+(sbrk) sbrk (-10000)
+(sbrk) sbrk below start of heap fails
+(sbrk) sbrk into stack fails
+(sbrk) break unchanged
+(sbrk) sbrk (10000) again
+(sbrk) end
+sbrk: exit(0)
+EOF
+pass;
@@ -0,0 +1,24 @@
+/* Has a second thread call exit() while the first thread sleeps
+   on a futex.  The whole process must end, with the second
+   thread's exit status. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static int
+exit_process (void *aux UNUSED)
+{
+  exit (57);
+}
+
+void
+test_main (void) 
+{
+  int never = 0;
+
+  CHECK (thread_create (exit_process, NULL) != TID_ERROR,
+         "create thread");
+  for (;;)
+    futex_wait (&never, 0);
+}
@@ -0,0 +1,44 @@
+/* Starts several threads that increment a shared counter under
+   a mutex, then joins them and checks their exit statuses and
+   the final count. */
+
+#include <mutex.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 4
+#define ITERATIONS 10000
+
+static struct mutex mutex = MUTEX_INITIALIZER;
+static volatile int counter;
+
+static int
+increment (void *aux)
+{
+  int i;
+
+  for (i = 0; i < ITERATIONS; i++)
+    {
+      mutex_lock (&mutex);
+      counter++;
+      mutex_unlock (&mutex);
+    }
+  return (int) aux + 100;
+}
+
+void
+test_main (void) 
+{
+  tid_t tids[THREAD_CNT];
+  int i;
+
+  for (i = 0; i < THREAD_CNT; i++)
+    CHECK ((tids[i] = thread_create (increment, (void *) i)) != TID_ERROR,
+           "create thread %d", i);
+  for (i = 0; i < THREAD_CNT; i++)
+    CHECK (thread_join (tids[i]) == i + 100, "join thread %d", i);
+  CHECK (counter == THREAD_CNT * ITERATIONS, "counter is %d", counter);
+  CHECK (thread_join (tids[0]) == -1, "join thread 0 again");
+  CHECK (thread_join (12345) == -1, "join bad thread");
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(uthread) begin
+(uthread) create thread 0
+(uthread) create thread 1
+(uthread) create thread 2
+(uthread) create thread 3
+(uthread) join thread 0
+(uthread) join thread 1
+(uthread) join thread 2
+(uthread) join thread 3
+(uthread) counter is 40000
+(uthread) join thread 0 again
+(uthread) join bad thread
+(uthread) end
+uthread: exit(0)
+EOF
+pass;
@@ -0,0 +1,35 @@
+/* Reads the time and process ID from the kernel data page,
+   checks that the page can be written to a file, then tries to
+   modify the page, which must kill the process. */
+
+#include <syscall.h>
+#include <vdata.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int64_t start = get_ticks ();
+  uint64_t last = get_time_ns ();
+  int handle;
+
+  CHECK (getpid () > 0, "getpid");
+
+  /* Wait for a tick, checking that time never goes backward. */
+  while (get_ticks () == start)
+    {
+      uint64_t now = get_time_ns ();
+      if (now < last)
+        fail ("time went backward");
+      last = now;
+    }
+  msg ("ticks advanced");
+
+  CHECK (create ("vdata.dat", 64), "create \"vdata.dat\"");
+  CHECK ((handle = open ("vdata.dat")) > 1, "open \"vdata.dat\"");
+  CHECK (write (handle, VDATA_ADDR, 64) == 64, "write kernel data page");
+
+  *(volatile int *) VDATA_ADDR = 0;
+  fail ("should have exited with -1");
+}
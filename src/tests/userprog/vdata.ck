@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_USER_FAULTS => 1, [<<'EOF']);
+(vdata) begin
+(vdata) getpid
+(vdata) ticks advanced
+(vdata) create "vdata.dat"
+(vdata) open "vdata.dat"
+(vdata) write kernel data page
+vdata: exit(-1)
+EOF
+pass;
@@ -0,0 +1,49 @@
+/* Writes a file with writev() from three buffers, one of them
+   empty, and checks it with ordinary reads.  Then reads it back
+   with readv() into buffers split at a different point, and
+   writes to the console with writev(). */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  static char console[] = "(writev) writev to console\n";
+  const size_t size = sizeof sample - 1;
+  char buf[sizeof sample - 1];
+  struct iovec iov[3];
+  int handle;
+
+  CHECK (create ("test.txt", size), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+
+  iov[0].iov_base = sample;
+  iov[0].iov_len = 10;
+  iov[1].iov_base = sample + 10;
+  iov[1].iov_len = 0;
+  iov[2].iov_base = sample + 10;
+  iov[2].iov_len = size - 10;
+  CHECK (writev (handle, iov, 3) == (int) size, "writev 3 buffers");
+  CHECK (tell (handle) == size, "file position advanced");
+  check_file ("test.txt", sample, size);
+
+  seek (handle, 0);
+  iov[0].iov_base = buf;
+  iov[0].iov_len = size / 2;
+  iov[1].iov_base = buf + size / 2;
+  iov[1].iov_len = size - size / 2;
+  CHECK (readv (handle, iov, 2) == (int) size, "readv 2 buffers");
+  compare_bytes (buf, sample, size, 0, "test.txt");
+
+  CHECK (writev (handle, iov, IOV_MAX + 1) == -1, "too many buffers");
+
+  iov[0].iov_base = console;
+  iov[0].iov_len = 9;
+  iov[1].iov_base = console + 9;
+  iov[1].iov_len = sizeof console - 10;
+  writev (STDOUT_FILENO, iov, 2);
+}
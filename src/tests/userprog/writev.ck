@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(writev) begin
+(writev) create "test.txt"
+(writev) open "test.txt"
+(writev) writev 3 buffers
+(writev) file position advanced
+(writev) open "test.txt" for verification
+(writev) verified contents of "test.txt"
+(writev) close "test.txt"
+(writev) readv 2 buffers
+(writev) too many buffers
+(writev) writev to console
+(writev) end
+writev: exit(0)
+EOF
+pass;
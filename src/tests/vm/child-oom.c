@@ -0,0 +1,24 @@
+/* Child process of oom-kill.
+   Makes itself the OOM killer's first choice, then dirties
+   16 MB of memory, which is more than RAM and swap can hold, so
+   it should be killed before it finishes. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+
+#define SIZE (16 * 1024 * 1024)
+static char buf[SIZE];
+
+int
+main (void)
+{
+  size_t i;
+
+  test_name = "child-oom";
+
+  oom_adjust (OOM_ADJ_MAX);
+  for (i = 0; i < SIZE; i += 4096)
+    buf[i] = i / 4096 + 1;
+  fail ("dirtied %d bytes without running out of memory", SIZE);
+  return 0;
+}
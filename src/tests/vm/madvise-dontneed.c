@@ -0,0 +1,38 @@
+/* Fills an array, discards it with MADV_DONTNEED, and checks
+   that its frames are released and that it reads back as
+   zeros. */
+
+#include <round.h>
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGES 64
+
+static char buf[(PAGES + 1) * 4096];
+
+void
+test_main (void)
+{
+  char *pages = (char *) ROUND_UP ((uintptr_t) buf, 4096);
+  struct vmstat before, after;
+  size_t i;
+
+  for (i = 0; i < PAGES * 4096; i += 4096)
+    pages[i] = 'x';
+  CHECK (vmstat (&before), "vmstat after filling array");
+  CHECK (madvise (pages, PAGES * 4096, MADV_DONTNEED) == 0,
+         "madvise DONTNEED");
+  CHECK (vmstat (&after), "vmstat after discarding array");
+  if (before.rss - after.rss < PAGES)
+    fail ("discarding released only %u frames", before.rss - after.rss);
+
+  for (i = 0; i < PAGES * 4096; i += 4096)
+    if (pages[i] != 0)
+      fail ("byte %zu is %d instead of 0", i, pages[i]);
+  msg ("array reads as zeros");
+
+  CHECK (madvise (pages + 1, 4096, MADV_WILLNEED) == -1,
+         "madvise rejects unaligned address");
+}
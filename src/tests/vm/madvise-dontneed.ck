@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(madvise-dontneed) begin
+(madvise-dontneed) vmstat after filling array
+(madvise-dontneed) madvise DONTNEED
+(madvise-dontneed) vmstat after discarding array
+(madvise-dontneed) array reads as zeros
+(madvise-dontneed) madvise rejects unaligned address
+(madvise-dontneed) end
+EOF
+pass;
@@ -0,0 +1,19 @@
+/* Runs a child that dirties more memory than RAM and swap can
+   hold together, and checks that the child, not this process,
+   is the one killed when memory runs out.  This process exempts
+   itself from the OOM killer, and the child makes itself the
+   preferred victim. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  pid_t child;
+
+  CHECK (oom_adjust (OOM_ADJ_MIN) == 0, "exempt self from OOM killer");
+  CHECK ((child = exec ("child-oom")) != -1, "exec \"child-oom\"");
+  CHECK (wait (child) == -1, "wait for child-oom");
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+fail "missing message about child-oom being killed for lack of memory\n"
+  if !grep (/^Out of memory: killed child-oom /, @output);
+compare_output ("run", IGNORE_USER_FAULTS => 1, IGNORE_EXIT_CODES => 1,
+                [grep (!/^Out of memory: /, @output)], [<<'EOF']);
+(oom-kill) begin
+(oom-kill) exempt self from OOM killer
+(oom-kill) exec "child-oom"
+(oom-kill) wait for child-oom
+(oom-kill) end
+EOF
+pass;
@@ -0,0 +1,32 @@
+/* Reads through a large initialized read-only array one page at
+   a time, checking that readahead and fault-around keep most of
+   the pages from having to be read from disk when they are
+   first touched. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGES 128
+
+static const char data[PAGES * 4096] = {1};
+
+void
+test_main (void)
+{
+  struct vmstat before, after;
+  unsigned major_cnt;
+  size_t i;
+  int sum = 0;
+
+  CHECK (vmstat (&before), "vmstat before reading array");
+  for (i = 0; i < sizeof data; i += 4096)
+    sum += data[i];
+  CHECK (vmstat (&after), "vmstat after reading array");
+  if (sum != 1)
+    fail ("array sums to %d instead of 1", sum);
+
+  major_cnt = after.major_faults - before.major_faults;
+  if (major_cnt >= PAGES / 2)
+    fail ("reading %d pages took %u major faults", PAGES, major_cnt);
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-readahead) begin
+(page-readahead) vmstat before reading array
+(page-readahead) vmstat after reading array
+(page-readahead) end
+EOF
+pass;
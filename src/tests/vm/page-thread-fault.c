@@ -0,0 +1,57 @@
+/* Starts several threads at once that all touch the same fresh
+   pages of a zero-initialized array, so that they fault on each
+   page together, and checks that every thread survives and that
+   every thread's writes land.  Each thread reads a page before
+   writing its own byte in it, so that both a read fault and a
+   write fault can find the page already brought in by another
+   thread. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 4
+#define PAGES 64
+
+static char buf[PAGES * 4096];
+static volatile int go;
+
+static int
+touch (void *aux)
+{
+  int id = (int) aux;
+  size_t i;
+
+  while (!go)
+    continue;
+  for (i = 0; i < PAGES; i++)
+    {
+      char *byte = &buf[i * 4096 + id];
+      if (*byte != 0)
+        return -1;
+      *byte = id + 1;
+    }
+  return id;
+}
+
+void
+test_main (void)
+{
+  tid_t tids[THREAD_CNT];
+  size_t i;
+  int id;
+
+  for (id = 0; id < THREAD_CNT; id++)
+    CHECK ((tids[id] = thread_create (touch, (void *) id)) != TID_ERROR,
+           "create thread %d", id);
+  go = 1;
+  for (id = 0; id < THREAD_CNT; id++)
+    CHECK (thread_join (tids[id]) == id, "join thread %d", id);
+
+  for (i = 0; i < PAGES; i++)
+    for (id = 0; id < THREAD_CNT; id++)
+      if (buf[i * 4096 + id] != id + 1)
+        fail ("page %zu byte %d is %d instead of %d",
+              i, id, buf[i * 4096 + id], id + 1);
+  msg ("every thread's writes landed");
+}
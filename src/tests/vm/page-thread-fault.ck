@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-thread-fault) begin
+(page-thread-fault) create thread 0
+(page-thread-fault) create thread 1
+(page-thread-fault) create thread 2
+(page-thread-fault) create thread 3
+(page-thread-fault) join thread 0
+(page-thread-fault) join thread 1
+(page-thread-fault) join thread 2
+(page-thread-fault) join thread 3
+(page-thread-fault) every thread's writes landed
+(page-thread-fault) end
+EOF
+pass;
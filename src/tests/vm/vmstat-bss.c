@@ -0,0 +1,35 @@
+/* Reads every page of a large zero-initialized array, checking
+   that it reads as zeros without using a frame per page, then
+   writes one page and checks that only that page becomes
+   resident. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGES 256
+
+static char buf[PAGES * 4096];
+
+void
+test_main (void)
+{
+  struct vmstat before, after;
+  size_t i;
+
+  CHECK (vmstat (&before), "vmstat before reading array");
+  for (i = 0; i < sizeof buf; i += 4096)
+    if (buf[i] != 0)
+      fail ("byte %zu is %d instead of 0", i, buf[i]);
+  CHECK (vmstat (&after), "vmstat after reading array");
+  if (after.rss - before.rss >= PAGES / 2)
+    fail ("reading zeros used %u frames", after.rss - before.rss);
+
+  before = after;
+  buf[PAGES / 2 * 4096] = 1;
+  CHECK (vmstat (&after), "vmstat after writing one page");
+  if (after.rss - before.rss != 1)
+    fail ("writing one page used %u frames", after.rss - before.rss);
+  if (buf[PAGES / 2 * 4096 + 4096] != 0 || buf[PAGES / 2 * 4096] != 1)
+    fail ("write to one page visible in another");
+}
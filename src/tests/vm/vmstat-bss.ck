@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(vmstat-bss) begin
+(vmstat-bss) vmstat before reading array
+(vmstat-bss) vmstat after reading array
+(vmstat-bss) vmstat after writing one page
+(vmstat-bss) end
+EOF
+pass;
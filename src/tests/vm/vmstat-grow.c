@@ -0,0 +1,32 @@
+/* Grows the stack by touching a large stack object one page at a
+   time and checks that vmstat() reports a minor fault and one
+   more resident page for each page touched. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGES 16
+
+void
+test_main (void)
+{
+  char stack_obj[PAGES * 4096];
+  struct vmstat before, after;
+  size_t i;
+
+  CHECK (vmstat (&before), "vmstat before growing stack");
+  for (i = 0; i < sizeof stack_obj; i += 4096)
+    stack_obj[sizeof stack_obj - 1 - i] = 1;
+  CHECK (vmstat (&after), "vmstat after growing stack");
+
+  if (after.minor_faults - before.minor_faults < PAGES - 1)
+    fail ("only %u minor faults", after.minor_faults - before.minor_faults);
+  if (after.rss - before.rss < PAGES - 1)
+    fail ("resident set grew by only %u pages", after.rss - before.rss);
+  if (after.peak_rss < after.rss)
+    fail ("peak resident set %u smaller than resident set %u",
+          after.peak_rss, after.rss);
+  msg ("stack growth counted");
+}
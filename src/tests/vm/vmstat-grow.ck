@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(vmstat-grow) begin
+(vmstat-grow) vmstat before growing stack
+(vmstat-grow) vmstat after growing stack
+(vmstat-grow) stack growth counted
+(vmstat-grow) end
+EOF
+pass;
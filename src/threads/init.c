@@ -1,5 +1,6 @@
 #include "threads/init.h"
 #include <console.h>
+#include <cpuid.h>
 #include <debug.h>
 #include <inttypes.h>
 #include <limits.h>
@@ -24,10 +25,14 @@
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/process.h"
+#include "userprog/elf.h"
 #include "userprog/exception.h"
+#include "userprog/futex.h"
 #include "userprog/gdt.h"
+#include "userprog/ring.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
+#include "userprog/vdata.h"
 #else
 #include "tests/threads/tests.h"
 #endif
@@ -37,6 +42,14 @@
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #endif
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/oom.h"
+#include "vm/page.h"
+#include "vm/readahead.h"
+#include "vm/share.h"
+#include "vm/swap.h"
+#endif
 
 /* Page directory with kernel mappings only. */
 uint32_t *init_page_dir;
@@ -57,6 +70,12 @@ static const char *swap_bdev_name;
 /* -ul: Maximum number of pages to put into palloc's user pool. */
 static size_t user_page_limit = SIZE_MAX;
 
+/* -nopse: Map the kernel with 4 kB pages only? */
+static bool no_large_pages;
+
+/* CR4 bit that enables page size extensions. */
+#define CR4_PSE 0x00000010
+
 static void bss_init (void);
 static void paging_init (void);
 
@@ -113,12 +132,23 @@ main (void)
 #ifdef USERPROG
   exception_init ();
   syscall_init ();
+  futex_init ();
+  elf_init ();
 #endif
 
   /* Start thread scheduler and enable interrupts. */
   thread_start ();
   serial_init_queue ();
   timer_calibrate ();
+#ifdef USERPROG
+  vdata_init ();
+#endif
+
+#ifdef VM
+  /* Initialize the shared page cache, which the file system
+     keeps up to date from here on. */
+  share_init ();
+#endif
 
 #ifdef FILESYS
   /* Initialize file system. */
@@ -127,6 +157,21 @@ main (void)
   filesys_init (format_filesys);
 #endif
 
+#ifdef USERPROG
+  /* Start the workers that carry out system calls submitted
+     through system call rings. */
+  ring_init ();
+#endif
+
+#ifdef VM
+  /* Initialize virtual memory. */
+  page_init ();
+  frame_init ();
+  swap_init ();
+  oom_init ();
+  readahead_init ();
+#endif
+
   printf ("Boot complete.\n");
   
   /* Run actions specified on kernel command line. */
@@ -153,13 +198,31 @@ bss_init (void)
 /* Populates the base page directory and page table with the
    kernel virtual mapping, and then sets up the CPU to use the
    new page directory.  Points init_page_dir to the page
-   directory it creates. */
+   directory it creates.
+
+   If the CPU supports it, each 4 MB stretch of physical memory
+   that is present in full and holds no kernel code is mapped
+   with a single large page, which saves a page table and lets
+   one TLB entry cover the whole stretch.  The rest is mapped
+   with 4 kB pages, so that the kernel's code can be read-only
+   and memory past the end of RAM stays unmapped. */
 static void
 paging_init (void)
 {
   uint32_t *pd, *pt;
   size_t page;
   extern char _start, _end_kernel_text;
+  bool large_pages = (!no_large_pages
+                      && (cpuid_features () & CPUID_PSE) != 0);
+
+  /* Enable page size extensions, to allow large pages.  See
+     [IA32-v3a] 2.5 "Control Registers". */
+  if (large_pages)
+    {
+      uint32_t cr4;
+      asm volatile ("movl %%cr4, %0" : "=r" (cr4));
+      asm volatile ("movl %0, %%cr4" : : "r" (cr4 | CR4_PSE));
+    }
 
   pd = init_page_dir = palloc_get_page (PAL_ASSERT | PAL_ZERO);
   pt = NULL;
@@ -171,6 +234,15 @@ paging_init (void)
       size_t pte_idx = pt_no (vaddr);
       bool in_kernel_text = &_start <= vaddr && vaddr < &_end_kernel_text;
 
+      if (large_pages && pte_idx == 0
+          && init_ram_pages - page >= PTSPAN / PGSIZE
+          && (vaddr + PTSPAN <= &_start || vaddr >= &_end_kernel_text))
+        {
+          pd[pde_idx] = pde_create_large_kernel (vaddr, true);
+          page += PTSPAN / PGSIZE - 1;
+          continue;
+        }
+
       if (pd[pde_idx] == 0)
         {
           pt = palloc_get_page (PAL_ASSERT | PAL_ZERO);
@@ -252,6 +324,8 @@ parse_options (char **argv)
         swap_bdev_name = value;
 #endif
 #endif
+      else if (!strcmp (name, "-nopse"))
+        no_large_pages = true;
       else if (!strcmp (name, "-rs"))
         random_init (atoi (value));
       else if (!strcmp (name, "-mlfqs"))
@@ -259,6 +333,14 @@ parse_options (char **argv)
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+#endif
+#ifdef VM
+      else if (!strcmp (name, "-sl"))
+        stack_page_limit = atoi (value);
+      else if (!strcmp (name, "-vmstat"))
+        page_print_exit_stats = true;
+      else if (!strcmp (name, "-zswap"))
+        zswap_page_limit = atoi (value);
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
@@ -377,10 +459,16 @@ usage (void)
           "  -swap=BDEV         Use BDEV for swap instead of default.\n"
 #endif
 #endif
+          "  -nopse             Don't map the kernel with 4 MB pages.\n"
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+          "  -sl=COUNT          Limit user stacks to COUNT pages.\n"
+          "  -vmstat            Print paging statistics as processes exit.\n"
+          "  -zswap=PAGES       Keep up to PAGES compressed swap pages in RAM.\n"
 #endif
           );
   shutdown_power_off ();
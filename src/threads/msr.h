@@ -0,0 +1,20 @@
+#ifndef THREADS_MSR_H
+#define THREADS_MSR_H
+
+#include <stdint.h>
+
+/* Model-specific registers.  See [IA32-v3b] appendix B
+   "Model-Specific Registers (MSRs)". */
+#define MSR_SYSENTER_CS  0x174  /* Kernel code selector for SYSENTER. */
+#define MSR_SYSENTER_ESP 0x175  /* Kernel stack pointer for SYSENTER. */
+#define MSR_SYSENTER_EIP 0x176  /* Kernel entry point for SYSENTER. */
+
+/* Writes VALUE to model-specific register MSR. */
+static inline void
+wrmsr (uint32_t msr, uint64_t value)
+{
+  /* See [IA32-v2b] "WRMSR". */
+  asm volatile ("wrmsr" : : "c" (msr), "A" (value));
+}
+
+#endif /* threads/msr.h */
@@ -661,6 +661,21 @@ init_thread (struct thread *t, const char *name, int priority)
   t->wakeup_tick = 0;
   list_init(&t->acquired_lock_list);
 
+#ifdef USERPROG
+  t->process = t;
+  t->exit_status = -1;
+  list_init (&t->threads);
+  lock_init (&t->process_lock);
+  cond_init (&t->thread_exited);
+  list_init (&t->children);
+  t->wait_status = NULL;
+  t->fds = NULL;
+  t->fd_cap = 0;
+  t->fd_map = NULL;
+  t->fd_cloexec = NULL;
+  lock_init (&t->fds_lock);
+#endif
+
   t->nice = NICE_DEFAULT;
   t->recent_cpu = RECENT_CPU_DEFAULT;
 
@@ -4,7 +4,9 @@
 #include <debug.h>
 #include <list.h>
 #include <stdint.h>
+#include <vmstat.h>
 #include "threads/fixed-point.h"
+#include "threads/synch.h"
 
 /* States in a thread's life cycle. */
 enum thread_status
@@ -107,8 +109,44 @@ struct thread
     struct lock * waiting_lock;         /* Waiting to acquire this lock */
 
 #ifdef USERPROG
-    /* Owned by userprog/process.c. */
+    /* Owned by userprog/process.c.
+       The members from `exit_status' on, other than `user_esp',
+       belong to the whole process.  Only the copies in its first
+       thread, which every thread's `process' points to, are
+       used. */
     uint32_t *pagedir;                  /* Page directory. */
+    bool killed;                        /* Exit on return to user mode? */
+    struct thread *process;             /* First thread of process. */
+    int exit_status;                    /* Status reported on exit. */
+    struct file *executable;            /* Running executable. */
+    uint8_t *heap_start;                /* Start of heap, after data. */
+    uint8_t *brk;                       /* End of heap. */
+    struct list threads;                /* Threads from thread_create(). */
+    struct lock process_lock;           /* Protects `threads', `children',
+                                           and heap. */
+    struct condition thread_exited;     /* Signaled when one exits. */
+    struct list children;               /* Children's `wait_status'es. */
+    struct wait_status *wait_status;    /* Shared with parent, or null. */
+
+    /* Owned by userprog/syscall.c. */
+    struct file_descriptor **fds;       /* Open files, by handle. */
+    size_t fd_cap;                      /* Number of slots in `fds'. */
+    struct bitmap *fd_map;              /* Slots in use in `fds'. */
+    struct bitmap *fd_cloexec;          /* Close-on-exec slots. */
+    struct lock fds_lock;               /* Protects the four above. */
+
+    /* Owned by userprog/ring.c. */
+    struct ring_state *ring;            /* System call ring, or null. */
+#endif
+#ifdef VM
+    /* Owned by vm/page.c. */
+    struct hash *pages;                 /* Supplemental page table. */
+    struct list mappings;               /* File mappings in PAGES. */
+    struct lock page_lock;              /* Serializes paging of PAGES. */
+    void *user_esp;                     /* User %esp on syscall entry. */
+    struct vmstat vmstat;               /* Paging statistics. */
+    unsigned shared_rss;                /* Shared pages in vmstat.rss. */
+    int oom_adj;                        /* OOM score adjustment. */
 #endif
 
     /* Owned by thread.c. */
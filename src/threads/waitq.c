@@ -0,0 +1,167 @@
+#include "threads/waitq.h"
+#include <debug.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* Wait queues.
+
+   A wait queue lets a thread sleep until any one of several
+   objects may have changed state, instead of sleeping on just
+   one of them or checking them all over and over.  The thread
+   initializes a waiter and registers it, with one entry each,
+   on the wait queues of the objects it is interested in.  Then
+   it checks the objects, and if none is ready, it calls
+   waiter_sleep().  An object calls waitq_wake() on its wait
+   queue whenever it may have become ready, which wakes every
+   waiter registered on it.  Finally the thread removes its
+   entries.
+
+   A wakeup that comes between the thread's check and its call
+   to waiter_sleep() is not lost, because it leaves the waiter
+   marked as woken and waiter_sleep() then returns at once.
+
+   Wait queues may be woken by interrupt handlers, so they are
+   protected by turning interrupts off. */
+
+/* Waiters sleeping with a deadline, soonest first. */
+static struct list timed_waiters = LIST_INITIALIZER (timed_waiters);
+
+static void wake (struct waiter *);
+static bool deadline_less (const struct list_elem *,
+                           const struct list_elem *, void *aux);
+
+/* Initializes wait queue Q as empty. */
+void
+waitq_init (struct waitq *q)
+{
+  list_init (&q->entries);
+}
+
+/* Registers waiter W on wait queue Q, using entry E, which must
+   stay in place until passed to waitq_remove(). */
+void
+waitq_add (struct waitq *q, struct waiter *w, struct waitq_entry *e)
+{
+  enum intr_level old_level;
+
+  e->queue = q;
+  e->waiter = w;
+  old_level = intr_disable ();
+  list_push_back (&q->entries, &e->elem);
+  intr_set_level (old_level);
+}
+
+/* Removes entry E, if it was passed to waitq_add(), from its wait
+   queue.  An entry whose queue is null is ignored. */
+void
+waitq_remove (struct waitq_entry *e)
+{
+  enum intr_level old_level;
+
+  if (e->queue == NULL)
+    return;
+  old_level = intr_disable ();
+  list_remove (&e->elem);
+  intr_set_level (old_level);
+  e->queue = NULL;
+}
+
+/* Wakes every waiter registered on wait queue Q.
+   May be called from an interrupt handler. */
+void
+waitq_wake (struct waitq *q)
+{
+  enum intr_level old_level = intr_disable ();
+  struct list_elem *e;
+
+  for (e = list_begin (&q->entries); e != list_end (&q->entries);
+       e = list_next (e))
+    wake (list_entry (e, struct waitq_entry, elem)->waiter);
+  intr_set_level (old_level);
+}
+
+/* Initializes waiter W for the current thread. */
+void
+waiter_init (struct waiter *w)
+{
+  w->thread = thread_current ();
+  w->woken = false;
+  w->sleeping = false;
+}
+
+/* Sleeps until one of the wait queues that waiter W is
+   registered on is woken, or until timer tick DEADLINE, if
+   DEADLINE is nonnegative.  Returns immediately if a wait queue
+   was woken since the last call, or since waiter_init().
+   Returns true if a wait queue was woken, false if the deadline
+   passed first. */
+bool
+waiter_sleep (struct waiter *w, int64_t deadline)
+{
+  enum intr_level old_level;
+  bool woken;
+
+  ASSERT (w->thread == thread_current ());
+
+  old_level = intr_disable ();
+  if (!w->woken && (deadline < 0 || deadline > timer_ticks ()))
+    {
+      w->sleeping = true;
+      w->deadline = deadline;
+      if (deadline >= 0)
+        list_insert_ordered (&timed_waiters, &w->timer_elem,
+                             deadline_less, NULL);
+      thread_block ();
+    }
+  woken = w->woken;
+  w->woken = false;
+  intr_set_level (old_level);
+
+  return woken;
+}
+
+/* Wakes the waiters whose deadlines have passed by timer tick
+   TICKS.  Called by the timer interrupt handler. */
+void
+waiter_tick (int64_t ticks)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  while (!list_empty (&timed_waiters))
+    {
+      struct waiter *w = list_entry (list_front (&timed_waiters),
+                                     struct waiter, timer_elem);
+      if (w->deadline > ticks)
+        break;
+      list_pop_front (&timed_waiters);
+      w->sleeping = false;
+      thread_unblock (w->thread);
+    }
+}
+
+/* Marks waiter W as woken and unblocks its thread, if it is
+   sleeping.  Interrupts must be off. */
+static void
+wake (struct waiter *w)
+{
+  w->woken = true;
+  if (w->sleeping)
+    {
+      w->sleeping = false;
+      if (w->deadline >= 0)
+        list_remove (&w->timer_elem);
+      thread_unblock (w->thread);
+    }
+}
+
+/* Orders waiters by deadline. */
+static bool
+deadline_less (const struct list_elem *a_, const struct list_elem *b_,
+               void *aux UNUSED)
+{
+  const struct waiter *a = list_entry (a_, struct waiter, timer_elem);
+  const struct waiter *b = list_entry (b_, struct waiter, timer_elem);
+
+  return a->deadline < b->deadline;
+}
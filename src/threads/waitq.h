@@ -0,0 +1,42 @@
+#ifndef THREADS_WAITQ_H
+#define THREADS_WAITQ_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* A wait queue, belonging to an object that threads may want to
+   wait for, such as the console or a pipe. */
+struct waitq
+  {
+    struct list entries;        /* List of struct waitq_entry. */
+  };
+
+/* A thread waiting for any of several wait queues. */
+struct waiter
+  {
+    struct thread *thread;      /* Waiting thread. */
+    bool woken;                 /* Woken by a wait queue? */
+    bool sleeping;              /* Blocked in waiter_sleep()? */
+    int64_t deadline;           /* Timer tick to give up at. */
+    struct list_elem timer_elem; /* Element in list of timed waiters. */
+  };
+
+/* Registration of a waiter on one wait queue. */
+struct waitq_entry
+  {
+    struct list_elem elem;      /* Element in wait queue's list. */
+    struct waitq *queue;        /* Wait queue, or null if none. */
+    struct waiter *waiter;      /* Waiter to wake. */
+  };
+
+void waitq_init (struct waitq *);
+void waitq_add (struct waitq *, struct waiter *, struct waitq_entry *);
+void waitq_remove (struct waitq_entry *);
+void waitq_wake (struct waitq *);
+
+void waiter_init (struct waiter *);
+bool waiter_sleep (struct waiter *, int64_t deadline);
+void waiter_tick (int64_t ticks);
+
+#endif /* threads/waitq.h */
@@ -0,0 +1,431 @@
+#include "userprog/elf.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <list.h>
+#include <ring.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include <vdata.h>
+#include "filesys/file.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* ELF executables.
+
+   elf_get() reads and validates the headers of an executable
+   and returns its layout: the entry point and the pages that
+   each loadable segment occupies.  Programs tend to be run over
+   and over, so the layouts of the ELF_CACHE_SIZE executables
+   run most recently are kept in a cache, keyed by inode, and a
+   program run again does not read its headers at all.  Writing
+   or removing an executable drops its layout from the cache.
+
+   The pages of the segments themselves are not kept here.  With
+   virtual memory, their read-only pages are shared among the
+   processes running an executable, and cached for a while after
+   the last one exits, by vm/share.c. */
+
+/* We load ELF binaries.  The following definitions are taken
+   from the ELF specification, [ELF1], more-or-less verbatim.  */
+
+/* ELF types.  See [ELF1] 1-2. */
+typedef uint32_t Elf32_Word, Elf32_Addr, Elf32_Off;
+typedef uint16_t Elf32_Half;
+
+/* For use with ELF types in printf(). */
+#define PE32Wx PRIx32   /* Print Elf32_Word in hexadecimal. */
+#define PE32Ax PRIx32   /* Print Elf32_Addr in hexadecimal. */
+#define PE32Ox PRIx32   /* Print Elf32_Off in hexadecimal. */
+#define PE32Hx PRIx16   /* Print Elf32_Half in hexadecimal. */
+
+/* Executable header.  See [ELF1] 1-4 to 1-8.
+   This appears at the very beginning of an ELF binary. */
+struct Elf32_Ehdr
+  {
+    unsigned char e_ident[16];
+    Elf32_Half    e_type;
+    Elf32_Half    e_machine;
+    Elf32_Word    e_version;
+    Elf32_Addr    e_entry;
+    Elf32_Off     e_phoff;
+    Elf32_Off     e_shoff;
+    Elf32_Word    e_flags;
+    Elf32_Half    e_ehsize;
+    Elf32_Half    e_phentsize;
+    Elf32_Half    e_phnum;
+    Elf32_Half    e_shentsize;
+    Elf32_Half    e_shnum;
+    Elf32_Half    e_shstrndx;
+  };
+
+/* Program header.  See [ELF1] 2-2 to 2-4.
+   There are e_phnum of these, starting at file offset e_phoff
+   (see [ELF1] 1-6). */
+struct Elf32_Phdr
+  {
+    Elf32_Word p_type;
+    Elf32_Off  p_offset;
+    Elf32_Addr p_vaddr;
+    Elf32_Addr p_paddr;
+    Elf32_Word p_filesz;
+    Elf32_Word p_memsz;
+    Elf32_Word p_flags;
+    Elf32_Word p_align;
+  };
+
+/* Values for p_type.  See [ELF1] 2-3. */
+#define PT_NULL    0            /* Ignore. */
+#define PT_LOAD    1            /* Loadable segment. */
+#define PT_DYNAMIC 2            /* Dynamic linking info. */
+#define PT_INTERP  3            /* Name of dynamic loader. */
+#define PT_NOTE    4            /* Auxiliary info. */
+#define PT_SHLIB   5            /* Reserved. */
+#define PT_PHDR    6            /* Program header table. */
+#define PT_STACK   0x6474e551   /* Stack segment. */
+
+/* Flags for p_flags.  See [ELF3] 2-3 and 2-4. */
+#define PF_X 1          /* Executable. */
+#define PF_W 2          /* Writable. */
+#define PF_R 4          /* Readable. */
+
+/* Maximum number of layouts kept in the cache. */
+#define ELF_CACHE_SIZE 16
+
+/* The layout of an executable. */
+struct cached_image
+  {
+    struct list_elem elem;      /* Element in `cache', if cached. */
+    struct inode *inode;        /* The executable. */
+    int ref_cnt;                /* Number of elf_get() callers. */
+    bool cached;                /* In `cache'? */
+    struct elf_image image;     /* The layout itself. */
+  };
+
+/* Cached layouts, most recently used first. */
+static struct list cache;
+static size_t cache_cnt;
+
+/* Incremented by each elf_invalidate(), so that a layout read
+   meanwhile is not cached. */
+static unsigned invalidate_cnt;
+
+static struct lock elf_lock;    /* Protects the members above. */
+
+/* Statistics. */
+static long long hit_cnt;       /* # of layouts found in the cache. */
+static long long miss_cnt;      /* # of layouts read from files. */
+
+static struct cached_image *parse (struct file *);
+static bool validate_segment (const struct Elf32_Phdr *, struct file *);
+static void add_segment (struct elf_image *, const struct Elf32_Phdr *);
+static struct cached_image *find (struct inode *);
+static void uncache (struct cached_image *);
+static void free_image (struct cached_image *);
+
+/* Initializes the cache of executable layouts. */
+void
+elf_init (void)
+{
+  list_init (&cache);
+  lock_init (&elf_lock);
+}
+
+/* Returns the layout of executable FILE, reading it from FILE
+   unless it is cached.  The caller must deny writes to FILE
+   first, and must release the layout with elf_put().  Returns a
+   null pointer if FILE is not a valid executable or memory is
+   exhausted. */
+const struct elf_image *
+elf_get (struct file *file)
+{
+  struct inode *inode = file_get_inode (file);
+  struct cached_image *ci, *evicted = NULL;
+  unsigned old_invalidate_cnt;
+
+  lock_acquire (&elf_lock);
+  ci = find (inode);
+  if (ci != NULL)
+    {
+      list_remove (&ci->elem);
+      list_push_front (&cache, &ci->elem);
+      ci->ref_cnt++;
+      hit_cnt++;
+      lock_release (&elf_lock);
+      return &ci->image;
+    }
+  miss_cnt++;
+  old_invalidate_cnt = invalidate_cnt;
+  lock_release (&elf_lock);
+
+  ci = parse (file);
+  if (ci == NULL)
+    return NULL;
+  ci->inode = inode_reopen (inode);
+  ci->ref_cnt = 1;
+  ci->cached = false;
+
+  /* Cache the layout, unless another process cached it first or
+     it might be stale already. */
+  lock_acquire (&elf_lock);
+  if (invalidate_cnt == old_invalidate_cnt && find (inode) == NULL)
+    {
+      list_push_front (&cache, &ci->elem);
+      ci->cached = true;
+      if (++cache_cnt > ELF_CACHE_SIZE)
+        {
+          evicted = list_entry (list_back (&cache),
+                                struct cached_image, elem);
+          uncache (evicted);
+          if (evicted->ref_cnt > 0)
+            evicted = NULL;
+        }
+    }
+  lock_release (&elf_lock);
+
+  if (evicted != NULL)
+    free_image (evicted);
+  return &ci->image;
+}
+
+/* Releases IMAGE, which elf_get() returned. */
+void
+elf_put (const struct elf_image *image)
+{
+  struct cached_image *ci;
+  bool dead;
+
+  if (image == NULL)
+    return;
+
+  ci = (struct cached_image *) ((uint8_t *) image
+                                - offsetof (struct cached_image, image));
+  lock_acquire (&elf_lock);
+  ASSERT (ci->ref_cnt > 0);
+  dead = --ci->ref_cnt == 0 && !ci->cached;
+  lock_release (&elf_lock);
+
+  if (dead)
+    free_image (ci);
+}
+
+/* Drops the layout of INODE, whose contents have changed or
+   which has been removed, from the cache. */
+void
+elf_invalidate (struct inode *inode)
+{
+  struct cached_image *ci;
+
+  lock_acquire (&elf_lock);
+  invalidate_cnt++;
+  ci = find (inode);
+  if (ci != NULL)
+    {
+      uncache (ci);
+      if (ci->ref_cnt > 0)
+        ci = NULL;
+    }
+  lock_release (&elf_lock);
+
+  if (ci != NULL)
+    free_image (ci);
+}
+
+/* Prints executable layout statistics. */
+void
+elf_print_stats (void)
+{
+  printf ("ELF: %lld layouts found in cache, %lld read\n",
+          hit_cnt, miss_cnt);
+}
+
+/* Reads and verifies the executable header and the program
+   headers of FILE and returns a new, uncached layout for it,
+   with only the `image' member initialized.  Returns a null
+   pointer if FILE is not a valid executable or memory is
+   exhausted. */
+static struct cached_image *
+parse (struct file *file)
+{
+  struct Elf32_Ehdr ehdr;
+  struct Elf32_Phdr *phdrs;
+  struct cached_image *ci = NULL;
+  size_t phdrs_size, load_cnt;
+  int i;
+
+  /* Read and verify executable header. */
+  if (file_read_at (file, &ehdr, sizeof ehdr, 0) != sizeof ehdr
+      || memcmp (ehdr.e_ident, "\177ELF\1\1\1", 7)
+      || ehdr.e_type != 2
+      || ehdr.e_machine != 3
+      || ehdr.e_version != 1
+      || ehdr.e_phentsize != sizeof (struct Elf32_Phdr)
+      || ehdr.e_phnum == 0
+      || ehdr.e_phnum > 1024
+      || ehdr.e_phoff > (Elf32_Off) file_length (file))
+    return NULL;
+
+  /* Read the program headers, all at once. */
+  phdrs_size = ehdr.e_phnum * sizeof *phdrs;
+  phdrs = malloc (phdrs_size);
+  if (phdrs == NULL)
+    return NULL;
+  if (file_read_at (file, phdrs, phdrs_size, ehdr.e_phoff)
+      != (off_t) phdrs_size)
+    goto done;
+
+  /* Verify them, counting the loadable segments. */
+  load_cnt = 0;
+  for (i = 0; i < ehdr.e_phnum; i++)
+    switch (phdrs[i].p_type)
+      {
+      case PT_NULL:
+      case PT_NOTE:
+      case PT_PHDR:
+      case PT_STACK:
+      default:
+        /* Ignore this segment. */
+        break;
+      case PT_DYNAMIC:
+      case PT_INTERP:
+      case PT_SHLIB:
+        goto done;
+      case PT_LOAD:
+        if (!validate_segment (&phdrs[i], file))
+          goto done;
+        load_cnt++;
+        break;
+      }
+
+  /* Allocate the layout with room for its segments. */
+  ci = malloc (sizeof *ci + load_cnt * sizeof *ci->image.segments);
+  if (ci == NULL)
+    goto done;
+  ci->image.entry = (void (*) (void)) ehdr.e_entry;
+  ci->image.segment_cnt = 0;
+  ci->image.segments = (struct elf_segment *) (ci + 1);
+  for (i = 0; i < ehdr.e_phnum; i++)
+    if (phdrs[i].p_type == PT_LOAD)
+      add_segment (&ci->image, &phdrs[i]);
+
+ done:
+  free (phdrs);
+  return ci;
+}
+
+/* Checks whether PHDR describes a valid, loadable segment in
+   FILE and returns true if so, false otherwise. */
+static bool
+validate_segment (const struct Elf32_Phdr *phdr, struct file *file)
+{
+  /* p_offset and p_vaddr must have the same page offset. */
+  if ((phdr->p_offset & PGMASK) != (phdr->p_vaddr & PGMASK))
+    return false;
+
+  /* p_offset must point within FILE. */
+  if (phdr->p_offset > (Elf32_Off) file_length (file))
+    return false;
+
+  /* p_memsz must be at least as big as p_filesz. */
+  if (phdr->p_memsz < phdr->p_filesz)
+    return false;
+
+  /* The segment must not be empty. */
+  if (phdr->p_memsz == 0)
+    return false;
+
+  /* The virtual memory region must both start and end within the
+     user address space range. */
+  if (!is_user_vaddr ((void *) phdr->p_vaddr))
+    return false;
+  if (!is_user_vaddr ((void *) (phdr->p_vaddr + phdr->p_memsz)))
+    return false;
+
+  /* The region cannot "wrap around" across the kernel virtual
+     address space. */
+  if (phdr->p_vaddr + phdr->p_memsz < phdr->p_vaddr)
+    return false;
+
+  /* The region cannot overlap the kernel data page or the
+     system call ring, which follows it. */
+  if (phdr->p_vaddr < (Elf32_Addr) RING_ADDR + PGSIZE
+      && phdr->p_vaddr + phdr->p_memsz > (Elf32_Addr) VDATA_ADDR)
+    return false;
+
+  /* Disallow mapping page 0.
+     Not only is it a bad idea to map page 0, but if we allowed
+     it then user code that passed a null pointer to system calls
+     could quite likely panic the kernel by way of null pointer
+     assertions in memcpy(), etc. */
+  if (phdr->p_vaddr < PGSIZE)
+    return false;
+
+  /* It's okay. */
+  return true;
+}
+
+/* Appends the pages that valid loadable segment PHDR occupies to
+   IMAGE's segments. */
+static void
+add_segment (struct elf_image *image, const struct Elf32_Phdr *phdr)
+{
+  struct elf_segment *s = &image->segments[image->segment_cnt++];
+  uint32_t page_offset = phdr->p_vaddr & PGMASK;
+
+  s->file_page = phdr->p_offset & ~PGMASK;
+  s->mem_page = (uint8_t *) (phdr->p_vaddr & ~PGMASK);
+  s->writable = (phdr->p_flags & PF_W) != 0;
+  if (phdr->p_filesz > 0)
+    {
+      /* Normal segment.
+         Read initial part from disk and zero the rest. */
+      s->read_bytes = page_offset + phdr->p_filesz;
+      s->zero_bytes = (ROUND_UP (page_offset + phdr->p_memsz, PGSIZE)
+                       - s->read_bytes);
+    }
+  else
+    {
+      /* Entirely zero.
+         Don't read anything from disk. */
+      s->read_bytes = 0;
+      s->zero_bytes = ROUND_UP (page_offset + phdr->p_memsz, PGSIZE);
+    }
+}
+
+/* Returns the cached layout of INODE, or a null pointer if there
+   is none.  Caller must hold elf_lock. */
+static struct cached_image *
+find (struct inode *inode)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&cache); e != list_end (&cache); e = list_next (e))
+    {
+      struct cached_image *ci = list_entry (e, struct cached_image, elem);
+      if (ci->inode == inode)
+        return ci;
+    }
+  return NULL;
+}
+
+/* Removes CI from the cache.  Caller must hold elf_lock. */
+static void
+uncache (struct cached_image *ci)
+{
+  ASSERT (ci->cached);
+  list_remove (&ci->elem);
+  ci->cached = false;
+  cache_cnt--;
+}
+
+/* Frees CI, which must be neither cached nor in use.  Must be
+   called without elf_lock, since closing the inode may write
+   the free map. */
+static void
+free_image (struct cached_image *ci)
+{
+  inode_close (ci->inode);
+  free (ci);
+}
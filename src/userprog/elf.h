@@ -0,0 +1,36 @@
+#ifndef USERPROG_ELF_H
+#define USERPROG_ELF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct file;
+struct inode;
+
+/* A loadable segment of an executable, validated and rounded
+   out to whole pages. */
+struct elf_segment
+  {
+    uint32_t file_page;         /* Page-aligned offset in the file. */
+    uint8_t *mem_page;          /* Page-aligned user address. */
+    uint32_t read_bytes;        /* Bytes to read from the file... */
+    uint32_t zero_bytes;        /* ...followed by bytes to zero. */
+    bool writable;              /* Writable by the process? */
+  };
+
+/* The layout of an executable, as load() needs it. */
+struct elf_image
+  {
+    void (*entry) (void);       /* Entry point. */
+    size_t segment_cnt;         /* Number of loadable segments. */
+    struct elf_segment *segments;       /* Loadable segments. */
+  };
+
+void elf_init (void);
+const struct elf_image *elf_get (struct file *);
+void elf_put (const struct elf_image *);
+void elf_invalidate (struct inode *);
+void elf_print_stats (void);
+
+#endif /* userprog/elf.h */
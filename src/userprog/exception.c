@@ -2,8 +2,13 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
+#include "userprog/process.h"
+#include "userprog/uaccess.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -89,7 +94,7 @@ kill (struct intr_frame *f)
       printf ("%s: dying due to interrupt %#04x (%s).\n",
               thread_name (), f->vec_no, intr_name (f->vec_no));
       intr_dump_frame (f);
-      thread_exit (); 
+      process_terminate (-1); 
 
     case SEL_KCSEG:
       /* Kernel's code segment, which indicates a kernel bug.
@@ -148,6 +153,23 @@ page_fault (struct intr_frame *f)
   write = (f->error_code & PF_W) != 0;
   user = (f->error_code & PF_U) != 0;
 
+#ifdef VM
+  /* Bring in the page, grow the stack, or give a page of zeros
+     its own frame on its first write, if that's what the access
+     needs.  F->esp is only meaningful for faults in user
+     mode; when the kernel faults on a user address during a
+     system call, use the user stack pointer saved on entry. */
+  if ((not_present || write)
+      && page_in (fault_addr, write,
+                  user ? f->esp : thread_current ()->user_esp))
+    return;
+#endif
+
+  /* If the kernel faulted while copying to or from user memory
+     on behalf of a system call, fail the copy. */
+  if (!user && uaccess_fixup (f, fault_addr))
+    return;
+
   /* To implement virtual memory, delete the rest of the function
      body, and replace it with code that brings in the page to
      which fault_addr refers. */
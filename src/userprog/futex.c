@@ -0,0 +1,154 @@
+#include "userprog/futex.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "userprog/process.h"
+#include "userprog/uaccess.h"
+
+/* Futexes.
+
+   A futex is an int in user memory that the threads of a
+   process use to build mutexes and other synchronization,
+   entering the kernel only when a thread has to wait.
+   futex_wait() puts the running thread to sleep on a futex's
+   address, as long as the futex still holds the value that the
+   caller expects, and futex_wake() wakes threads sleeping on an
+   address.  The check and the sleep are atomic with respect to
+   futex_wake(), so a thread that changes the futex and then
+   calls futex_wake() cannot miss a thread that saw the old
+   value.
+
+   Sleeping threads are kept in a table of lists, hashed on
+   their process and futex address. */
+
+/* Number of lists in the table. */
+#define FUTEX_BUCKETS 64
+
+/* A thread sleeping on a futex. */
+struct futex_waiter
+  {
+    struct list_elem elem;      /* Element in a bucket's list. */
+    struct thread *process;     /* Process, as its first thread. */
+    const int *uaddr;           /* User address of the futex. */
+    struct semaphore sema;      /* Upped to wake the thread. */
+  };
+
+static struct list buckets[FUTEX_BUCKETS];
+static struct lock futex_lock;  /* Protects `buckets'. */
+
+static struct list *bucket (struct thread *process, const int *uaddr);
+static void wake (struct futex_waiter *);
+
+/* Initializes the futex table. */
+void
+futex_init (void)
+{
+  size_t i;
+
+  for (i = 0; i < FUTEX_BUCKETS; i++)
+    list_init (&buckets[i]);
+  lock_init (&futex_lock);
+}
+
+/* If the int at user address UADDR equals VAL, sleeps until
+   futex_wake() is called for UADDR or the process is killed,
+   and sets *WOKEN to true.  Otherwise, sets *WOKEN to false at
+   once.  Returns false if UADDR is not valid user memory. */
+bool
+futex_wait (const int *uaddr, int val, bool *woken)
+{
+  struct futex_waiter w;
+  bool sleep;
+
+  /* Pin the futex, so that reading it cannot fault, and in
+     particular cannot wait for memory, while we hold
+     futex_lock. */
+  if (!uaccess_pin ((void *) uaddr, sizeof *uaddr, false))
+    return false;
+
+  lock_acquire (&futex_lock);
+  *woken = *uaddr == val;
+  sleep = *woken && !thread_current ()->killed;
+  if (sleep)
+    {
+      w.process = process_current ();
+      w.uaddr = uaddr;
+      sema_init (&w.sema, 0);
+      list_push_back (bucket (w.process, uaddr), &w.elem);
+    }
+  lock_release (&futex_lock);
+  uaccess_unpin ((void *) uaddr, sizeof *uaddr);
+
+  if (sleep)
+    sema_down (&w.sema);
+  return true;
+}
+
+/* Wakes up to CNT threads of the current process that sleep on
+   the futex at user address UADDR, and returns the number
+   woken. */
+int
+futex_wake (const int *uaddr, int cnt)
+{
+  struct thread *process = process_current ();
+  struct list *list = bucket (process, uaddr);
+  struct list_elem *e;
+  int woken = 0;
+
+  lock_acquire (&futex_lock);
+  for (e = list_begin (list); e != list_end (list) && woken < cnt; )
+    {
+      struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+      e = list_next (e);
+      if (w->process == process && w->uaddr == uaddr)
+        {
+          wake (w);
+          woken++;
+        }
+    }
+  lock_release (&futex_lock);
+  return woken;
+}
+
+/* Wakes all the threads of PROCESS, given as its first thread,
+   that sleep on futexes, because it is being killed. */
+void
+futex_wake_process (struct thread *process)
+{
+  size_t i;
+
+  lock_acquire (&futex_lock);
+  for (i = 0; i < FUTEX_BUCKETS; i++)
+    {
+      struct list_elem *e;
+
+      for (e = list_begin (&buckets[i]); e != list_end (&buckets[i]); )
+        {
+          struct futex_waiter *w = list_entry (e, struct futex_waiter,
+                                               elem);
+          e = list_next (e);
+          if (w->process == process)
+            wake (w);
+        }
+    }
+  lock_release (&futex_lock);
+}
+
+/* Returns the list for the futex at UADDR in PROCESS. */
+static struct list *
+bucket (struct thread *process, const int *uaddr)
+{
+  return &buckets[hash_int ((int) uaddr ^ (int) process) % FUTEX_BUCKETS];
+}
+
+/* Removes W from its list and wakes its thread.  W's thread may
+   return as soon as it is woken, so W must not be used
+   afterward.  futex_lock must be held. */
+static void
+wake (struct futex_waiter *w)
+{
+  list_remove (&w->elem);
+  sema_up (&w->sema);
+}
@@ -1,12 +1,24 @@
 #include "userprog/pagedir.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
 
+/* Clearing more than this many pages at once flushes the whole
+   TLB instead of invalidating each page with INVLPG. */
+#define FLUSH_THRESHOLD 32
+
+/* TLB statistics. */
+static long long page_invalidate_cnt;   /* Single-page invalidations. */
+static long long flush_cnt;             /* Full TLB flushes. */
+static long long activate_skip_cnt;     /* CR3 loads avoided. */
+
 static uint32_t *active_pd (void);
+static void load_pd (uint32_t *);
+static void invalidate_page (uint32_t *, const void *);
 static void invalidate_pagedir (uint32_t *);
 
 /* Creates a new page directory that has mappings for kernel
@@ -66,6 +78,12 @@ lookup_page (uint32_t *pd, const void *vaddr, bool create)
   /* Check for a page table for VADDR.
      If one is missing, create one if requested. */
   pde = pd + pd_no (vaddr);
+  if (*pde & PTE_PS)
+    {
+      /* A large kernel page has no page table entry. */
+      ASSERT (!create);
+      return NULL;
+    }
   if (*pde == 0) 
     {
       if (create)
@@ -152,10 +170,51 @@ pagedir_clear_page (uint32_t *pd, void *upage)
   if (pte != NULL && (*pte & PTE_P) != 0)
     {
       *pte &= ~PTE_P;
-      invalidate_pagedir (pd);
+      invalidate_page (pd, upage);
     }
 }
 
+/* Marks the PAGE_CNT user virtual pages starting at UPAGE "not
+   present" in page directory PD, like pagedir_clear_page().
+   Invalidates the TLB once for the whole range if that is
+   cheaper than invalidating each page.  Returns the number of
+   pages that were present. */
+size_t
+pagedir_clear_range (uint32_t *pd, void *upage, size_t page_cnt) 
+{
+  uint8_t *start = upage;
+  size_t cleared = 0;
+  size_t i;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (page_cnt <= (size_t) ((uint8_t *) PHYS_BASE - start) / PGSIZE);
+
+  for (i = 0; i < page_cnt; i++) 
+    {
+      uint32_t *pte = lookup_page (pd, start + i * PGSIZE, false);
+      if (pte != NULL && (*pte & PTE_P) != 0)
+        {
+          *pte &= ~PTE_P;
+          cleared++;
+        }
+    }
+
+  if (cleared > FLUSH_THRESHOLD)
+    invalidate_pagedir (pd);
+  else if (cleared > 0)
+    for (i = 0; i < page_cnt; i++)
+      invalidate_page (pd, start + i * PGSIZE);
+  return cleared;
+}
+
+/* Returns true if virtual page VPAGE is mapped writable in PD. */
+bool
+pagedir_is_writable (uint32_t *pd, const void *vpage) 
+{
+  uint32_t *pte = lookup_page (pd, vpage, false);
+  return pte != NULL && (*pte & (PTE_P | PTE_W)) == (PTE_P | PTE_W);
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PD is dirty,
    that is, if the page has been modified since the PTE was
    installed.
@@ -180,7 +239,7 @@ pagedir_set_dirty (uint32_t *pd, const void *vpage, bool dirty)
       else 
         {
           *pte &= ~(uint32_t) PTE_D;
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
         }
     }
 }
@@ -209,25 +268,35 @@ pagedir_set_accessed (uint32_t *pd, const void *vpage, bool accessed)
       else 
         {
           *pte &= ~(uint32_t) PTE_A; 
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
         }
     }
 }
 
 /* Loads page directory PD into the CPU's page directory base
-   register. */
+   register, unless it is already loaded.  Reloading the active
+   page directory would flush the TLB for nothing, which happens
+   on every switch between kernel threads and between threads
+   that share an address space. */
 void
 pagedir_activate (uint32_t *pd) 
 {
   if (pd == NULL)
     pd = init_page_dir;
 
-  /* Store the physical address of the page directory into CR3
-     aka PDBR (page directory base register).  This activates our
-     new page tables immediately.  See [IA32-v2a] "MOV--Move
-     to/from Control Registers" and [IA32-v3a] 3.7.5 "Base
-     Address of the Page Directory". */
-  asm volatile ("movl %0, %%cr3" : : "r" (vtop (pd)) : "memory");
+  if (active_pd () != pd)
+    load_pd (pd);
+  else
+    activate_skip_cnt++;
+}
+
+/* Prints TLB statistics. */
+void
+pagedir_print_stats (void) 
+{
+  printf ("TLB: %lld page invalidations, %lld flushes, "
+          "%lld reloads avoided\n",
+          page_invalidate_cnt, flush_cnt, activate_skip_cnt);
 }
 
 /* Returns the currently active page directory. */
@@ -243,14 +312,39 @@ active_pd (void)
   return ptov (pd);
 }
 
-/* Seom page table changes can cause the CPU's translation
+/* Stores the physical address of page directory PD into CR3 aka
+   PDBR (page directory base register).  This activates our new
+   page tables immediately and flushes the TLB.  See [IA32-v2a]
+   "MOV--Move to/from Control Registers" and [IA32-v3a] 3.7.5
+   "Base Address of the Page Directory". */
+static void
+load_pd (uint32_t *pd) 
+{
+  asm volatile ("movl %0, %%cr3" : : "r" (vtop (pd)) : "memory");
+}
+
+/* Some page table changes can cause the CPU's translation
    lookaside buffer (TLB) to become out-of-sync with the page
-   table.  When this happens, we have to "invalidate" the TLB by
-   re-activating it.
+   table.  When this happens, we have to "invalidate" the stale
+   TLB entries.
+
+   This function invalidates the TLB entry for virtual page VPAGE
+   if PD is the active page directory.  (If PD is not active then
+   its entries are not in the TLB, so there is no need to
+   invalidate anything.)  INVLPG leaves the rest of the TLB
+   intact.  See [IA32-v2a] "INVLPG--Invalidate TLB Entry". */
+static void
+invalidate_page (uint32_t *pd, const void *vpage) 
+{
+  if (active_pd () == pd) 
+    {
+      asm volatile ("invlpg (%0)" : : "r" (vpage) : "memory");
+      page_invalidate_cnt++;
+    }
+}
 
-   This function invalidates the TLB if PD is the active page
-   directory.  (If PD is not active then its entries are not in
-   the TLB, so there is no need to invalidate anything.) */
+/* Invalidates the entire TLB if PD is the active page
+   directory. */
 static void
 invalidate_pagedir (uint32_t *pd) 
 {
@@ -258,6 +352,7 @@ invalidate_pagedir (uint32_t *pd)
     {
       /* Re-activating PD clears the TLB.  See [IA32-v3a] 3.12
          "Translation Lookaside Buffers (TLBs)". */
-      pagedir_activate (pd);
+      load_pd (pd);
+      flush_cnt++;
     } 
 }
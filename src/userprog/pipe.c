@@ -0,0 +1,304 @@
+#include "userprog/pipe.h"
+#include <debug.h>
+#include <poll.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "threads/waitq.h"
+#include "userprog/pagedir.h"
+
+/* Pipes.
+
+   A pipe carries bytes from the processes holding its write end
+   to those holding its read end, through a buffer of PIPE_SIZE
+   bytes used as a ring.  A read waits until there is data or
+   until no writers are left, in which case it returns 0 for end
+   of file, and then takes as much as it can.  A write waits for
+   room until all of its data is in the pipe, or until no readers
+   are left.  The pipe's wait queue is woken on each of these
+   changes, for the sake of poll().
+
+   When a reader has to wait for an empty pipe, it leaves its
+   buffer with the pipe, and the next writer copies its data
+   straight into that buffer instead of into the pipe's own, so
+   that the data is copied once rather than twice.  The writer
+   runs in another process, so it reaches the reader's buffer
+   through the kernel's mapping of its frames.
+
+   Callers must pin the user buffers they pass in with
+   uaccess_pin(), so that the copies here never fault while
+   holding a pipe's lock and so that the buffer of a waiting
+   reader stays put. */
+
+/* Size of a pipe's buffer. */
+#define PIPE_SIZE PGSIZE
+
+/* A reader waiting for a writer to fill its buffer. */
+struct pipe_reader
+  {
+    uint32_t *pagedir;          /* Reader's page directory. */
+    uint8_t *ubuf;              /* Reader's buffer. */
+    size_t size;                /* Size of UBUF. */
+    size_t done;                /* Bytes copied into UBUF. */
+  };
+
+/* A pipe. */
+struct pipe
+  {
+    struct lock lock;           /* Protects all the members below. */
+    struct condition readable;  /* Signaled for data or end of file. */
+    struct condition writable;  /* Signaled for room or no readers. */
+    uint8_t *buf;               /* PIPE_SIZE bytes of buffer. */
+    size_t start;               /* Offset of first byte in BUF. */
+    size_t used;                /* Number of bytes in BUF. */
+    int reader_cnt;             /* Number of open read ends. */
+    int writer_cnt;             /* Number of open write ends. */
+    struct pipe_reader *reader; /* Waiting reader, or null. */
+    struct waitq waitq;         /* Woken whenever the above change. */
+  };
+
+static void copy_user (uint32_t *pd, uint8_t *ubuf, uint8_t *kbuf,
+                       size_t size, bool to_user);
+
+/* Creates and returns a new, empty pipe with one read end and
+   one write end open, or returns a null pointer if memory is
+   exhausted. */
+struct pipe *
+pipe_create (void)
+{
+  struct pipe *p = malloc (sizeof *p);
+  if (p == NULL)
+    return NULL;
+  p->buf = palloc_get_page (0);
+  if (p->buf == NULL)
+    {
+      free (p);
+      return NULL;
+    }
+  lock_init (&p->lock);
+  cond_init (&p->readable);
+  cond_init (&p->writable);
+  p->start = 0;
+  p->used = 0;
+  p->reader_cnt = 1;
+  p->writer_cnt = 1;
+  p->reader = NULL;
+  waitq_init (&p->waitq);
+  return p;
+}
+
+/* Closes a write end of pipe P, if WRITE_END is true, or a read
+   end otherwise.  Frees P once its last end is closed. */
+void
+pipe_close (struct pipe *p, bool write_end)
+{
+  bool last;
+
+  lock_acquire (&p->lock);
+  if (write_end)
+    {
+      if (--p->writer_cnt == 0)
+        cond_broadcast (&p->readable, &p->lock);
+    }
+  else
+    {
+      if (--p->reader_cnt == 0)
+        cond_broadcast (&p->writable, &p->lock);
+    }
+  waitq_wake (&p->waitq);
+  last = p->reader_cnt == 0 && p->writer_cnt == 0;
+  lock_release (&p->lock);
+
+  if (last)
+    {
+      palloc_free_page (p->buf);
+      free (p);
+    }
+}
+
+/* Reads up to SIZE bytes from pipe P into pinned user buffer
+   UBUF, waiting until there is data to read.  Returns the number
+   of bytes read, which is 0 at end of file. */
+int
+pipe_read (struct pipe *p, void *ubuf, size_t size)
+{
+  uint32_t *pd = thread_current ()->pagedir;
+  struct pipe_reader r;
+  int result;
+
+  if (size == 0)
+    return 0;
+
+  r.pagedir = pd;
+  r.ubuf = ubuf;
+  r.size = size;
+  r.done = 0;
+
+  lock_acquire (&p->lock);
+  for (;;)
+    {
+      if (r.done > 0)
+        {
+          /* A writer filled our buffer directly. */
+          result = r.done;
+          break;
+        }
+      else if (p->used > 0)
+        {
+          size_t cnt = p->used < size ? p->used : size;
+          size_t first = PIPE_SIZE - p->start;
+
+          if (first > cnt)
+            first = cnt;
+          copy_user (pd, r.ubuf, p->buf + p->start, first, true);
+          copy_user (pd, r.ubuf + first, p->buf, cnt - first, true);
+          p->start = (p->start + cnt) % PIPE_SIZE;
+          p->used -= cnt;
+          cond_broadcast (&p->writable, &p->lock);
+          waitq_wake (&p->waitq);
+          result = cnt;
+          break;
+        }
+      else if (p->writer_cnt == 0)
+        {
+          result = 0;
+          break;
+        }
+
+      if (p->reader == NULL)
+        p->reader = &r;
+      cond_wait (&p->readable, &p->lock);
+    }
+  if (p->reader == &r)
+    p->reader = NULL;
+  lock_release (&p->lock);
+  return result;
+}
+
+/* Writes the SIZE bytes in pinned user buffer UBUF to pipe P,
+   waiting for room as necessary.  Returns the number of bytes
+   written, which is less than SIZE only if the last read end is
+   closed first, or -1 if no read end is open to begin with. */
+int
+pipe_write (struct pipe *p, const void *ubuf_, size_t size)
+{
+  uint8_t *ubuf = (uint8_t *) ubuf_;
+  uint32_t *pd = thread_current ()->pagedir;
+  size_t done = 0;
+
+  lock_acquire (&p->lock);
+  if (p->reader_cnt == 0)
+    {
+      lock_release (&p->lock);
+      return -1;
+    }
+  while (done < size && p->reader_cnt > 0)
+    {
+      if (p->reader != NULL)
+        {
+          /* Hand data straight to the waiting reader.  A reader
+             only waits when the pipe is empty, so no data can be
+             ahead of ours. */
+          struct pipe_reader *r = p->reader;
+          size_t cnt = size - done < r->size ? size - done : r->size;
+          size_t ofs;
+
+          ASSERT (p->used == 0);
+          for (ofs = 0; ofs < cnt; )
+            {
+              uint8_t *kpage = pagedir_get_page (r->pagedir, r->ubuf + ofs);
+              size_t chunk = PGSIZE - pg_ofs (r->ubuf + ofs);
+
+              ASSERT (kpage != NULL);
+              if (chunk > cnt - ofs)
+                chunk = cnt - ofs;
+              copy_user (pd, ubuf + done + ofs, kpage, chunk, false);
+              ofs += chunk;
+            }
+          r->done = cnt;
+          p->reader = NULL;
+          done += cnt;
+          cond_broadcast (&p->readable, &p->lock);
+        }
+      else if (p->used < PIPE_SIZE)
+        {
+          size_t end = (p->start + p->used) % PIPE_SIZE;
+          size_t cnt = PIPE_SIZE - p->used;
+          size_t first;
+
+          if (cnt > size - done)
+            cnt = size - done;
+          first = PIPE_SIZE - end < cnt ? PIPE_SIZE - end : cnt;
+          copy_user (pd, ubuf + done, p->buf + end, first, false);
+          copy_user (pd, ubuf + done + first, p->buf, cnt - first, false);
+          p->used += cnt;
+          done += cnt;
+          cond_broadcast (&p->readable, &p->lock);
+          waitq_wake (&p->waitq);
+        }
+      else
+        cond_wait (&p->writable, &p->lock);
+    }
+  lock_release (&p->lock);
+  return done;
+}
+
+/* Returns the poll() events that apply to the write end of pipe
+   P, if WRITE_END is true, or to its read end otherwise.  If W
+   is nonnull, first registers it, using entry E, to be woken
+   when the pipe changes. */
+unsigned
+pipe_poll (struct pipe *p, bool write_end, struct waiter *w,
+           struct waitq_entry *e)
+{
+  unsigned events = 0;
+
+  lock_acquire (&p->lock);
+  if (w != NULL)
+    waitq_add (&p->waitq, w, e);
+  if (write_end)
+    {
+      if (p->reader_cnt == 0)
+        events |= POLLERR;
+      else if (p->used < PIPE_SIZE || p->reader != NULL)
+        events |= POLLOUT;
+    }
+  else
+    {
+      if (p->used > 0)
+        events |= POLLIN;
+      if (p->writer_cnt == 0)
+        events |= POLLIN | POLLHUP;
+    }
+  lock_release (&p->lock);
+
+  return events;
+}
+
+/* Copies SIZE bytes from kernel buffer KBUF to user buffer UBUF,
+   if TO_USER is true, or from UBUF to KBUF otherwise.  UBUF must
+   be pinned in the process with page directory PD. */
+static void
+copy_user (uint32_t *pd, uint8_t *ubuf, uint8_t *kbuf, size_t size,
+           bool to_user)
+{
+  while (size > 0)
+    {
+      uint8_t *kaddr = pagedir_get_page (pd, ubuf);
+      size_t chunk = PGSIZE - pg_ofs (ubuf);
+
+      ASSERT (kaddr != NULL);
+      if (chunk > size)
+        chunk = size;
+      if (to_user)
+        memcpy (kaddr, kbuf, chunk);
+      else
+        memcpy (kbuf, kaddr, chunk);
+      ubuf += chunk;
+      kbuf += chunk;
+      size -= chunk;
+    }
+}
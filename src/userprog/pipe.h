@@ -0,0 +1,17 @@
+#ifndef USERPROG_PIPE_H
+#define USERPROG_PIPE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct waiter;
+struct waitq_entry;
+
+struct pipe *pipe_create (void);
+void pipe_close (struct pipe *, bool write_end);
+int pipe_read (struct pipe *, void *ubuf, size_t size);
+int pipe_write (struct pipe *, const void *ubuf, size_t size);
+unsigned pipe_poll (struct pipe *, bool write_end, struct waiter *,
+                    struct waitq_entry *);
+
+#endif /* userprog/pipe.h */
@@ -1,68 +1,152 @@
 #include "userprog/process.h"
 #include <debug.h>
-#include <inttypes.h>
-#include <round.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "userprog/elf.h"
+#include "userprog/futex.h"
 #include "userprog/gdt.h"
 #include "userprog/pagedir.h"
+#include "userprog/ring.h"
+#include "userprog/syscall.h"
 #include "userprog/tss.h"
+#include "userprog/uaccess.h"
+#include "userprog/vdata.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
 
 static thread_func start_process NO_RETURN;
-static bool load (const char *cmdline, void (**eip) (void), void **esp);
+static thread_func start_thread NO_RETURN;
+static bool load (const char *cmd_line, void (**eip) (void), void **esp);
+static void exit_thread (void);
+static void wait_threads (void);
 
-/* Starts a new thread running a user program loaded from
-   FILENAME.  The new thread may be scheduled (and may even exit)
-   before process_execute() returns.  Returns the new process's
-   thread id, or TID_ERROR if the thread cannot be created. */
+/* Shared between a parent process and a child that it started.
+   The child ups SEMA twice: once it has loaded, or failed to,
+   and again when it exits.  The parent downs it once in
+   process_execute(), to learn whether the child loaded, and
+   again in process_wait(), to wait for its exit status.  Freed
+   when both have let go of it. */
+struct wait_status
+  {
+    struct list_elem elem;      /* Element in parent's `children'. */
+    struct lock lock;           /* Protects REF_CNT. */
+    int ref_cnt;                /* 2: parent and child, 1: one. */
+    tid_t tid;                  /* Child's thread identifier. */
+    bool loaded;                /* Did the child load successfully? */
+    int exit_status;            /* Child's exit status, once it exits. */
+    struct semaphore sema;      /* See above. */
+  };
+
+/* Passed from process_execute() to the new process's
+   start_process(). */
+struct exec_info
+  {
+    const char *cmd_line;       /* Caller's command line. */
+    struct thread *parent;      /* Process calling process_execute(). */
+    struct wait_status *ws;     /* Shared with the parent. */
+  };
+
+static void release_wait_status (struct wait_status *);
+
+/* Starts a new thread running a user program loaded according to
+   CMD_LINE, whose first word names the program and whose words
+   all become the program's arguments, and waits for it to load.
+   The program may even exit before process_execute() returns.
+   Returns the new process's thread id, or TID_ERROR if it cannot
+   be created or loaded. */
 tid_t
-process_execute (const char *file_name) 
+process_execute (const char *cmd_line) 
 {
-  char *fn_copy;
+  struct thread *p = process_current ();
+  char name[sizeof p->name];
+  struct exec_info info;
+  struct wait_status *ws;
   tid_t tid;
 
-  /* Make a copy of FILE_NAME.
-     Otherwise there's a race between the caller and load(). */
-  fn_copy = palloc_get_page (0);
-  if (fn_copy == NULL)
+  /* Name the new thread after its program, truncated to fit. */
+  strlcpy (name, cmd_line + strspn (cmd_line, " "), sizeof name);
+  name[strcspn (name, " ")] = '\0';
+  if (name[0] == '\0')
     return TID_ERROR;
-  strlcpy (fn_copy, file_name, PGSIZE);
 
-  /* Create a new thread to execute FILE_NAME. */
-  tid = thread_create (file_name, PRI_DEFAULT, start_process, fn_copy);
+  ws = malloc (sizeof *ws);
+  if (ws == NULL)
+    return TID_ERROR;
+  lock_init (&ws->lock);
+  ws->ref_cnt = 2;
+  ws->loaded = false;
+  ws->exit_status = -1;
+  sema_init (&ws->sema, 0);
+
+  /* The new process reads CMD_LINE straight onto its stack, and
+     takes what it inherits from us, while we wait for it to
+     load. */
+  info.cmd_line = cmd_line;
+  info.parent = thread_current ();
+  info.ws = ws;
+  tid = thread_create (name, PRI_DEFAULT, start_process, &info);
   if (tid == TID_ERROR)
-    palloc_free_page (fn_copy); 
+    {
+      free (ws);
+      return TID_ERROR;
+    }
+  sema_down (&ws->sema);
+
+  if (!ws->loaded)
+    {
+      release_wait_status (ws);
+      return TID_ERROR;
+    }
+  ws->tid = tid;
+  lock_acquire (&p->process_lock);
+  list_push_back (&p->children, &ws->elem);
+  lock_release (&p->process_lock);
   return tid;
 }
 
 /* A thread function that loads a user process and starts it
    running. */
 static void
-start_process (void *file_name_)
+start_process (void *info_)
 {
-  char *file_name = file_name_;
+  struct exec_info *info = info_;
+  struct thread *t = thread_current ();
   struct intr_frame if_;
   bool success;
 
+  t->wait_status = info->ws;
+
+  /* Inherit the parent's standard input and output.  The parent
+     may not be a user process, if we are the first one. */
+  success = (info->parent->pagedir == NULL
+             || syscall_inherit (info->parent));
+
   /* Initialize interrupt frame and load executable. */
   memset (&if_, 0, sizeof if_);
   if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
   if_.cs = SEL_UCSEG;
   if_.eflags = FLAG_IF | FLAG_MBS;
-  success = load (file_name, &if_.eip, &if_.esp);
+  if (success)
+    success = load (info->cmd_line, &if_.eip, &if_.esp);
+
+  /* Tell the parent how it went.  INFO is gone after this. */
+  t->wait_status->loaded = success;
+  sema_up (&t->wait_status->sema);
 
   /* If load failed, quit. */
-  palloc_free_page (file_name);
   if (!success) 
     thread_exit ();
 
@@ -81,14 +165,46 @@ start_process (void *file_name_)
    exception), returns -1.  If TID is invalid or if it was not a
    child of the calling process, or if process_wait() has already
    been successfully called for the given TID, returns -1
-   immediately, without waiting.
-
-   This function will be implemented in problem 2-2.  For now, it
-   does nothing. */
+   immediately, without waiting. */
 int
-process_wait (tid_t child_tid UNUSED) 
+process_wait (tid_t child_tid) 
+{
+  struct thread *p = process_current ();
+  struct wait_status *ws = NULL;
+  struct list_elem *e;
+  int status;
+
+  lock_acquire (&p->process_lock);
+  for (e = list_begin (&p->children); e != list_end (&p->children);
+       e = list_next (e))
+    if (list_entry (e, struct wait_status, elem)->tid == child_tid)
+      {
+        ws = list_entry (e, struct wait_status, elem);
+        list_remove (&ws->elem);
+        break;
+      }
+  lock_release (&p->process_lock);
+  if (ws == NULL)
+    return -1;
+
+  sema_down (&ws->sema);
+  status = ws->exit_status;
+  release_wait_status (ws);
+  return status;
+}
+
+/* Lets go of WS, on behalf of either the parent or the child,
+   and frees it if the other has let go already. */
+static void
+release_wait_status (struct wait_status *ws)
 {
-  return -1;
+  bool dead;
+
+  lock_acquire (&ws->lock);
+  dead = --ws->ref_cnt == 0;
+  lock_release (&ws->lock);
+  if (dead)
+    free (ws);
 }
 
 /* Free the current process's resources. */
@@ -98,6 +214,31 @@ process_exit (void)
   struct thread *cur = thread_current ();
   uint32_t *pd;
 
+  if (cur->process != cur)
+    {
+      exit_thread ();
+      return;
+    }
+  wait_threads ();
+
+  if (cur->pagedir != NULL)
+    printf ("%s: exit(%d)\n", cur->name, cur->exit_status);
+
+  syscall_exit ();
+  ring_exit ();
+  file_close (cur->executable);
+  cur->executable = NULL;
+
+#ifdef VM
+  if (page_print_exit_stats && cur->pages != NULL)
+    page_print_stats ();
+
+  /* Release the process's user pages.  This must happen while
+     its page directory is still in place. */
+  page_table_destroy (cur->pages);
+  cur->pages = NULL;
+#endif
+
   /* Destroy the current process's page directory and switch back
      to the kernel-only page directory. */
   pd = cur->pagedir;
@@ -112,8 +253,23 @@ process_exit (void)
          that's been freed (and cleared). */
       cur->pagedir = NULL;
       pagedir_activate (NULL);
+      vdata_unmap (pd);
       pagedir_destroy (pd);
     }
+
+  /* Let go of our children, and hand our exit status to our
+     parent. */
+  while (!list_empty (&cur->children))
+    release_wait_status (list_entry (list_pop_front (&cur->children),
+                                     struct wait_status, elem));
+  if (cur->wait_status != NULL)
+    {
+      struct wait_status *ws = cur->wait_status;
+      ws->exit_status = cur->exit_status;
+      sema_up (&ws->sema);
+      release_wait_status (ws);
+      cur->wait_status = NULL;
+    }
 }
 
 /* Sets up the CPU for running user code in the current
@@ -126,101 +282,64 @@ process_activate (void)
 
   /* Activate thread's page tables. */
   pagedir_activate (t->pagedir);
+  vdata_set_pid (t->process->tid);
 
   /* Set thread's kernel stack for use in processing
      interrupts. */
   tss_update ();
 }
 
-/* We load ELF binaries.  The following definitions are taken
-   from the ELF specification, [ELF1], more-or-less verbatim.  */
-
-/* ELF types.  See [ELF1] 1-2. */
-typedef uint32_t Elf32_Word, Elf32_Addr, Elf32_Off;
-typedef uint16_t Elf32_Half;
-
-/* For use with ELF types in printf(). */
-#define PE32Wx PRIx32   /* Print Elf32_Word in hexadecimal. */
-#define PE32Ax PRIx32   /* Print Elf32_Addr in hexadecimal. */
-#define PE32Ox PRIx32   /* Print Elf32_Off in hexadecimal. */
-#define PE32Hx PRIx16   /* Print Elf32_Half in hexadecimal. */
-
-/* Executable header.  See [ELF1] 1-4 to 1-8.
-   This appears at the very beginning of an ELF binary. */
-struct Elf32_Ehdr
-  {
-    unsigned char e_ident[16];
-    Elf32_Half    e_type;
-    Elf32_Half    e_machine;
-    Elf32_Word    e_version;
-    Elf32_Addr    e_entry;
-    Elf32_Off     e_phoff;
-    Elf32_Off     e_shoff;
-    Elf32_Word    e_flags;
-    Elf32_Half    e_ehsize;
-    Elf32_Half    e_phentsize;
-    Elf32_Half    e_phnum;
-    Elf32_Half    e_shentsize;
-    Elf32_Half    e_shnum;
-    Elf32_Half    e_shstrndx;
-  };
-
-/* Program header.  See [ELF1] 2-2 to 2-4.
-   There are e_phnum of these, starting at file offset e_phoff
-   (see [ELF1] 1-6). */
-struct Elf32_Phdr
-  {
-    Elf32_Word p_type;
-    Elf32_Off  p_offset;
-    Elf32_Addr p_vaddr;
-    Elf32_Addr p_paddr;
-    Elf32_Word p_filesz;
-    Elf32_Word p_memsz;
-    Elf32_Word p_flags;
-    Elf32_Word p_align;
-  };
-
-/* Values for p_type.  See [ELF1] 2-3. */
-#define PT_NULL    0            /* Ignore. */
-#define PT_LOAD    1            /* Loadable segment. */
-#define PT_DYNAMIC 2            /* Dynamic linking info. */
-#define PT_INTERP  3            /* Name of dynamic loader. */
-#define PT_NOTE    4            /* Auxiliary info. */
-#define PT_SHLIB   5            /* Reserved. */
-#define PT_PHDR    6            /* Program header table. */
-#define PT_STACK   0x6474e551   /* Stack segment. */
-
-/* Flags for p_flags.  See [ELF3] 2-3 and 2-4. */
-#define PF_X 1          /* Executable. */
-#define PF_W 2          /* Writable. */
-#define PF_R 4          /* Readable. */
-
-static bool setup_stack (void **esp);
-static bool validate_segment (const struct Elf32_Phdr *, struct file *);
+static bool setup_stack (const char *cmd_line, void **esp);
+static bool push_args (uint8_t *kpage, const char *cmd_line, void **esp);
 static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
                           uint32_t read_bytes, uint32_t zero_bytes,
                           bool writable);
 
-/* Loads an ELF executable from FILE_NAME into the current thread.
+/* Loads the ELF executable named by the first word of CMD_LINE
+   into the current thread, with the words of CMD_LINE as its
+   arguments.
    Stores the executable's entry point into *EIP
    and its initial stack pointer into *ESP.
    Returns true if successful, false otherwise. */
 bool
-load (const char *file_name, void (**eip) (void), void **esp) 
+load (const char *cmd_line, void (**eip) (void), void **esp) 
 {
   struct thread *t = thread_current ();
-  struct Elf32_Ehdr ehdr;
+  const struct elf_image *image = NULL;
   struct file *file = NULL;
-  off_t file_ofs;
+  char *file_name;
+  size_t name_len;
   bool success = false;
-  int i;
+  bool locked;
+  size_t i;
+
+  /* Only the program's name needs a copy of its own, to open
+     it; the arguments go straight from CMD_LINE to the stack. */
+  cmd_line += strspn (cmd_line, " ");
+  name_len = strcspn (cmd_line, " ");
+  file_name = malloc (name_len + 1);
+  if (file_name == NULL)
+    return false;
+  strlcpy (file_name, cmd_line, name_len + 1);
+
+  lock_acquire (&filesys_lock);
+  locked = true;
 
   /* Allocate and activate page directory. */
   t->pagedir = pagedir_create ();
   if (t->pagedir == NULL) 
     goto done;
+#ifdef VM
+  lock_init (&t->page_lock);
+  list_init (&t->mappings);
+  t->pages = page_table_create ();
+  if (t->pages == NULL)
+    goto done;
+#endif
   process_activate ();
 
+  t->heap_start = NULL;
+
   /* Open executable file. */
   file = filesys_open (file_name);
   if (file == NULL) 
@@ -228,142 +347,71 @@ load (const char *file_name, void (**eip) (void), void **esp)
       printf ("load: %s: open failed\n", file_name);
       goto done; 
     }
+  file_deny_write (file);
 
-  /* Read and verify executable header. */
-  if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
-      || memcmp (ehdr.e_ident, "\177ELF\1\1\1", 7)
-      || ehdr.e_type != 2
-      || ehdr.e_machine != 3
-      || ehdr.e_version != 1
-      || ehdr.e_phentsize != sizeof (struct Elf32_Phdr)
-      || ehdr.e_phnum > 1024) 
+  /* Read and verify the executable's layout, then map its
+     segments. */
+  image = elf_get (file);
+  if (image == NULL)
     {
       printf ("load: %s: error loading executable\n", file_name);
       goto done; 
     }
-
-  /* Read program headers. */
-  file_ofs = ehdr.e_phoff;
-  for (i = 0; i < ehdr.e_phnum; i++) 
+  for (i = 0; i < image->segment_cnt; i++)
     {
-      struct Elf32_Phdr phdr;
+      const struct elf_segment *s = &image->segments[i];
+      uint8_t *end = s->mem_page + s->read_bytes + s->zero_bytes;
 
-      if (file_ofs < 0 || file_ofs > file_length (file))
+      if (!load_segment (file, s->file_page, s->mem_page,
+                         s->read_bytes, s->zero_bytes, s->writable))
         goto done;
-      file_seek (file, file_ofs);
 
-      if (file_read (file, &phdr, sizeof phdr) != sizeof phdr)
-        goto done;
-      file_ofs += sizeof phdr;
-      switch (phdr.p_type) 
-        {
-        case PT_NULL:
-        case PT_NOTE:
-        case PT_PHDR:
-        case PT_STACK:
-        default:
-          /* Ignore this segment. */
-          break;
-        case PT_DYNAMIC:
-        case PT_INTERP:
-        case PT_SHLIB:
-          goto done;
-        case PT_LOAD:
-          if (validate_segment (&phdr, file)) 
-            {
-              bool writable = (phdr.p_flags & PF_W) != 0;
-              uint32_t file_page = phdr.p_offset & ~PGMASK;
-              uint32_t mem_page = phdr.p_vaddr & ~PGMASK;
-              uint32_t page_offset = phdr.p_vaddr & PGMASK;
-              uint32_t read_bytes, zero_bytes;
-              if (phdr.p_filesz > 0)
-                {
-                  /* Normal segment.
-                     Read initial part from disk and zero the rest. */
-                  read_bytes = page_offset + phdr.p_filesz;
-                  zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz, PGSIZE)
-                                - read_bytes);
-                }
-              else 
-                {
-                  /* Entirely zero.
-                     Don't read anything from disk. */
-                  read_bytes = 0;
-                  zero_bytes = ROUND_UP (page_offset + phdr.p_memsz, PGSIZE);
-                }
-              if (!load_segment (file, file_page, (void *) mem_page,
-                                 read_bytes, zero_bytes, writable))
-                goto done;
-            }
-          else
-            goto done;
-          break;
-        }
+      /* The heap starts after the highest segment. */
+      if (end > t->heap_start)
+        t->heap_start = end;
     }
 
+  /* Nothing below reads the executable.  Allocating the stack's
+     frame may wait for the OOM killer's victim to exit, which
+     it may need filesys_lock to do, so let go of it first. */
+  lock_release (&filesys_lock);
+  locked = false;
+
   /* Set up stack. */
-  if (!setup_stack (esp))
+  if (!setup_stack (cmd_line, esp))
+    goto done;
+  t->brk = t->heap_start;
+
+  /* Map the kernel data page. */
+  if (!vdata_map (t->pagedir))
     goto done;
 
   /* Start address. */
-  *eip = (void (*) (void)) ehdr.e_entry;
+  *eip = image->entry;
 
   success = true;
 
  done:
-  /* We arrive here whether the load is successful or not. */
-  file_close (file);
+  /* We arrive here whether the load is successful or not.  The
+     executable stays open, and unwritable, while it runs. */
+  if (!locked)
+    lock_acquire (&filesys_lock);
+  if (success)
+    t->executable = file;
+  else
+    file_close (file);
+  elf_put (image);
+  lock_release (&filesys_lock);
+  free (file_name);
   return success;
 }
 
 /* load() helpers. */
 
+#ifndef VM
 static bool install_page (void *upage, void *kpage, bool writable);
-
-/* Checks whether PHDR describes a valid, loadable segment in
-   FILE and returns true if so, false otherwise. */
-static bool
-validate_segment (const struct Elf32_Phdr *phdr, struct file *file) 
-{
-  /* p_offset and p_vaddr must have the same page offset. */
-  if ((phdr->p_offset & PGMASK) != (phdr->p_vaddr & PGMASK)) 
-    return false; 
-
-  /* p_offset must point within FILE. */
-  if (phdr->p_offset > (Elf32_Off) file_length (file)) 
-    return false;
-
-  /* p_memsz must be at least as big as p_filesz. */
-  if (phdr->p_memsz < phdr->p_filesz) 
-    return false; 
-
-  /* The segment must not be empty. */
-  if (phdr->p_memsz == 0)
-    return false;
-  
-  /* The virtual memory region must both start and end within the
-     user address space range. */
-  if (!is_user_vaddr ((void *) phdr->p_vaddr))
-    return false;
-  if (!is_user_vaddr ((void *) (phdr->p_vaddr + phdr->p_memsz)))
-    return false;
-
-  /* The region cannot "wrap around" across the kernel virtual
-     address space. */
-  if (phdr->p_vaddr + phdr->p_memsz < phdr->p_vaddr)
-    return false;
-
-  /* Disallow mapping page 0.
-     Not only is it a bad idea to map page 0, but if we allowed
-     it then user code that passed a null pointer to system calls
-     could quite likely panic the kernel by way of null pointer
-     assertions in memcpy(), etc. */
-  if (phdr->p_vaddr < PGSIZE)
-    return false;
-
-  /* It's okay. */
-  return true;
-}
+#endif
+static bool free_user_pages (uint8_t *upage, size_t page_cnt);
 
 /* Loads a segment starting at offset OFS in FILE at address
    UPAGE.  In total, READ_BYTES + ZERO_BYTES bytes of virtual
@@ -375,7 +423,10 @@ validate_segment (const struct Elf32_Phdr *phdr, struct file *file)
         - ZERO_BYTES bytes at UPAGE + READ_BYTES must be zeroed.
 
    The pages initialized by this function must be writable by the
-   user process if WRITABLE is true, read-only otherwise.
+   user process if WRITABLE is true, read-only otherwise.  With
+   virtual memory, nothing is read until a page is first used,
+   and read-only pages are shared among all the processes that
+   run the same executable.
 
    Return true if successful, false if a memory allocation error
    or disk read error occurs. */
@@ -387,6 +438,11 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
   ASSERT (pg_ofs (upage) == 0);
   ASSERT (ofs % PGSIZE == 0);
 
+#ifdef VM
+  /* Map the segment, to be read in as it is used. */
+  return page_map_file (upage, file, ofs, read_bytes,
+                        (read_bytes + zero_bytes) / PGSIZE, writable);
+#else
   file_seek (file, ofs);
   while (read_bytes > 0 || zero_bytes > 0) 
     {
@@ -419,31 +475,98 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
       /* Advance. */
       read_bytes -= page_read_bytes;
       zero_bytes -= page_zero_bytes;
+      ofs += PGSIZE;
       upage += PGSIZE;
     }
   return true;
+#endif
 }
 
 /* Create a minimal stack by mapping a zeroed page at the top of
-   user virtual memory. */
+   user virtual memory, and push the words of CMD_LINE onto it as
+   the program's arguments.  With virtual memory, the stack grows
+   downward from there on demand, up to stack_page_limit
+   pages. */
 static bool
-setup_stack (void **esp) 
+setup_stack (const char *cmd_line, void **esp) 
 {
+  uint8_t *upage = ((uint8_t *) PHYS_BASE) - PGSIZE;
+#ifdef VM
+  struct page *p = page_allocate (upage, true);
+  bool success;
+
+  if (p == NULL || !page_load (p) || !page_pin (upage, PGSIZE, true))
+    return false;
+  success = push_args (page_kpage (p), cmd_line, esp);
+  page_unpin (upage, PGSIZE);
+  return success;
+#else
   uint8_t *kpage;
   bool success = false;
 
   kpage = palloc_get_page (PAL_USER | PAL_ZERO);
   if (kpage != NULL) 
     {
-      success = install_page (((uint8_t *) PHYS_BASE) - PGSIZE, kpage, true);
-      if (success)
-        *esp = PHYS_BASE;
-      else
+      success = (push_args (kpage, cmd_line, esp)
+                 && install_page (upage, kpage, true));
+      if (!success)
         palloc_free_page (kpage);
     }
   return success;
+#endif
 }
 
+/* Copies the words of CMD_LINE, separated by spaces, into KPAGE,
+   the kernel's view of the page at the top of the user stack,
+   and pushes the arguments to main() below them: argv[] with a
+   null pointer at its end, argv, argc, and a fake return
+   address.  Each word is copied only once, straight from
+   CMD_LINE, with the user addresses of argv[] collected at the
+   bottom of the page in the meantime.  Stores the initial user
+   stack pointer into *ESP.  Returns false if the arguments do
+   not fit in the page. */
+static bool
+push_args (uint8_t *kpage, const char *cmd_line, void **esp)
+{
+  uint8_t *upage = ((uint8_t *) PHYS_BASE) - PGSIZE;
+  uint8_t *top = kpage + PGSIZE;
+  uint32_t *argv = (uint32_t *) kpage;
+  uint32_t *sp;
+  int argc = 0;
+
+  for (;;)
+    {
+      size_t len;
+
+      cmd_line += strspn (cmd_line, " ");
+      if (*cmd_line == '\0')
+        break;
+      len = strcspn (cmd_line, " ");
+      if ((uint8_t *) (argv + argc + 1) + len + 1 > top)
+        return false;
+      top -= len + 1;
+      memcpy (top, cmd_line, len);
+      top[len] = '\0';
+      argv[argc++] = (uint32_t) (upage + (top - kpage));
+      cmd_line += len;
+    }
+
+  /* Word-align, then move argv[] into place above argv, argc,
+     and the return address. */
+  sp = (uint32_t *) ((uintptr_t) top & ~3u) - (argc + 4);
+  if ((uint8_t *) sp < kpage)
+    return false;
+  memmove (sp + 3, argv, argc * sizeof *argv);
+  sp[3 + argc] = 0;
+  sp[2] = (uint32_t) (upage + ((uint8_t *) (sp + 3) - kpage));
+  sp[1] = argc;
+  sp[0] = 0;
+
+  *esp = upage + ((uint8_t *) sp - kpage);
+  return true;
+}
+
+#ifndef VM
 /* Adds a mapping from user virtual address UPAGE to kernel
    virtual address KPAGE to the page table.
    If WRITABLE is true, the user process may modify the page;
@@ -463,3 +586,465 @@ install_page (void *upage, void *kpage, bool writable)
   return (pagedir_get_page (t->pagedir, upage) == NULL
           && pagedir_set_page (t->pagedir, upage, kpage, writable));
 }
+#endif
+
+/* Heap and thread stacks. */
+
+/* Number of threads that a process may add to its first one. */
+#define THREAD_MAX 16
+
+/* Size of the user stack of each added thread, in pages.  Each
+   one gets a slot of one more page, left unmapped as a guard. */
+#define THREAD_STACK_PAGES 4
+#define THREAD_SLOT_PAGES (THREAD_STACK_PAGES + 1)
+
+/* Returns the bottom of the area reserved for the stack of the
+   current process's first thread. */
+static uint8_t *
+stack_bottom (void)
+{
+#ifdef VM
+  return (uint8_t *) PHYS_BASE - stack_page_limit * PGSIZE;
+#else
+  return (uint8_t *) PHYS_BASE - PGSIZE;
+#endif
+}
+
+/* Returns the lowest page of the user stack in slot SLOT, which
+   must be less than THREAD_MAX.  The slots lie just below the
+   first thread's stack. */
+static uint8_t *
+thread_stack (int slot)
+{
+  ASSERT (slot >= 0 && slot < THREAD_MAX);
+  return stack_bottom () - (slot + 1) * THREAD_SLOT_PAGES * PGSIZE + PGSIZE;
+}
+
+/* Returns the highest address the current process's heap may
+   reach, leaving room below it for the stacks. */
+static uint8_t *
+heap_limit (void)
+{
+  return stack_bottom () - THREAD_MAX * THREAD_SLOT_PAGES * PGSIZE;
+}
+
+/* Maps the PAGE_CNT pages starting at UPAGE into the current
+   process as writable memory.  With virtual memory, each page is
+   zero-filled when first used; otherwise, zeroed pages are
+   allocated at once.  Returns true if successful, false if
+   memory is exhausted, in which case no pages are mapped. */
+static bool
+alloc_user_pages (uint8_t *upage, size_t page_cnt)
+{
+#ifdef VM
+  return page_allocate_range (upage, page_cnt);
+#else
+  size_t i;
+
+  for (i = 0; i < page_cnt; i++)
+    {
+      uint8_t *kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+      if (kpage == NULL || !install_page (upage + i * PGSIZE, kpage, true))
+        {
+          palloc_free_page (kpage);
+          free_user_pages (upage, i);
+          return false;
+        }
+    }
+  return true;
+#endif
+}
+
+/* Unmaps the PAGE_CNT pages starting at UPAGE, which must have
+   been mapped by alloc_user_pages(), from the current process
+   and frees them.  Returns true if successful, false if a page
+   is pinned for I/O, in which case no pages are unmapped. */
+static bool
+free_user_pages (uint8_t *upage, size_t page_cnt)
+{
+#ifdef VM
+  return page_deallocate_range (upage, page_cnt);
+#else
+  uint32_t *pd = thread_current ()->pagedir;
+  size_t i;
+
+  for (i = 0; i < page_cnt; i++)
+    {
+      void *kpage = pagedir_get_page (pd, upage + i * PGSIZE);
+      pagedir_clear_page (pd, upage + i * PGSIZE);
+      palloc_free_page (kpage);
+    }
+  return true;
+#endif
+}
+
+/* Moves the end of the current process's heap, its "program
+   break", by INCREMENT bytes, which may be negative, and returns
+   the old break.  The heap starts out empty, just after the
+   executable's highest segment, and may grow until it reaches
+   the area reserved for the stacks.  Pages that the heap grows
+   into read as zeros; pages that it shrinks out of are freed.
+   Returns a null pointer if the break would move out of range or
+   memory is exhausted. */
+void *
+process_sbrk (intptr_t increment)
+{
+  struct thread *p = process_current ();
+  uint8_t *old_brk, *old_end, *new_end;
+
+  lock_acquire (&p->process_lock);
+  old_brk = p->brk;
+  if (increment > 0 ? increment > heap_limit () - old_brk
+      : increment < p->heap_start - old_brk)
+    goto error;
+
+  old_end = pg_round_up (old_brk);
+  new_end = pg_round_up (old_brk + increment);
+  if (new_end > old_end
+      && !alloc_user_pages (old_end, (new_end - old_end) / PGSIZE))
+    goto error;
+  if (new_end < old_end
+      && !free_user_pages (new_end, (old_end - new_end) / PGSIZE))
+    goto error;
+  p->brk = old_brk + increment;
+  lock_release (&p->process_lock);
+  return old_brk;
+
+ error:
+  lock_release (&p->process_lock);
+  return NULL;
+}
+
+/* Threads.
+
+   A process starts out with one thread and may add more with
+   process_thread_create().  All of its threads share its page
+   directory, open files, heap, and the rest of the state that
+   is kept in its first thread, so the first thread lives until
+   all of the others have exited.  Each added thread runs on its
+   own user stack, in one of THREAD_MAX slots below the first
+   thread's stack.
+
+   An added thread ends by calling process_thread_exit(), which
+   leaves a status for process_thread_join().  When any thread
+   calls exit(), or the process is killed, the whole process
+   ends: every thread is marked as killed, so that it exits the
+   next time it would return to user mode, threads waiting on
+   futexes are woken to do so, and the first thread waits for
+   the others before it releases the process's resources.  A
+   thread blocked elsewhere, e.g. reading the console, holds up
+   the end of the process until it gets to return. */
+
+/* A thread added to a process by process_thread_create(). */
+struct user_thread
+  {
+    struct list_elem elem;      /* Element in process's `threads'. */
+    tid_t tid;                  /* Thread identifier. */
+    struct thread *thread;      /* Thread, if it has started. */
+    int slot;                   /* Stack slot, 0...THREAD_MAX - 1. */
+    bool exited;                /* Has the thread exited? */
+    bool joining;               /* Is a thread joining it? */
+    int exit_status;            /* Status passed to thread_exit(). */
+  };
+
+/* Passed from process_thread_create() to start_thread(). */
+struct thread_info
+  {
+    struct thread *process;     /* Process to join. */
+    struct user_thread *ut;     /* The new thread's record. */
+    void (*entry) (void);       /* User code to start at. */
+    void *args[2];              /* Arguments to pass to ENTRY. */
+    struct semaphore started;   /* Upped once INFO is not needed. */
+  };
+
+static struct user_thread *find_thread (struct thread *process,
+                                        struct thread *);
+static void kill_threads (struct thread *process);
+
+/* Returns the first thread of the process that the running
+   thread belongs to, which holds the process's shared state.
+   For a kernel thread, returns the thread itself. */
+struct thread *
+process_current (void)
+{
+  return thread_current ()->process;
+}
+
+/* Starts a new thread in the current process, which runs ENTRY
+   in user mode with ARG0 and ARG1 as its arguments, on a user
+   stack of its own.  ENTRY must not return.  Returns the new
+   thread's identifier, or TID_ERROR if the process has too many
+   threads already, is being killed, or memory is exhausted. */
+tid_t
+process_thread_create (void (*entry) (void), void *arg0, void *arg1)
+{
+  struct thread *p = process_current ();
+  struct thread_info info;
+  struct user_thread *ut = NULL;
+  bool slot_used[THREAD_MAX];
+  struct list_elem *e;
+  tid_t tid;
+  int slot;
+
+  lock_acquire (&p->process_lock);
+  for (slot = 0; slot < THREAD_MAX; slot++)
+    slot_used[slot] = false;
+  for (e = list_begin (&p->threads); e != list_end (&p->threads);
+       e = list_next (e))
+    slot_used[list_entry (e, struct user_thread, elem)->slot] = true;
+  for (slot = 0; slot < THREAD_MAX && slot_used[slot]; slot++)
+    continue;
+
+  if (!p->killed && slot < THREAD_MAX)
+    ut = malloc (sizeof *ut);
+  if (ut == NULL)
+    {
+      lock_release (&p->process_lock);
+      return TID_ERROR;
+    }
+  if (!alloc_user_pages (thread_stack (slot), THREAD_STACK_PAGES))
+    {
+      lock_release (&p->process_lock);
+      free (ut);
+      return TID_ERROR;
+    }
+  ut->tid = TID_ERROR;
+  ut->thread = NULL;
+  ut->slot = slot;
+  ut->exited = false;
+  ut->joining = false;
+  ut->exit_status = -1;
+  list_push_back (&p->threads, &ut->elem);
+  lock_release (&p->process_lock);
+
+  info.process = p;
+  info.ut = ut;
+  info.entry = entry;
+  info.args[0] = arg0;
+  info.args[1] = arg1;
+  sema_init (&info.started, 0);
+  tid = thread_create (p->name, PRI_DEFAULT, start_thread, &info);
+  if (tid != TID_ERROR)
+    sema_down (&info.started);
+  else
+    {
+      lock_acquire (&p->process_lock);
+      list_remove (&ut->elem);
+      free_user_pages (thread_stack (slot), THREAD_STACK_PAGES);
+      lock_release (&p->process_lock);
+      free (ut);
+    }
+  return tid;
+}
+
+/* A thread function that joins a new thread to a process and
+   starts it running in user mode. */
+static void
+start_thread (void *info_)
+{
+  struct thread_info *info = info_;
+  struct thread *p = info->process;
+  struct thread *t = thread_current ();
+  struct user_thread *ut = info->ut;
+  struct intr_frame if_;
+  uint32_t frame[3];
+  bool success;
+
+  t->process = p;
+  t->pagedir = p->pagedir;
+  process_activate ();
+
+  lock_acquire (&p->process_lock);
+  ut->tid = t->tid;
+  ut->thread = t;
+  if (p->killed)
+    t->killed = true;
+  lock_release (&p->process_lock);
+
+  /* Set up the stack as if ENTRY had been called with its two
+     arguments, from a null return address. */
+  memset (&if_, 0, sizeof if_);
+  if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
+  if_.cs = SEL_UCSEG;
+  if_.eflags = FLAG_IF | FLAG_MBS;
+  if_.eip = info->entry;
+  if_.esp = thread_stack (ut->slot) + THREAD_STACK_PAGES * PGSIZE
+            - sizeof frame;
+  frame[0] = 0;
+  frame[1] = (uint32_t) info->args[0];
+  frame[2] = (uint32_t) info->args[1];
+  success = !t->killed && copy_to_user (if_.esp, frame, sizeof frame);
+  sema_up (&info->started);
+  if (!success)
+    thread_exit ();
+
+  /* Start the thread by simulating a return from an interrupt,
+     as in start_process(). */
+  asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+  NOT_REACHED ();
+}
+
+/* Ends the running thread, leaving STATUS for
+   process_thread_join().  If the running thread is its
+   process's first thread, ends the whole process with STATUS as
+   its exit status instead. */
+void
+process_thread_exit (int status)
+{
+  struct thread *p = process_current ();
+  struct user_thread *ut;
+
+  if (p == thread_current ())
+    process_terminate (status);
+
+  lock_acquire (&p->process_lock);
+  ut = find_thread (p, thread_current ());
+  ut->exit_status = status;
+  lock_release (&p->process_lock);
+  thread_exit ();
+}
+
+/* Waits for thread TID of the current process, which must have
+   been added by process_thread_create(), to exit, frees its
+   stack, and returns the status it left.  Returns -1 at once if
+   there is no such thread, if it is the running thread, or if
+   another thread is joining it already. */
+int
+process_thread_join (tid_t tid)
+{
+  struct thread *p = process_current ();
+  struct user_thread *ut = NULL;
+  struct list_elem *e;
+  int status = -1;
+
+  lock_acquire (&p->process_lock);
+  for (e = list_begin (&p->threads); e != list_end (&p->threads);
+       e = list_next (e))
+    if (list_entry (e, struct user_thread, elem)->tid == tid)
+      {
+        ut = list_entry (e, struct user_thread, elem);
+        break;
+      }
+  if (ut != NULL && !ut->joining && ut->thread != thread_current ())
+    {
+      ut->joining = true;
+      while (!ut->exited)
+        cond_wait (&p->thread_exited, &p->process_lock);
+      list_remove (&ut->elem);
+      free_user_pages (thread_stack (ut->slot), THREAD_STACK_PAGES);
+      status = ut->exit_status;
+      free (ut);
+    }
+  lock_release (&p->process_lock);
+  return status;
+}
+
+/* Kills process P, given its first thread: each of its threads
+   exits the next time it would return to user mode. */
+void
+process_kill (struct thread *p)
+{
+  lock_acquire (&p->process_lock);
+  kill_threads (p);
+  lock_release (&p->process_lock);
+}
+
+/* Ends the current process with exit status STATUS, unless it
+   is already being killed, and exits the running thread. */
+void
+process_terminate (int status)
+{
+  struct thread *p = process_current ();
+
+  lock_acquire (&p->process_lock);
+  if (!p->killed)
+    p->exit_status = status;
+  kill_threads (p);
+  lock_release (&p->process_lock);
+  thread_exit ();
+}
+
+/* Marks process P and all of its threads as killed and wakes
+   those waiting on futexes.  P's process_lock must be held. */
+static void
+kill_threads (struct thread *p)
+{
+  struct list_elem *e;
+
+  ASSERT (lock_held_by_current_thread (&p->process_lock));
+
+  p->killed = true;
+  for (e = list_begin (&p->threads); e != list_end (&p->threads);
+       e = list_next (e))
+    {
+      struct user_thread *ut = list_entry (e, struct user_thread, elem);
+      if (ut->thread != NULL)
+        ut->thread->killed = true;
+    }
+  futex_wake_process (p);
+}
+
+/* Called by process_exit() when an added thread exits.  Marks it
+   as exited. */
+static void
+exit_thread (void)
+{
+  struct thread *cur = thread_current ();
+  struct thread *p = cur->process;
+  struct user_thread *ut;
+
+  /* Leave the process's page directory first, since the first
+     thread may destroy it as soon as we are marked as exited. */
+  cur->pagedir = NULL;
+  pagedir_activate (NULL);
+
+  lock_acquire (&p->process_lock);
+  ut = find_thread (p, cur);
+  ut->thread = NULL;
+  ut->exited = true;
+  cond_broadcast (&p->thread_exited, &p->process_lock);
+  lock_release (&p->process_lock);
+}
+
+/* Called by process_exit() when a process's first thread exits.
+   Kills the process's other threads, waits for them to exit,
+   and frees their records.  Their stacks are freed along with
+   the rest of the process's memory. */
+static void
+wait_threads (void)
+{
+  struct thread *p = thread_current ();
+
+  lock_acquire (&p->process_lock);
+  if (!list_empty (&p->threads))
+    kill_threads (p);
+  while (!list_empty (&p->threads))
+    {
+      struct user_thread *ut = list_entry (list_front (&p->threads),
+                                           struct user_thread, elem);
+      if (ut->exited)
+        {
+          list_remove (&ut->elem);
+          free (ut);
+        }
+      else
+        cond_wait (&p->thread_exited, &p->process_lock);
+    }
+  lock_release (&p->process_lock);
+}
+
+/* Returns the record of thread T in process P. */
+static struct user_thread *
+find_thread (struct thread *p, struct thread *t)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&p->threads); e != list_end (&p->threads);
+       e = list_next (e))
+    {
+      struct user_thread *ut = list_entry (e, struct user_thread, elem);
+      if (ut->thread == t)
+        return ut;
+    }
+  NOT_REACHED ();
+}
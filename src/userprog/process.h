@@ -1,11 +1,20 @@
 #ifndef USERPROG_PROCESS_H
 #define USERPROG_PROCESS_H
 
+#include <stdint.h>
 #include "threads/thread.h"
 
-tid_t process_execute (const char *file_name);
+tid_t process_execute (const char *cmd_line);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (void);
+void *process_sbrk (intptr_t increment);
+
+struct thread *process_current (void);
+tid_t process_thread_create (void (*entry) (void), void *arg0, void *arg1);
+void process_thread_exit (int status) NO_RETURN;
+int process_thread_join (tid_t);
+void process_kill (struct thread *);
+void process_terminate (int status) NO_RETURN;
 
 #endif /* userprog/process.h */
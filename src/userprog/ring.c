@@ -0,0 +1,482 @@
+#include "userprog/ring.h"
+#include <debug.h>
+#include <list.h>
+#include <ring.h>
+#include <stdio.h>
+#include <syscall-nr.h>
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
+#include "userprog/syscall.h"
+#include "userprog/uaccess.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
+
+/* System call ring.
+
+   ring_setup() maps a page holding a struct ring, described in
+   lib/ring.h, into the calling process.  The process queues
+   system calls in the ring's submission queue and hands any
+   number of them to the kernel with one call to ring_enter().
+   Reads and writes go to a pool of worker threads, which post
+   each result to the ring's completion queue as soon as it is
+   ready, while the process keeps running.  Other calls are
+   cheap enough to make on the spot.  The process may pick up
+   completions straight from the ring or have ring_enter() wait
+   for them.
+
+   A worker cannot reach the process's memory through user
+   addresses, since the process's page directory is not active.
+   Data to be written is copied into a kernel page when the
+   write is submitted.  A read's buffer is pinned when the read
+   is submitted, and the worker fills it through the kernel's
+   own mapping of its frames.  It stays pinned until the next
+   ring_enter() after the read completes, or until the process
+   exits, which first waits for all of its requests to finish.
+
+   Each request uses its own reopened copy of its file, so that
+   closing the file descriptor it named does not disturb it. */
+
+/* Number of worker threads. */
+#define WORKER_CNT 4
+
+/* A process's system call ring. */
+struct ring_state
+  {
+    struct ring *ring;          /* Shared page, at its kernel address. */
+    uint32_t *pagedir;          /* Owner's page directory. */
+    unsigned sq_head;           /* Next submission to consume. */
+    struct lock submit_lock;    /* Protects SQ_HEAD. */
+    unsigned cq_tail;           /* Next completion slot to fill. */
+    unsigned pending;           /* Requests not yet completed. */
+    struct list done;           /* Completed requests to clean up. */
+    struct lock lock;           /* Protects the three members above. */
+    struct condition completed; /* Signaled on every completion. */
+  };
+
+/* A read or write. */
+struct request
+  {
+    struct list_elem elem;      /* In `queue' or owner's `done' list. */
+    struct ring_state *rs;      /* Ring it was submitted to. */
+    bool read;                  /* Read or write? */
+    struct file *file;          /* File, or null for the console. */
+    off_t ofs;                  /* File offset. */
+    uint8_t *ubuf;              /* User buffer. */
+    uint8_t *kbuf;              /* Data to write, if a write. */
+    size_t size;                /* Number of bytes. */
+    bool pinned;                /* UBUF pinned? */
+    unsigned user_data;         /* Passed through to the completion. */
+  };
+
+/* Requests waiting for a worker. */
+static struct list queue;
+static struct lock queue_lock;
+static struct condition queue_ready;
+
+/* Serializes ring_setup() between a process's threads. */
+static struct lock setup_lock;
+
+static thread_func worker_thread NO_RETURN;
+static bool has_room (struct ring_state *);
+static unsigned cq_used (const struct ring_state *);
+static void submit (struct ring_state *, const struct ring_sqe *);
+static void post (struct ring_state *, unsigned user_data, int result);
+static void reap (struct ring_state *);
+static struct request *request_create (struct ring_state *,
+                                       const struct ring_sqe *);
+static void request_destroy (struct request *);
+static int do_read (struct request *);
+static int do_write (struct request *);
+
+/* Initializes system call rings and starts the worker
+   threads. */
+void
+ring_init (void)
+{
+  int i;
+
+  ASSERT (sizeof (struct ring) <= PGSIZE);
+
+  list_init (&queue);
+  lock_init (&queue_lock);
+  cond_init (&queue_ready);
+  lock_init (&setup_lock);
+  for (i = 0; i < WORKER_CNT; i++)
+    thread_create ("ring-worker", PRI_DEFAULT, worker_thread, NULL);
+}
+
+/* Maps a system call ring at RING_ADDR in the current process,
+   unless it already has one, and returns RING_ADDR.  Returns a
+   null pointer if memory is exhausted. */
+void *
+ring_setup (void)
+{
+  struct thread *t = process_current ();
+  struct ring_state *rs;
+
+  lock_acquire (&setup_lock);
+  if (t->ring != NULL)
+    {
+      lock_release (&setup_lock);
+      return RING_ADDR;
+    }
+
+  rs = malloc (sizeof *rs);
+  if (rs != NULL)
+    rs->ring = palloc_get_page (PAL_ZERO);
+  if (rs == NULL || rs->ring == NULL
+      || !pagedir_set_page (t->pagedir, RING_ADDR, rs->ring, true))
+    {
+      if (rs != NULL)
+        palloc_free_page (rs->ring);
+      free (rs);
+      lock_release (&setup_lock);
+      return NULL;
+    }
+
+  rs->pagedir = t->pagedir;
+  rs->sq_head = 0;
+  lock_init (&rs->submit_lock);
+  rs->cq_tail = 0;
+  rs->pending = 0;
+  list_init (&rs->done);
+  lock_init (&rs->lock);
+  cond_init (&rs->completed);
+  t->ring = rs;
+  lock_release (&setup_lock);
+  return RING_ADDR;
+}
+
+/* Submits up to TO_SUBMIT entries from the current process's
+   submission queue, then waits until at least MIN_COMPLETE
+   completions are waiting to be consumed or no request is left
+   running.  Stops submitting early if the submission queue runs
+   dry or if the completion queue might overflow.  Returns the
+   number of entries submitted, or -1 if the process has no
+   ring. */
+int
+ring_enter (unsigned to_submit, unsigned min_complete)
+{
+  struct ring_state *rs = process_current ()->ring;
+  unsigned sq_tail;
+  unsigned submitted;
+
+  if (rs == NULL)
+    return -1;
+
+  /* Threads of the process may call this at the same time.  Each
+     entry must be taken by exactly one of them, so they take
+     turns consuming the submission queue. */
+  lock_acquire (&rs->submit_lock);
+  sq_tail = rs->ring->sq_tail;
+  barrier ();
+  for (submitted = 0; submitted < to_submit; submitted++)
+    {
+      struct ring_sqe sqe;
+
+      if (rs->sq_head == sq_tail || !has_room (rs))
+        break;
+      sqe = rs->ring->sq[rs->sq_head++ % RING_SQ_SIZE];
+      rs->ring->sq_head = rs->sq_head;
+      submit (rs, &sqe);
+    }
+  lock_release (&rs->submit_lock);
+
+  lock_acquire (&rs->lock);
+  while (cq_used (rs) < min_complete && rs->pending > 0)
+    cond_wait (&rs->completed, &rs->lock);
+  lock_release (&rs->lock);
+
+  reap (rs);
+  return submitted;
+}
+
+/* Waits for the current process's outstanding requests to
+   finish, then unmaps and frees its ring, if it has one.  Must
+   be called while the process's pages are still in place. */
+void
+ring_exit (void)
+{
+  struct thread *t = process_current ();
+  struct ring_state *rs = t->ring;
+
+  if (rs == NULL)
+    return;
+
+  lock_acquire (&rs->lock);
+  while (rs->pending > 0)
+    cond_wait (&rs->completed, &rs->lock);
+  lock_release (&rs->lock);
+  reap (rs);
+
+  pagedir_clear_page (t->pagedir, RING_ADDR);
+  palloc_free_page (rs->ring);
+  free (rs);
+  t->ring = NULL;
+}
+
+/* Returns true if RS has room in its completion queue for the
+   result of one more request, counting those still running. */
+static bool
+has_room (struct ring_state *rs)
+{
+  bool room;
+
+  lock_acquire (&rs->lock);
+  room = rs->pending + cq_used (rs) < RING_CQ_SIZE;
+  lock_release (&rs->lock);
+  return room;
+}
+
+/* Returns the number of completions in RS that the process has
+   not yet consumed.  Caller must hold RS's lock. */
+static unsigned
+cq_used (const struct ring_state *rs)
+{
+  unsigned used = rs->cq_tail - rs->ring->cq_head;
+  return used < RING_CQ_SIZE ? used : RING_CQ_SIZE;
+}
+
+/* Carries out, or starts, the system call in SQE. */
+static void
+submit (struct ring_state *rs, const struct ring_sqe *sqe)
+{
+  struct request *r;
+  int result;
+
+  switch (sqe->nr)
+    {
+    case SYS_READ:
+    case SYS_WRITE:
+      r = request_create (rs, sqe);
+      if (r == NULL)
+        {
+          result = -1;
+          break;
+        }
+
+      lock_acquire (&rs->lock);
+      rs->pending++;
+      lock_release (&rs->lock);
+
+      lock_acquire (&queue_lock);
+      list_push_back (&queue, &r->elem);
+      cond_signal (&queue_ready, &queue_lock);
+      lock_release (&queue_lock);
+      return;
+
+    case SYS_CREATE:
+    case SYS_REMOVE:
+    case SYS_OPEN:
+    case SYS_FILESIZE:
+    case SYS_SEEK:
+    case SYS_TELL:
+    case SYS_CLOSE:
+      result = syscall_invoke (sqe->nr, sqe->args);
+      break;
+
+    default:
+      result = -1;
+      break;
+    }
+
+  lock_acquire (&rs->lock);
+  post (rs, sqe->user_data, result);
+  lock_release (&rs->lock);
+}
+
+/* Adds a completion with USER_DATA and RESULT to RS's completion
+   queue.  Caller must hold RS's lock. */
+static void
+post (struct ring_state *rs, unsigned user_data, int result)
+{
+  volatile struct ring_cqe *cqe = &rs->ring->cq[rs->cq_tail % RING_CQ_SIZE];
+
+  cqe->user_data = user_data;
+  cqe->result = result;
+  barrier ();
+  rs->ring->cq_tail = ++rs->cq_tail;
+}
+
+/* Cleans up the completed requests of RS, which must belong to
+   the current process. */
+static void
+reap (struct ring_state *rs)
+{
+  for (;;)
+    {
+      struct request *r = NULL;
+
+      lock_acquire (&rs->lock);
+      if (!list_empty (&rs->done))
+        r = list_entry (list_pop_front (&rs->done), struct request, elem);
+      lock_release (&rs->lock);
+
+      if (r == NULL)
+        break;
+      request_destroy (r);
+    }
+}
+
+/* Creates a request for the read or write in SQE, submitted to
+   RS by the current process.  Returns the request, or a null
+   pointer if the file descriptor or buffer is bad or memory is
+   exhausted. */
+static struct request *
+request_create (struct ring_state *rs, const struct ring_sqe *sqe)
+{
+  int handle = sqe->args[0];
+  struct file *file = NULL;
+  struct request *r;
+
+  if ((off_t) sqe->ofs < 0)
+    return NULL;
+  /* Writes to a standard output that has not been redirected go
+     to the console.  Pipes are not supported. */
+  file = syscall_reopen_file (handle);
+  if (file == NULL
+      && (sqe->nr == SYS_READ || handle != STDOUT_FILENO
+          || syscall_is_open (handle)))
+    return NULL;
+
+  r = malloc (sizeof *r);
+  if (r == NULL)
+    {
+      if (file != NULL)
+        {
+          lock_acquire (&filesys_lock);
+          file_close (file);
+          lock_release (&filesys_lock);
+        }
+      return NULL;
+    }
+  r->rs = rs;
+  r->read = sqe->nr == SYS_READ;
+  r->file = file;
+  r->ofs = sqe->ofs;
+  r->ubuf = (uint8_t *) sqe->args[1];
+  r->kbuf = NULL;
+  r->size = (unsigned) sqe->args[2];
+  if (r->size > RING_IO_MAX)
+    r->size = RING_IO_MAX;
+  r->pinned = false;
+  r->user_data = sqe->user_data;
+
+  if (r->read)
+    {
+      r->pinned = uaccess_pin (r->ubuf, r->size, true);
+      if (!r->pinned)
+        goto error;
+    }
+  else
+    {
+      r->kbuf = palloc_get_page (0);
+      if (r->kbuf == NULL || !copy_from_user (r->kbuf, r->ubuf, r->size))
+        goto error;
+    }
+  return r;
+
+ error:
+  request_destroy (r);
+  return NULL;
+}
+
+/* Frees request R, which must belong to the current process. */
+static void
+request_destroy (struct request *r)
+{
+  if (r->pinned)
+    uaccess_unpin (r->ubuf, r->size);
+  palloc_free_page (r->kbuf);
+  if (r->file != NULL)
+    {
+      lock_acquire (&filesys_lock);
+      file_close (r->file);
+      lock_release (&filesys_lock);
+    }
+  free (r);
+}
+
+/* Carries out requests. */
+static void
+worker_thread (void *aux UNUSED)
+{
+  for (;;)
+    {
+      struct request *r;
+      struct ring_state *rs;
+      int result;
+
+      lock_acquire (&queue_lock);
+      while (list_empty (&queue))
+        cond_wait (&queue_ready, &queue_lock);
+      r = list_entry (list_pop_front (&queue), struct request, elem);
+      lock_release (&queue_lock);
+
+      result = r->read ? do_read (r) : do_write (r);
+
+      rs = r->rs;
+      lock_acquire (&rs->lock);
+      post (rs, r->user_data, result);
+      rs->pending--;
+      list_push_back (&rs->done, &r->elem);
+      cond_signal (&rs->completed, &rs->lock);
+      lock_release (&rs->lock);
+    }
+}
+
+/* Reads the data for read request R into its pinned buffer, a
+   page at a time through the kernel's mapping of each page.
+   Returns the number of bytes read. */
+static int
+do_read (struct request *r)
+{
+  size_t total = 0;
+
+  while (total < r->size)
+    {
+      uint8_t *uaddr = r->ubuf + total;
+      uint8_t *kaddr = pagedir_get_page (r->rs->pagedir, uaddr);
+      size_t cnt = PGSIZE - pg_ofs (uaddr);
+      off_t bytes;
+
+      if (cnt > r->size - total)
+        cnt = r->size - total;
+
+      lock_acquire (&filesys_lock);
+      bytes = file_read_at (r->file, kaddr, cnt, r->ofs + total);
+      lock_release (&filesys_lock);
+
+      total += bytes;
+      if ((size_t) bytes != cnt)
+        break;
+    }
+  return total;
+}
+
+/* Writes the data for write request R.  Returns the number of
+   bytes written. */
+static int
+do_write (struct request *r)
+{
+  int bytes;
+
+  if (r->file == NULL)
+    {
+      putbuf ((const char *) r->kbuf, r->size);
+      return r->size;
+    }
+
+  lock_acquire (&filesys_lock);
+  bytes = file_write_at (r->file, r->kbuf, r->size, r->ofs);
+  lock_release (&filesys_lock);
+  return bytes;
+}
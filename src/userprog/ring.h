@@ -0,0 +1,9 @@
+#ifndef USERPROG_RING_H
+#define USERPROG_RING_H
+
+void ring_init (void);
+void *ring_setup (void);
+int ring_enter (unsigned to_submit, unsigned min_complete);
+void ring_exit (void);
+
+#endif /* userprog/ring.h */
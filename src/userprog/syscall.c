@@ -1,20 +1,1409 @@
 #include "userprog/syscall.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <poll.h>
+#include <round.h>
 #include <stdio.h>
 #include <syscall-nr.h>
+#include <tsc.h>
+#include <uio.h>
+#include "devices/input.h"
+#include "devices/shutdown.h"
+#include "devices/timer.h"
+#include "filesys/directory.h"
+#include "filesys/file.h"
+#include "filesys/filesys.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "threads/waitq.h"
+#include "userprog/futex.h"
+#include "userprog/pipe.h"
+#include "userprog/process.h"
+#include "userprog/ring.h"
+#include "userprog/tss.h"
+#include "userprog/uaccess.h"
+#ifdef VM
+#include "vm/oom.h"
+#include "vm/page.h"
+#endif
 
+/* System call dispatch.
+
+   Each system call is described by an entry in `syscalls',
+   indexed by its number, that gives the function implementing
+   it and how many argument words it takes.  The handler copies
+   exactly that many words from the user stack, with a single
+   range check and fault-protected copy, and passes them to the
+   function, whose return value becomes the caller's %eax.  A
+   bad system call number or stack pointer kills the process.
+
+   User programs enter through "int $0x30" or, on CPUs that
+   support it, through "sysenter" at sysenter_entry, which builds
+   the same interrupt frame and returns faster with "sysexit".
+
+   System calls may also be submitted in batches through a
+   process's system call ring; see userprog/ring.c.
+
+   A file descriptor refers to an open file or to one end of a
+   pipe.  A process's descriptors are kept in an array indexed by
+   handle, which grows as needed, along with a bitmap of the
+   handles in use, so that looking up a descriptor takes constant
+   time and a new descriptor gets the lowest free handle.  Handles
+   0 and 1, the standard input and output, refer to the console
+   until the process gives them descriptors of their own with
+   dup2(); other descriptors get handles from 2 up.  A new process
+   inherits its parent's standard input and output descriptors,
+   unless they are marked close-on-exec, which is how a shell
+   connects the commands of a pipeline.  Pintos does not pass on
+   any other descriptors.
+
+   The handler also counts the calls made to each system call
+   and the cycles spent in them, which are printed at shutdown.
+   The cycles are elapsed time, so a call that blocks, such as
+   a console read, is charged for the time it waits. */
+
+/* Most arguments any system call takes. */
+#define SYSCALL_MAX_ARGS 4
+
+/* Implementation of a system call, given its arguments. */
+typedef int syscall_func (const int args[]);
+
+/* A system call. */
+struct syscall
+  {
+    syscall_func *func;         /* Implementation, or null if none. */
+    size_t arg_cnt;             /* Number of argument words. */
+    const char *name;           /* Name, for statistics. */
+  };
+
+static syscall_func sys_halt, sys_exit, sys_exec, sys_wait;
+static syscall_func sys_create, sys_remove, sys_open, sys_filesize;
+static syscall_func sys_read, sys_write, sys_seek, sys_tell, sys_close;
+static syscall_func sys_readv, sys_writev, sys_pread, sys_pwrite;
+static syscall_func sys_ring_setup, sys_ring_enter, sys_sbrk;
+static syscall_func sys_pipe, sys_dup, sys_dup2, sys_fcntl, sys_poll;
+static syscall_func sys_thread_create, sys_thread_exit, sys_thread_join;
+static syscall_func sys_futex_wait, sys_futex_wake;
+#ifdef VM
+static syscall_func sys_vmstat, sys_madvise, sys_oom_adjust;
+#endif
+
+/* System calls, indexed by number. */
+static const struct syscall syscalls[] =
+  {
+    [SYS_HALT] = {sys_halt, 0, "halt"},
+    [SYS_EXIT] = {sys_exit, 1, "exit"},
+    [SYS_EXEC] = {sys_exec, 1, "exec"},
+    [SYS_WAIT] = {sys_wait, 1, "wait"},
+    [SYS_CREATE] = {sys_create, 2, "create"},
+    [SYS_REMOVE] = {sys_remove, 1, "remove"},
+    [SYS_OPEN] = {sys_open, 1, "open"},
+    [SYS_FILESIZE] = {sys_filesize, 1, "filesize"},
+    [SYS_READ] = {sys_read, 3, "read"},
+    [SYS_WRITE] = {sys_write, 3, "write"},
+    [SYS_SEEK] = {sys_seek, 2, "seek"},
+    [SYS_TELL] = {sys_tell, 1, "tell"},
+    [SYS_CLOSE] = {sys_close, 1, "close"},
+#ifdef VM
+    [SYS_VMSTAT] = {sys_vmstat, 1, "vmstat"},
+    [SYS_MADVISE] = {sys_madvise, 3, "madvise"},
+    [SYS_OOM_ADJUST] = {sys_oom_adjust, 1, "oom_adjust"},
+#endif
+    [SYS_READV] = {sys_readv, 3, "readv"},
+    [SYS_WRITEV] = {sys_writev, 3, "writev"},
+    [SYS_PREAD] = {sys_pread, 4, "pread"},
+    [SYS_PWRITE] = {sys_pwrite, 4, "pwrite"},
+    [SYS_RING_SETUP] = {sys_ring_setup, 0, "ring_setup"},
+    [SYS_RING_ENTER] = {sys_ring_enter, 2, "ring_enter"},
+    [SYS_SBRK] = {sys_sbrk, 1, "sbrk"},
+    [SYS_PIPE] = {sys_pipe, 1, "pipe"},
+    [SYS_DUP2] = {sys_dup2, 2, "dup2"},
+    [SYS_DUP] = {sys_dup, 1, "dup"},
+    [SYS_FCNTL] = {sys_fcntl, 3, "fcntl"},
+    [SYS_POLL] = {sys_poll, 3, "poll"},
+    [SYS_THREAD_CREATE] = {sys_thread_create, 3, "thread_create"},
+    [SYS_THREAD_EXIT] = {sys_thread_exit, 1, "thread_exit"},
+    [SYS_THREAD_JOIN] = {sys_thread_join, 1, "thread_join"},
+    [SYS_FUTEX_WAIT] = {sys_futex_wait, 2, "futex_wait"},
+    [SYS_FUTEX_WAKE] = {sys_futex_wake, 2, "futex_wake"},
+  };
+
+/* Number of entries in `syscalls'. */
+#define SYSCALL_CNT (sizeof syscalls / sizeof *syscalls)
+
+/* Statistics, indexed by system call number. */
+static long long call_cnt[SYSCALL_CNT];     /* Number of calls. */
+static uint64_t call_cycles[SYSCALL_CNT];   /* Cycles spent in calls. */
+
+/* Number of slots in a process's first descriptor array, and
+   the most handles a process may use. */
+#define FD_MIN 16
+#define FD_MAX 1024
+
+/* An open file or pipe end.
+
+   Each handle that refers to a descriptor, in any process's
+   descriptor array, holds one reference to it, so that handles
+   made by dup(), dup2(), or inheritance share one file position.
+   A system call that uses a descriptor holds another reference
+   while it does, so that a sibling thread that closes the handle
+   meanwhile does not free the descriptor out from under it.
+   Close-on-exec is a property of the handle, not the descriptor,
+   so it is kept in the array's owner's `fd_cloexec' bitmap. */
+struct file_descriptor
+  {
+    struct lock lock;           /* Protects REF_CNT. */
+    int ref_cnt;                /* Number of references. */
+    struct file *file;          /* Open file, or null for a pipe. */
+    struct pipe *pipe;          /* Pipe, or null for a file. */
+    bool pipe_write;            /* Write end of PIPE? */
+  };
+
+void sysenter_entry (void);
 static void syscall_handler (struct intr_frame *);
+static void kill_process (void) NO_RETURN;
+static bool copy_in_name (char name[NAME_MAX + 2], const char *uname);
+static struct file_descriptor *create_fd (struct file *, struct pipe *,
+                                          bool pipe_write);
+static struct file_descriptor *lookup_fd (int handle);
+static struct file_descriptor *lookup_thread_fd (struct thread *,
+                                                 int handle);
+static bool install_fd (struct thread *, struct file_descriptor *,
+                        int handle);
+static int add_fd (struct file_descriptor *);
+static struct file_descriptor *remove_fd (int handle);
+static struct file_descriptor *get_fd (struct file_descriptor *);
+static void put_fd (struct file_descriptor *);
+static unsigned poll_fd (int handle, struct file_descriptor *,
+                         struct waiter *, struct waitq_entry *);
+static int transfer_pipe (struct file_descriptor *, const struct iovec *,
+                          size_t iov_cnt, bool read);
+static int transfer_fd (int handle, const struct iovec *, size_t iov_cnt,
+                        off_t ofs, bool read);
+static int transfer_iov (int handle, const struct iovec *uiov, int iov_cnt,
+                         bool read);
+static int transfer (struct file *, const struct iovec *, size_t iov_cnt,
+                     off_t ofs, bool read);
 
 void
-syscall_init (void) 
+syscall_init (void)
 {
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
+  tss_enable_sysenter (sysenter_entry);
+}
+
+/* Closes the files that the current process has open.  Called
+   when the process's last thread exits. */
+void
+syscall_exit (void)
+{
+  struct thread *t = process_current ();
+  size_t handle;
+
+  for (handle = 0; handle < t->fd_cap; handle++)
+    if (t->fds[handle] != NULL)
+      put_fd (t->fds[handle]);
+  free (t->fds);
+  if (t->fd_map != NULL)
+    bitmap_destroy (t->fd_map);
+  if (t->fd_cloexec != NULL)
+    bitmap_destroy (t->fd_cloexec);
+  t->fds = NULL;
+  t->fd_cap = 0;
+  t->fd_map = NULL;
+  t->fd_cloexec = NULL;
+}
+
+/* Gives the current process, which must be new, the standard
+   input and output descriptors of the process that thread PARENT
+   belongs to, if it has them and they are not marked
+   close-on-exec.  The two processes share them afterward, as
+   with dup().  PARENT must not run meanwhile.  Returns
+   false if memory is exhausted. */
+bool
+syscall_inherit (struct thread *parent)
+{
+  struct thread *t = process_current ();
+  struct thread *p = parent->process;
+  bool success = true;
+  int handle;
+
+  lock_acquire (&p->fds_lock);
+  lock_acquire (&t->fds_lock);
+  for (handle = STDIN_FILENO; handle <= STDOUT_FILENO; handle++)
+    {
+      struct file_descriptor *fd = lookup_thread_fd (p, handle);
+      if (fd != NULL && !bitmap_test (p->fd_cloexec, handle))
+        {
+          if (!install_fd (t, get_fd (fd), handle))
+            {
+              put_fd (fd);
+              success = false;
+              break;
+            }
+        }
+    }
+  lock_release (&t->fds_lock);
+  lock_release (&p->fds_lock);
+  return success;
+}
+
+/* Prints system call statistics. */
+void
+syscall_print_stats (void)
+{
+  size_t nr;
+
+  for (nr = 0; nr < SYSCALL_CNT; nr++)
+    if (call_cnt[nr] > 0)
+      printf ("Syscall: %s: %lld calls, %"PRIu64" cycles "
+              "(%"PRIu64" per call)\n", syscalls[nr].name, call_cnt[nr],
+              call_cycles[nr], call_cycles[nr] / call_cnt[nr]);
+}
+
+static void
+syscall_handler (struct intr_frame *f)
+{
+  int args[SYSCALL_MAX_ARGS];
+  unsigned nr;
+
+#ifdef VM
+  /* Page faults taken in the kernel on behalf of this call need
+     the user stack pointer to recognize stack growth. */
+  thread_current ()->user_esp = f->esp;
+#endif
+
+  if (!copy_from_user (&nr, f->esp, sizeof nr)
+      || nr >= SYSCALL_CNT || syscalls[nr].func == NULL)
+    kill_process ();
+  if (!copy_from_user (args, (int *) f->esp + 1,
+                       syscalls[nr].arg_cnt * sizeof *args))
+    kill_process ();
+
+  f->eax = syscall_invoke (nr, args);
+}
+
+/* Makes system call NR, which must exist, with arguments ARGS,
+   on behalf of the current process, and returns its result. */
+int
+syscall_invoke (unsigned nr, const int args[])
+{
+  enum intr_level old_level;
+  uint64_t start;
+  int retval;
+
+  ASSERT (nr < SYSCALL_CNT && syscalls[nr].func != NULL);
+
+  /* Count the call before making it, since exit() doesn't
+     return. */
+  old_level = intr_disable ();
+  call_cnt[nr]++;
+  intr_set_level (old_level);
+
+  start = rdtsc ();
+  retval = syscalls[nr].func (args);
+
+  old_level = intr_disable ();
+  call_cycles[nr] += rdtsc () - start;
+  intr_set_level (old_level);
+  return retval;
+}
+
+/* Returns a new file that reopens the current process's open
+   file with the given HANDLE, for the caller to close, or a null
+   pointer if there is none, if HANDLE is a pipe, or if memory is
+   exhausted. */
+struct file *
+syscall_reopen_file (int handle)
+{
+  struct file_descriptor *fd = lookup_fd (handle);
+  struct file *file = NULL;
+
+  if (fd != NULL && fd->file != NULL)
+    {
+      lock_acquire (&filesys_lock);
+      file = file_reopen (fd->file);
+      lock_release (&filesys_lock);
+    }
+  if (fd != NULL)
+    put_fd (fd);
+  return file;
+}
+
+/* Returns true if the current process has a descriptor with the
+   given HANDLE. */
+bool
+syscall_is_open (int handle)
+{
+  struct file_descriptor *fd = lookup_fd (handle);
+
+  if (fd == NULL)
+    return false;
+  put_fd (fd);
+  return true;
+}
+
+/* Terminates the current process with exit status -1, as for a
+   process that passes a bad pointer to a system call. */
+static void
+kill_process (void)
+{
+  process_terminate (-1);
+}
+
+/* Copies the file name at user address UNAME into NAME.  Returns
+   false if the name is too long to be valid.  Terminates the
+   process if UNAME is not a string in user memory. */
+static bool
+copy_in_name (char name[NAME_MAX + 2], const char *uname)
+{
+  int length = strncpy_from_user (name, uname, NAME_MAX + 2);
+  if (length < 0)
+    kill_process ();
+  return length <= NAME_MAX;
+}
+
+/* Returns a new descriptor, with one reference, for FILE or, if
+   FILE is null, for the write end of PIPE if PIPE_WRITE is true
+   or its read end otherwise.  Returns a null pointer if memory
+   is exhausted. */
+static struct file_descriptor *
+create_fd (struct file *file, struct pipe *pipe, bool pipe_write)
+{
+  struct file_descriptor *fd = malloc (sizeof *fd);
+  if (fd == NULL)
+    return NULL;
+
+  lock_init (&fd->lock);
+  fd->ref_cnt = 1;
+  fd->file = file;
+  fd->pipe = pipe;
+  fd->pipe_write = pipe_write;
+  return fd;
+}
+
+/* Returns the current process's descriptor with the given
+   HANDLE, with a new reference that the caller must drop with
+   put_fd(), or a null pointer if there is none. */
+static struct file_descriptor *
+lookup_fd (int handle)
+{
+  struct thread *p = process_current ();
+  struct file_descriptor *fd;
+
+  lock_acquire (&p->fds_lock);
+  fd = lookup_thread_fd (p, handle);
+  if (fd != NULL)
+    get_fd (fd);
+  lock_release (&p->fds_lock);
+  return fd;
 }
 
+/* Returns process T's descriptor with the given HANDLE, or a
+   null pointer if there is none.  T must be a process's first
+   thread, and its fds_lock must be held. */
+static struct file_descriptor *
+lookup_thread_fd (struct thread *t, int handle)
+{
+  ASSERT (lock_held_by_current_thread (&t->fds_lock));
+
+  return (handle >= 0 && (size_t) handle < t->fd_cap
+          ? t->fds[handle] : NULL);
+}
+
+/* Puts FD in process T's descriptor array under HANDLE, which
+   must be free, growing the array if necessary.  The new handle
+   is not marked close-on-exec.  Returns false
+   if HANDLE is FD_MAX or more or if memory is exhausted.  T must
+   be a process's first thread, and its fds_lock must be held. */
+static bool
+install_fd (struct thread *t, struct file_descriptor *fd, int handle)
+{
+  ASSERT (lock_held_by_current_thread (&t->fds_lock));
+  ASSERT (lookup_thread_fd (t, handle) == NULL);
+
+  if (handle < 0 || handle >= FD_MAX)
+    return false;
+  if ((size_t) handle >= t->fd_cap)
+    {
+      /* Double the array until HANDLE fits. */
+      size_t new_cap = t->fd_cap > 0 ? t->fd_cap : FD_MIN;
+      struct file_descriptor **new_fds;
+      struct bitmap *new_map, *new_cloexec;
+      size_t i;
+
+      while (new_cap <= (size_t) handle)
+        new_cap *= 2;
+      new_fds = calloc (new_cap, sizeof *new_fds);
+      new_map = bitmap_create (new_cap);
+      new_cloexec = bitmap_create (new_cap);
+      if (new_fds == NULL || new_map == NULL || new_cloexec == NULL)
+        {
+          free (new_fds);
+          if (new_map != NULL)
+            bitmap_destroy (new_map);
+          if (new_cloexec != NULL)
+            bitmap_destroy (new_cloexec);
+          return false;
+        }
+      for (i = 0; i < t->fd_cap; i++)
+        if (t->fds[i] != NULL)
+          {
+            new_fds[i] = t->fds[i];
+            bitmap_mark (new_map, i);
+            bitmap_set (new_cloexec, i, bitmap_test (t->fd_cloexec, i));
+          }
+      free (t->fds);
+      if (t->fd_map != NULL)
+        bitmap_destroy (t->fd_map);
+      if (t->fd_cloexec != NULL)
+        bitmap_destroy (t->fd_cloexec);
+      t->fds = new_fds;
+      t->fd_cap = new_cap;
+      t->fd_map = new_map;
+      t->fd_cloexec = new_cloexec;
+    }
+  t->fds[handle] = fd;
+  bitmap_mark (t->fd_map, handle);
+  bitmap_reset (t->fd_cloexec, handle);
+  return true;
+}
+
+/* Adds FD to the current process's descriptors, under the lowest
+   free handle other than 0 or 1, and returns the handle.  Returns
+   -1 if the process has too many descriptors or memory is
+   exhausted. */
+static int
+add_fd (struct file_descriptor *fd)
+{
+  struct thread *p = process_current ();
+  size_t slot = BITMAP_ERROR;
+  int handle;
+
+  lock_acquire (&p->fds_lock);
+  if (p->fd_map != NULL)
+    slot = bitmap_scan (p->fd_map, STDOUT_FILENO + 1, 1, false);
+  if (slot == BITMAP_ERROR)
+    slot = p->fd_cap > STDOUT_FILENO ? p->fd_cap : STDOUT_FILENO + 1;
+  handle = slot < FD_MAX && install_fd (p, fd, slot) ? (int) slot : -1;
+  lock_release (&p->fds_lock);
+  return handle;
+}
+
+/* Removes the current process's descriptor with the given
+   HANDLE and returns it, along with the reference that the
+   descriptor array held, or returns a null pointer if there is
+   none. */
+static struct file_descriptor *
+remove_fd (int handle)
+{
+  struct thread *p = process_current ();
+  struct file_descriptor *fd;
+
+  lock_acquire (&p->fds_lock);
+  fd = lookup_thread_fd (p, handle);
+  if (fd != NULL)
+    {
+      p->fds[handle] = NULL;
+      bitmap_reset (p->fd_map, handle);
+      bitmap_reset (p->fd_cloexec, handle);
+    }
+  lock_release (&p->fds_lock);
+  return fd;
+}
+
+/* Takes a new reference to FD and returns FD. */
+static struct file_descriptor *
+get_fd (struct file_descriptor *fd)
+{
+  lock_acquire (&fd->lock);
+  fd->ref_cnt++;
+  lock_release (&fd->lock);
+  return fd;
+}
+
+/* Drops a reference to FD.  When the last one goes, closes FD's
+   file or pipe end and frees FD, which must no longer be in a
+   descriptor array by then. */
 static void
-syscall_handler (struct intr_frame *f UNUSED) 
+put_fd (struct file_descriptor *fd)
+{
+  bool dead;
+
+  lock_acquire (&fd->lock);
+  dead = --fd->ref_cnt == 0;
+  lock_release (&fd->lock);
+  if (!dead)
+    return;
+
+  if (fd->pipe != NULL)
+    pipe_close (fd->pipe, fd->pipe_write);
+  else
+    {
+      lock_acquire (&filesys_lock);
+      file_close (fd->file);
+      lock_release (&filesys_lock);
+    }
+  free (fd);
+}
+
+/* Halt system call. */
+static int
+sys_halt (const int args[] UNUSED)
+{
+  shutdown_power_off ();
+}
+
+/* Exit system call. */
+static int
+sys_exit (const int args[])
+{
+  process_terminate (args[0]);
+}
+
+/* Exec system call. */
+static int
+sys_exec (const int args[])
+{
+  char *cmd_line;
+  tid_t tid;
+  int length;
+
+  cmd_line = palloc_get_page (0);
+  if (cmd_line == NULL)
+    return -1;
+  length = strncpy_from_user (cmd_line, (const char *) args[0], PGSIZE);
+  if (length < 0)
+    {
+      palloc_free_page (cmd_line);
+      kill_process ();
+    }
+
+  tid = length < PGSIZE ? process_execute (cmd_line) : TID_ERROR;
+  palloc_free_page (cmd_line);
+  return tid;
+}
+
+/* Wait system call. */
+static int
+sys_wait (const int args[])
+{
+  return process_wait (args[0]);
+}
+
+/* Create system call. */
+static int
+sys_create (const int args[])
+{
+  char name[NAME_MAX + 2];
+  bool success;
+
+  if (!copy_in_name (name, (const char *) args[0]))
+    return false;
+
+  lock_acquire (&filesys_lock);
+  success = filesys_create (name, (unsigned) args[1]);
+  lock_release (&filesys_lock);
+  return success;
+}
+
+/* Remove system call. */
+static int
+sys_remove (const int args[])
+{
+  char name[NAME_MAX + 2];
+  bool success;
+
+  if (!copy_in_name (name, (const char *) args[0]))
+    return false;
+
+  lock_acquire (&filesys_lock);
+  success = filesys_remove (name);
+  lock_release (&filesys_lock);
+  return success;
+}
+
+/* Open system call. */
+static int
+sys_open (const int args[])
+{
+  char name[NAME_MAX + 2];
+  struct file_descriptor *fd;
+  struct file *file;
+  int handle;
+
+  if (!copy_in_name (name, (const char *) args[0]))
+    return -1;
+
+  lock_acquire (&filesys_lock);
+  file = filesys_open (name);
+  lock_release (&filesys_lock);
+  if (file == NULL)
+    return -1;
+
+  fd = create_fd (file, NULL, false);
+  if (fd == NULL)
+    {
+      lock_acquire (&filesys_lock);
+      file_close (file);
+      lock_release (&filesys_lock);
+      return -1;
+    }
+  handle = add_fd (fd);
+  if (handle < 0)
+    put_fd (fd);
+  return handle;
+}
+
+/* Filesize system call. */
+static int
+sys_filesize (const int args[])
+{
+  struct file_descriptor *fd = lookup_fd (args[0]);
+  int size = -1;
+
+  if (fd == NULL)
+    return -1;
+  if (fd->file != NULL)
+    {
+      lock_acquire (&filesys_lock);
+      size = file_length (fd->file);
+      lock_release (&filesys_lock);
+    }
+  put_fd (fd);
+  return size;
+}
+
+/* Read system call. */
+static int
+sys_read (const int args[])
+{
+  int handle = args[0];
+  uint8_t *ubuf = (uint8_t *) args[1];
+  unsigned size = args[2];
+  struct iovec iov;
+
+  if (handle == STDIN_FILENO && !syscall_is_open (handle))
+    {
+      unsigned i;
+
+      for (i = 0; i < size; i++)
+        {
+          uint8_t c = input_getc ();
+          if (!copy_to_user (ubuf + i, &c, 1))
+            kill_process ();
+        }
+      return size;
+    }
+
+  iov.iov_base = ubuf;
+  iov.iov_len = size;
+  return transfer_fd (handle, &iov, 1, -1, true);
+}
+
+/* Write system call. */
+static int
+sys_write (const int args[])
+{
+  struct iovec iov;
+
+  iov.iov_base = (void *) args[1];
+  iov.iov_len = (unsigned) args[2];
+  return transfer_fd (args[0], &iov, 1, -1, false);
+}
+
+/* Seek system call. */
+static int
+sys_seek (const int args[])
+{
+  struct file_descriptor *fd = lookup_fd (args[0]);
+
+  if (fd == NULL)
+    return 0;
+  if (fd->file != NULL && args[1] >= 0)
+    {
+      lock_acquire (&filesys_lock);
+      file_seek (fd->file, args[1]);
+      lock_release (&filesys_lock);
+    }
+  put_fd (fd);
+  return 0;
+}
+
+/* Tell system call. */
+static int
+sys_tell (const int args[])
+{
+  struct file_descriptor *fd = lookup_fd (args[0]);
+  int position = -1;
+
+  if (fd == NULL)
+    return -1;
+  if (fd->file != NULL)
+    {
+      lock_acquire (&filesys_lock);
+      position = file_tell (fd->file);
+      lock_release (&filesys_lock);
+    }
+  put_fd (fd);
+  return position;
+}
+
+/* Close system call. */
+static int
+sys_close (const int args[])
+{
+  struct file_descriptor *fd = remove_fd (args[0]);
+
+  if (fd != NULL)
+    put_fd (fd);
+  return 0;
+}
+
+/* Readv system call. */
+static int
+sys_readv (const int args[])
+{
+  return transfer_iov (args[0], (const struct iovec *) args[1], args[2], true);
+}
+
+/* Writev system call. */
+static int
+sys_writev (const int args[])
+{
+  return transfer_iov (args[0], (const struct iovec *) args[1], args[2],
+                       false);
+}
+
+/* Pread system call. */
+static int
+sys_pread (const int args[])
+{
+  struct iovec iov;
+
+  if (args[3] < 0)
+    return -1;
+  iov.iov_base = (void *) args[1];
+  iov.iov_len = (unsigned) args[2];
+  return transfer_fd (args[0], &iov, 1, args[3], true);
+}
+
+/* Pwrite system call. */
+static int
+sys_pwrite (const int args[])
+{
+  struct iovec iov;
+
+  if (args[3] < 0)
+    return -1;
+  iov.iov_base = (void *) args[1];
+  iov.iov_len = (unsigned) args[2];
+  return transfer_fd (args[0], &iov, 1, args[3], false);
+}
+
+/* Ring_setup system call. */
+static int
+sys_ring_setup (const int args[] UNUSED)
+{
+  return (int) ring_setup ();
+}
+
+/* Ring_enter system call. */
+static int
+sys_ring_enter (const int args[])
+{
+  return ring_enter (args[0], args[1]);
+}
+
+/* Sbrk system call. */
+static int
+sys_sbrk (const int args[])
+{
+  void *old_brk = process_sbrk (args[0]);
+  return old_brk != NULL ? (int) old_brk : -1;
+}
+
+/* Pipe system call. */
+static int
+sys_pipe (const int args[])
+{
+  struct file_descriptor *ends[2];
+  int handles[2];
+  struct pipe *p;
+  int i;
+
+  p = pipe_create ();
+  if (p == NULL)
+    return false;
+
+  /* The read end comes first, then the write end. */
+  for (i = 0; i < 2; i++)
+    ends[i] = create_fd (NULL, p, i == 1);
+  if (ends[0] == NULL || ends[1] == NULL)
+    {
+      for (i = 0; i < 2; i++)
+        if (ends[i] != NULL)
+          put_fd (ends[i]);
+        else
+          pipe_close (p, i == 1);
+      return false;
+    }
+  handles[0] = add_fd (ends[0]);
+  handles[1] = handles[0] >= 0 ? add_fd (ends[1]) : -1;
+  if (handles[1] < 0)
+    {
+      if (handles[0] >= 0)
+        remove_fd (handles[0]);
+      put_fd (ends[0]);
+      put_fd (ends[1]);
+      return false;
+    }
+
+  if (!copy_to_user ((int *) args[0], handles, sizeof handles))
+    kill_process ();
+  return true;
+}
+
+/* Dup system call. */
+static int
+sys_dup (const int args[])
+{
+  struct file_descriptor *fd = lookup_fd (args[0]);
+  int handle;
+
+  /* The reference from lookup_fd() becomes the new handle's. */
+  if (fd == NULL)
+    return -1;
+  handle = add_fd (fd);
+  if (handle < 0)
+    put_fd (fd);
+  return handle;
+}
+
+/* Dup2 system call. */
+static int
+sys_dup2 (const int args[])
+{
+  struct thread *p = process_current ();
+  struct file_descriptor *fd = lookup_fd (args[0]);
+  struct file_descriptor *closed_fd;
+  int handle = args[1];
+
+  /* The reference from lookup_fd() becomes the new handle's. */
+  if (fd == NULL)
+    return -1;
+  if (handle < 0 || handle >= FD_MAX || handle == args[0])
+    {
+      put_fd (fd);
+      return handle == args[0] ? handle : -1;
+    }
+
+  lock_acquire (&p->fds_lock);
+  closed_fd = lookup_thread_fd (p, handle);
+  if (closed_fd != NULL)
+    {
+      p->fds[handle] = fd;
+      bitmap_reset (p->fd_cloexec, handle);
+    }
+  else if (!install_fd (p, fd, handle))
+    {
+      closed_fd = fd;
+      handle = -1;
+    }
+  lock_release (&p->fds_lock);
+
+  if (closed_fd != NULL)
+    put_fd (closed_fd);
+  return handle;
+}
+
+/* Fcntl system call. */
+static int
+sys_fcntl (const int args[])
+{
+  struct thread *p = process_current ();
+  int handle = args[0];
+  int result = -1;
+
+  lock_acquire (&p->fds_lock);
+  if (lookup_thread_fd (p, handle) != NULL)
+    switch (args[1])
+      {
+      case F_GETFD:
+        result = bitmap_test (p->fd_cloexec, handle) ? FD_CLOEXEC : 0;
+        break;
+      case F_SETFD:
+        bitmap_set (p->fd_cloexec, handle, (args[2] & FD_CLOEXEC) != 0);
+        result = 0;
+        break;
+      }
+  lock_release (&p->fds_lock);
+  return result;
+}
+
+/* Poll system call. */
+static int
+sys_poll (const int args[])
+{
+  struct pollfd *ufds = (struct pollfd *) args[0];
+  unsigned nfds = args[1];
+  int timeout = args[2];
+  struct pollfd fds[POLL_MAX];
+  struct file_descriptor *fd[POLL_MAX];
+  struct waitq_entry entries[POLL_MAX];
+  struct waiter w;
+  bool first = true;
+  int64_t deadline;
+  int ready_cnt;
+  unsigned i;
+
+  if (nfds > POLL_MAX)
+    return -1;
+  if (!copy_from_user (fds, ufds, nfds * sizeof *fds))
+    kill_process ();
+  deadline = -1;
+  if (timeout >= 0)
+    deadline = (timer_ticks ()
+                + DIV_ROUND_UP ((int64_t) timeout * TIMER_FREQ, 1000));
+
+  /* Hold a reference to every descriptor for the whole call, so
+     that a sibling thread closing one cannot free the pipe whose
+     wait queue we are on.  Register on the wait queue of every
+     descriptor on the first pass, then sleep until one of them is
+     woken and look again. */
+  waiter_init (&w);
+  for (i = 0; i < nfds; i++)
+    {
+      fd[i] = fds[i].fd >= 0 ? lookup_fd (fds[i].fd) : NULL;
+      entries[i].queue = NULL;
+    }
+  for (;;)
+    {
+      ready_cnt = 0;
+      for (i = 0; i < nfds; i++)
+        {
+          unsigned events = 0;
+
+          if (fds[i].fd >= 0)
+            events = poll_fd (fds[i].fd, fd[i], first ? &w : NULL,
+                              &entries[i]);
+          fds[i].revents = events & (fds[i].events
+                                     | POLLERR | POLLHUP | POLLNVAL);
+          if (fds[i].revents != 0)
+            ready_cnt++;
+        }
+      first = false;
+      if (ready_cnt > 0 || !waiter_sleep (&w, deadline))
+        break;
+    }
+  for (i = 0; i < nfds; i++)
+    {
+      waitq_remove (&entries[i]);
+      if (fd[i] != NULL)
+        put_fd (fd[i]);
+    }
+
+  if (!copy_to_user (ufds, fds, nfds * sizeof *fds))
+    kill_process ();
+  return ready_cnt;
+}
+
+/* Thread_create system call. */
+static int
+sys_thread_create (const int args[])
+{
+  return process_thread_create ((void (*) (void)) args[0],
+                                (void *) args[1], (void *) args[2]);
+}
+
+/* Thread_exit system call. */
+static int
+sys_thread_exit (const int args[])
+{
+  process_thread_exit (args[0]);
+}
+
+/* Thread_join system call. */
+static int
+sys_thread_join (const int args[])
+{
+  return process_thread_join (args[0]);
+}
+
+/* Futex_wait system call. */
+static int
+sys_futex_wait (const int args[])
+{
+  bool woken;
+
+  if (!futex_wait ((const int *) args[0], args[1], &woken))
+    kill_process ();
+  return woken ? 0 : -1;
+}
+
+/* Futex_wake system call. */
+static int
+sys_futex_wake (const int args[])
+{
+  return futex_wake ((const int *) args[0], args[1]);
+}
+
+#ifdef VM
+/* Vmstat system call. */
+static int
+sys_vmstat (const int args[])
+{
+  return copy_to_user ((void *) args[0], &process_current ()->vmstat,
+                       sizeof (struct vmstat));
+}
+
+/* Madvise system call. */
+static int
+sys_madvise (const int args[])
+{
+  return page_advise ((void *) args[0], args[1], args[2]) ? 0 : -1;
+}
+
+/* Oom_adjust system call. */
+static int
+sys_oom_adjust (const int args[])
+{
+  return oom_set_adj (args[0]);
+}
+#endif
+
+/* Returned by transfer() and its helpers when a user buffer is
+   not valid user memory.  They return it instead of terminating
+   the process themselves, so that transfer_fd() can first drop
+   its reference to the descriptor. */
+#define TRANSFER_FAULT (-2)
+
+/* Does transfer() on the current process's file with the given
+   HANDLE, or transfer_pipe() if HANDLE is a pipe.  Writes to the
+   console instead if HANDLE is STDOUT_FILENO without a
+   descriptor, READ is false, and OFS is negative.  Returns -1 if
+   HANDLE is not open, or if it is a pipe and OFS is not
+   negative.  Terminates the process if a buffer is not valid
+   user memory. */
+static int
+transfer_fd (int handle, const struct iovec *iov, size_t iov_cnt, off_t ofs,
+             bool read)
+{
+  struct file_descriptor *fd = lookup_fd (handle);
+  int result;
+
+  if (fd == NULL)
+    result = (handle == STDOUT_FILENO && !read && ofs < 0
+              ? transfer (NULL, iov, iov_cnt, ofs, false)
+              : -1);
+  else
+    {
+      if (fd->pipe != NULL)
+        result = ofs < 0 ? transfer_pipe (fd, iov, iov_cnt, read) : -1;
+      else
+        result = transfer (fd->file, iov, iov_cnt, ofs, read);
+      put_fd (fd);
+    }
+
+  if (result == TRANSFER_FAULT)
+    kill_process ();
+  return result;
+}
+
+/* Reads into, if READ is true, or writes from the IOV_CNT user
+   buffers described by the array at user address UIOV, for the
+   file open as HANDLE, at its current position.  Returns the
+   number of bytes transferred, or -1 if IOV_CNT is out of range,
+   the buffers total more than INT_MAX bytes, or HANDLE is not
+   open.  Terminates the process if UIOV is not valid user
+   memory. */
+static int
+transfer_iov (int handle, const struct iovec *uiov, int iov_cnt, bool read)
+{
+  struct iovec iov[IOV_MAX];
+  size_t total = 0;
+  int i;
+
+  if (iov_cnt < 0 || iov_cnt > IOV_MAX)
+    return -1;
+  if (!copy_from_user (iov, uiov, iov_cnt * sizeof *iov))
+    kill_process ();
+  for (i = 0; i < iov_cnt; i++)
+    {
+      if (iov[i].iov_len > INT_MAX - total)
+        return -1;
+      total += iov[i].iov_len;
+    }
+  return transfer_fd (handle, iov, iov_cnt, -1, read);
+}
+
+/* A part of a user buffer, transferred in one operation. */
+struct piece
+  {
+    uint8_t *ubuf;              /* User address. */
+    size_t size;                /* Number of bytes. */
+  };
+
+/* A position in an array of user buffers. */
+struct iov_iter
+  {
+    const struct iovec *iov;    /* Buffers not yet used up. */
+    size_t iov_cnt;             /* Number of elements in IOV. */
+    size_t ofs;                 /* Bytes of IOV[0] already used. */
+  };
+
+#ifdef VM
+/* Most bytes pinned at once by transfer(). */
+#define BATCH_MAX (16 * PGSIZE)
+#else
+/* Most bytes bounced through the kernel at once by transfer(). */
+#define BATCH_MAX PGSIZE
+#endif
+
+/* Takes the next piece of at most MAX bytes from IT into *P.
+   Returns false if IT is used up. */
+static bool
+iov_next (struct iov_iter *it, size_t max, struct piece *p)
+{
+  while (it->iov_cnt > 0 && it->ofs >= it->iov->iov_len)
+    {
+      it->iov++;
+      it->iov_cnt--;
+      it->ofs = 0;
+    }
+  if (it->iov_cnt == 0)
+    return false;
+
+  p->ubuf = (uint8_t *) it->iov->iov_base + it->ofs;
+  p->size = it->iov->iov_len - it->ofs;
+  if (p->size > max)
+    p->size = max;
+  it->ofs += p->size;
+  return true;
+}
+
+/* Writes SIZE bytes from BUF to FILE, or reads them into BUF if
+   READ is true, at offset OFS, or at FILE's current position if
+   OFS is negative.  Writes them to the console instead if FILE
+   is null.  Returns the number of bytes transferred.  The caller
+   must hold filesys_lock if FILE is nonnull. */
+static int
+transfer_piece (struct file *file, void *buf, size_t size, off_t ofs,
+                bool read)
+{
+  if (file == NULL)
+    {
+      putbuf (buf, size);
+      return size;
+    }
+  else if (ofs < 0)
+    return read ? file_read (file, buf, size) : file_write (file, buf, size);
+  else
+    return (read
+            ? file_read_at (file, buf, size, ofs)
+            : file_write_at (file, buf, size, ofs));
+}
+
+/* Writes the PIECE_CNT pieces of user memory in PIECES, which
+   total SIZE bytes, to FILE, or reads into them if READ is true,
+   as for transfer_piece().  Returns the number of bytes
+   transferred, or TRANSFER_FAULT if a piece is not valid user
+   memory.
+
+   With virtual memory, the data moves directly between the file
+   system and the user's pages, which are pinned first, so that
+   the file system never faults on them while holding
+   filesys_lock.  Otherwise, it is bounced through a kernel
+   page.  Either way, the whole batch is done under one
+   acquisition of filesys_lock.  SIZE must not exceed
+   BATCH_MAX. */
+static int
+transfer_batch (struct file *file, const struct piece pieces[],
+                size_t piece_cnt, size_t size, off_t ofs, bool read)
+{
+  int total = 0;
+  size_t i;
+#ifndef VM
+  uint8_t *kbuf;
+  size_t done;
+#endif
+
+  ASSERT (size <= BATCH_MAX);
+#ifdef VM
+  for (i = 0; i < piece_cnt; i++)
+    if (!page_pin (pieces[i].ubuf, pieces[i].size, read))
+      {
+        while (i-- > 0)
+          page_unpin (pieces[i].ubuf, pieces[i].size);
+        return TRANSFER_FAULT;
+      }
+
+  if (file != NULL)
+    lock_acquire (&filesys_lock);
+  for (i = 0; i < piece_cnt; i++)
+    {
+      int bytes = transfer_piece (file, pieces[i].ubuf, pieces[i].size,
+                                  ofs < 0 ? ofs : ofs + total, read);
+      total += bytes;
+      if ((size_t) bytes != pieces[i].size)
+        break;
+    }
+  if (file != NULL)
+    lock_release (&filesys_lock);
+
+  for (i = 0; i < piece_cnt; i++)
+    page_unpin (pieces[i].ubuf, pieces[i].size);
+#else
+  kbuf = palloc_get_page (0);
+  if (kbuf == NULL)
+    return -1;
+
+  if (!read)
+    for (i = 0, done = 0; i < piece_cnt; done += pieces[i++].size)
+      if (!copy_from_user (kbuf + done, pieces[i].ubuf, pieces[i].size))
+        {
+          palloc_free_page (kbuf);
+          return TRANSFER_FAULT;
+        }
+
+  if (file != NULL)
+    lock_acquire (&filesys_lock);
+  total = transfer_piece (file, kbuf, size, ofs, read);
+  if (file != NULL)
+    lock_release (&filesys_lock);
+
+  if (read)
+    for (i = 0, done = 0; i < piece_cnt && done < (size_t) total;
+         done += pieces[i++].size)
+      {
+        size_t cnt = pieces[i].size;
+        if (cnt > (size_t) total - done)
+          cnt = (size_t) total - done;
+        if (!copy_to_user (pieces[i].ubuf, kbuf + done, cnt))
+          {
+            palloc_free_page (kbuf);
+            return TRANSFER_FAULT;
+          }
+      }
+  palloc_free_page (kbuf);
+#endif
+  return total;
+}
+
+/* Writes the IOV_CNT user buffers in IOV to FILE, in order, or
+   reads into them if READ is true, at offset OFS, or at FILE's
+   current position if OFS is negative.  Writes them to the
+   console instead if FILE is null.  Returns the number of bytes
+   transferred, or TRANSFER_FAULT if a buffer is not valid user
+   memory.
+
+   The buffers are taken in batches of up to BATCH_MAX bytes,
+   each of which is done with transfer_batch(). */
+static int
+transfer (struct file *file, const struct iovec *iov, size_t iov_cnt,
+          off_t ofs, bool read)
+{
+  struct iov_iter it;
+  int total = 0;
+
+  it.iov = iov;
+  it.iov_cnt = iov_cnt;
+  it.ofs = 0;
+  for (;;)
+    {
+      struct piece pieces[IOV_MAX];
+      size_t piece_cnt = 0;
+      size_t size = 0;
+      int bytes;
+
+      while (piece_cnt < IOV_MAX && size < BATCH_MAX
+             && iov_next (&it, BATCH_MAX - size, &pieces[piece_cnt]))
+        size += pieces[piece_cnt++].size;
+      if (piece_cnt == 0)
+        break;
+
+      bytes = transfer_batch (file, pieces, piece_cnt, size,
+                              ofs < 0 ? ofs : ofs + total, read);
+      if (bytes == TRANSFER_FAULT)
+        return bytes;
+      if (bytes < 0)
+        return total > 0 ? total : -1;
+      total += bytes;
+      if ((size_t) bytes != size)
+        break;
+    }
+  return total;
+}
+
+/* Reads into, if READ is true, or writes from the IOV_CNT user
+   buffers in IOV, for the pipe end in FD.  A read takes only
+   what is in the pipe when it has any data, so it fills at most
+   the first nonempty buffer.  A write writes every buffer
+   unless the pipe has no readers left.  Buffers are pinned a
+   piece of at most BATCH_MAX bytes at a time.  Returns the
+   number of bytes transferred, or -1 if FD is the wrong end of
+   the pipe or a write finds no readers, or TRANSFER_FAULT if a
+   buffer is not valid user memory. */
+static int
+transfer_pipe (struct file_descriptor *fd, const struct iovec *iov,
+               size_t iov_cnt, bool read)
+{
+  struct iov_iter it;
+  struct piece p;
+  int total = 0;
+
+  if (read == fd->pipe_write)
+    return -1;
+
+  it.iov = iov;
+  it.iov_cnt = iov_cnt;
+  it.ofs = 0;
+  while (iov_next (&it, BATCH_MAX, &p))
+    {
+      int bytes;
+
+      if (!uaccess_pin (p.ubuf, p.size, read))
+        return TRANSFER_FAULT;
+      bytes = (read
+               ? pipe_read (fd->pipe, p.ubuf, p.size)
+               : pipe_write (fd->pipe, p.ubuf, p.size));
+      uaccess_unpin (p.ubuf, p.size);
+
+      if (bytes < 0)
+        return total > 0 ? total : -1;
+      total += bytes;
+      if (read || (size_t) bytes != p.size)
+        break;
+    }
+  return total;
+}
+
+/* Returns the poll() events that apply to HANDLE in the current
+   process, which refers to FD, or to no descriptor if FD is
+   null.  If W is nonnull, first registers it, using entry E, to
+   be woken when the object HANDLE refers to changes state.
+   Files are always ready and have nothing to wait for. */
+static unsigned
+poll_fd (int handle, struct file_descriptor *fd, struct waiter *w,
+         struct waitq_entry *e)
 {
-  printf ("system call!\n");
-  thread_exit ();
+  if (fd == NULL)
+    {
+      if (handle == STDIN_FILENO)
+        return input_poll (w, e);
+      else if (handle == STDOUT_FILENO)
+        return POLLOUT;
+      else
+        return POLLNVAL;
+    }
+  else if (fd->pipe != NULL)
+    return pipe_poll (fd->pipe, fd->pipe_write, w, e);
+  else
+    return POLLIN | POLLOUT;
 }
@@ -1,6 +1,17 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+#include <stdbool.h>
+
+struct file;
+struct thread;
+
 void syscall_init (void);
+void syscall_exit (void);
+void syscall_print_stats (void);
+int syscall_invoke (unsigned nr, const int args[]);
+struct file *syscall_reopen_file (int handle);
+bool syscall_is_open (int handle);
+bool syscall_inherit (struct thread *parent);
 
 #endif /* userprog/syscall.h */
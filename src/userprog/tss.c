@@ -1,7 +1,9 @@
 #include "userprog/tss.h"
+#include <cpuid.h>
 #include <debug.h>
 #include <stddef.h>
 #include "userprog/gdt.h"
+#include "threads/msr.h"
 #include "threads/thread.h"
 #include "threads/palloc.h"
 #include "threads/vaddr.h"
@@ -104,3 +106,29 @@ tss_update (void)
   ASSERT (tss != NULL);
   tss->esp0 = (uint8_t *) thread_current () + PGSIZE;
 }
+
+/* Sets up the SYSENTER instruction, if the CPU has it, to enter
+   the kernel at ENTRY, and returns true.  Returns false if the
+   CPU lacks SYSENTER.
+
+   SYSENTER takes the kernel stack pointer from an MSR, not from
+   the TSS, and rewriting the MSR on every thread switch would be
+   slow.  Instead, the MSR points to the TSS's esp0 member, from
+   which ENTRY loads the real stack pointer.  See [IA32-v3a]
+   4.8.7 "Performing Fast Calls to System Procedures with the
+   SYSENTER and SYSEXIT Instructions". */
+bool
+tss_enable_sysenter (void (*entry) (void))
+{
+  ASSERT (tss != NULL);
+
+  if (!cpuid_has_sysenter ())
+    return false;
+
+  /* SYSENTER and SYSEXIT derive the other three selectors from
+     this one, in the order they appear in the GDT. */
+  wrmsr (MSR_SYSENTER_CS, SEL_KCSEG);
+  wrmsr (MSR_SYSENTER_ESP, (uintptr_t) &tss->esp0);
+  wrmsr (MSR_SYSENTER_EIP, (uintptr_t) entry);
+  return true;
+}
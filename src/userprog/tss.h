@@ -1,11 +1,13 @@
 #ifndef USERPROG_TSS_H
 #define USERPROG_TSS_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 struct tss;
 void tss_init (void);
 struct tss *tss_get (void);
 void tss_update (void);
+bool tss_enable_sysenter (void (*entry) (void));
 
 #endif /* userprog/tss.h */
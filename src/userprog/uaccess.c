@@ -0,0 +1,142 @@
+#include "userprog/uaccess.h"
+#include <debug.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
+
+/* User memory access.
+
+   System calls must never trust a pointer from a user program,
+   but walking the page table to validate every page of a
+   buffer before using it is slow.  Instead, the routines here
+   only check that an address range lies entirely below
+   PHYS_BASE, then access it directly.  If an access faults
+   because the memory is unmapped, page_fault() calls
+   uaccess_fixup(), which makes the access fail instead of
+   panicking the kernel.
+
+   The routines that actually touch user memory are written in
+   assembly, in uaccess-copy.S, so that the range of
+   instructions that may fault is known exactly. */
+
+int uaccess_copy (void *dst, const void *src, size_t size);
+int uaccess_strncpy (char *dst, const char *src, size_t size);
+extern char uaccess_start[], uaccess_end[], uaccess_fault[];
+
+/* Returns true if the SIZE bytes starting at UADDR all lie in
+   user virtual memory. */
+static inline bool
+is_user_range (const void *uaddr, size_t size)
+{
+  uintptr_t start = (uintptr_t) uaddr;
+  return start + size >= start && start + size <= (uintptr_t) PHYS_BASE;
+}
+
+/* Copies SIZE bytes from user address USRC to kernel address
+   DST.  Returns true if successful, false if any part of USRC
+   is not mapped user memory. */
+bool
+copy_from_user (void *dst, const void *usrc, size_t size)
+{
+  return is_user_range (usrc, size) && uaccess_copy (dst, usrc, size) == 0;
+}
+
+/* Copies SIZE bytes from kernel address SRC to user address
+   UDST.  Returns true if successful, false if any part of UDST
+   is not mapped, writable user memory. */
+bool
+copy_to_user (void *udst, const void *src, size_t size)
+{
+  return is_user_range (udst, size) && uaccess_copy (udst, src, size) == 0;
+}
+
+/* Copies the null-terminated string at user address USRC into
+   DST, which has room for SIZE bytes.  Returns the length of the
+   string, not counting the null terminator.  If the string does
+   not fit, returns SIZE, and DST is not null-terminated.
+   Returns -1 if the string is not in mapped user memory. */
+int
+strncpy_from_user (char *dst, const char *usrc, size_t size)
+{
+  size_t max_size;
+  int length;
+
+  if (!is_user_vaddr (usrc))
+    return -1;
+
+  /* Don't read past the top of user memory: a string that runs
+     into PHYS_BASE without a null terminator is invalid. */
+  max_size = (uint8_t *) PHYS_BASE - (uint8_t *) usrc;
+  if (size <= max_size)
+    return uaccess_strncpy (dst, usrc, size);
+
+  length = uaccess_strncpy (dst, usrc, max_size);
+  return length == (int) max_size ? -1 : length;
+}
+
+/* Pins the SIZE bytes of user memory at UBUF in the current
+   process, so that other threads can reach them through the
+   kernel's mapping of their frames, which pagedir_get_page()
+   returns, until uaccess_unpin() is called.  If WRITE is true,
+   the memory must be writable, and it is marked dirty, since
+   writes through the kernel's mapping do not set the dirty bit
+   in the user's page table.  Returns false if the memory is not
+   valid user memory. */
+bool
+uaccess_pin (void *ubuf_, size_t size, bool write)
+{
+  uint8_t *ubuf = ubuf_;
+  uint32_t *pd = thread_current ()->pagedir;
+  uint8_t *upage;
+
+#ifdef VM
+  if (!page_pin (ubuf, size, write))
+    return false;
+#else
+  /* Without virtual memory, user pages never move. */
+  if (!is_user_range (ubuf, size))
+    return false;
+  for (upage = pg_round_down (ubuf); upage < ubuf + size; upage += PGSIZE)
+    if (write
+        ? !pagedir_is_writable (pd, upage)
+        : pagedir_get_page (pd, upage) == NULL)
+      return false;
+#endif
+
+  if (write)
+    for (upage = pg_round_down (ubuf); upage < ubuf + size; upage += PGSIZE)
+      pagedir_set_dirty (pd, upage, true);
+  return true;
+}
+
+/* Unpins the SIZE bytes of user memory at UBUF, which must have
+   been pinned by uaccess_pin(). */
+void
+uaccess_unpin (void *ubuf UNUSED, size_t size UNUSED)
+{
+#ifdef VM
+  page_unpin (ubuf, size);
+#endif
+}
+
+/* Called by page_fault() when the kernel faults on user address
+   FAULT_ADDR.  If the fault happened inside one of the routines
+   above, redirects F to return failure from that routine and
+   returns true.  Otherwise the fault is a kernel bug and this
+   function returns false. */
+bool
+uaccess_fixup (struct intr_frame *f, const void *fault_addr)
+{
+  if (is_user_vaddr (fault_addr)
+      && (char *) f->eip >= uaccess_start && (char *) f->eip < uaccess_end)
+    {
+      f->eip = (void (*) (void)) uaccess_fault;
+      return true;
+    }
+  return false;
+}
@@ -0,0 +1,113 @@
+#include "userprog/vdata.h"
+#include <debug.h>
+#include <tsc.h>
+#include <vdata.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "userprog/pagedir.h"
+
+/* Kernel data page.
+
+   One page of read-mostly kernel data, described by struct
+   vdata in lib/vdata.h, is mapped read-only at VDATA_ADDR in
+   every process, so that user programs can read the time and
+   their own process ID without the cost of a system call.
+
+   The timer interrupt updates the time on every tick.  There is
+   only one page for all processes, so the process ID in it is
+   that of the running process, rewritten on every switch to a
+   process.  A process can only read the page while it runs, so
+   it always sees its own ID. */
+
+static struct vdata *vdata;
+
+static enum intr_level begin_update (void);
+static void end_update (enum intr_level);
+
+/* Allocates and initializes the kernel data page.  Must be
+   called after timer_calibrate(). */
+void
+vdata_init (void)
+{
+  struct vdata *vd = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+  enum intr_level old_level;
+
+  vd->timer_freq = TIMER_FREQ;
+  vd->tsc_freq = timer_tsc_freq ();
+
+  old_level = intr_disable ();
+  vdata = vd;
+  vdata_tick (timer_ticks ());
+  intr_set_level (old_level);
+}
+
+/* Records that timer tick number TICKS just happened. */
+void
+vdata_tick (int64_t ticks)
+{
+  enum intr_level old_level;
+
+  if (vdata == NULL)
+    return;
+
+  old_level = begin_update ();
+  vdata->ticks = ticks;
+  if (vdata->tsc_freq != 0)
+    vdata->tick_tsc = rdtsc ();
+  end_update (old_level);
+}
+
+/* Records that the process with the given PID is running. */
+void
+vdata_set_pid (int pid)
+{
+  enum intr_level old_level;
+
+  if (vdata == NULL)
+    return;
+
+  old_level = begin_update ();
+  vdata->pid = pid;
+  end_update (old_level);
+}
+
+/* Maps the kernel data page read-only at VDATA_ADDR in page
+   directory PD.  Returns true if successful, false if memory
+   for a page table could not be allocated. */
+bool
+vdata_map (uint32_t *pd)
+{
+  ASSERT (vdata != NULL);
+  return pagedir_set_page (pd, (void *) VDATA_ADDR, vdata, false);
+}
+
+/* Unmaps the kernel data page from PD, if it is mapped, so that
+   destroying PD does not free it. */
+void
+vdata_unmap (uint32_t *pd)
+{
+  pagedir_clear_page (pd, (void *) VDATA_ADDR);
+}
+
+/* Disables interrupts and marks the page as being updated.
+   Returns the previous interrupt level. */
+static enum intr_level
+begin_update (void)
+{
+  enum intr_level old_level = intr_disable ();
+  vdata->seq++;
+  barrier ();
+  return old_level;
+}
+
+/* Marks the page as consistent again and restores interrupt
+   level OLD_LEVEL. */
+static void
+end_update (enum intr_level old_level)
+{
+  barrier ();
+  vdata->seq++;
+  intr_set_level (old_level);
+}
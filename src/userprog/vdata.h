@@ -0,0 +1,13 @@
+#ifndef USERPROG_VDATA_H
+#define USERPROG_VDATA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+void vdata_init (void);
+void vdata_tick (int64_t ticks);
+void vdata_set_pid (int pid);
+bool vdata_map (uint32_t *pd);
+void vdata_unmap (uint32_t *pd);
+
+#endif /* userprog/vdata.h */
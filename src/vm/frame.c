@@ -0,0 +1,336 @@
+#include "vm/frame.h"
+#include <debug.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "userprog/pagedir.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/process.h"
+#include "vm/oom.h"
+#include "vm/page.h"
+#include "vm/share.h"
+
+/* Timer ticks between two samples of the accessed bits. */
+#define AGING_INTERVAL (TIMER_FREQ / 4)
+
+/* Value or'd into a page's age when it was referenced during
+   the last sampling interval. */
+#define AGE_REFERENCED 0x80
+
+/* Frame table: every frame that holds a private user page. */
+static struct list frame_table;
+static struct lock frame_lock;
+
+/* Next frame the clock algorithm considers for eviction, or
+   list_end (&frame_table) to start over from the beginning. */
+static struct list_elem *clock_hand;
+
+static thread_func aging_thread NO_RETURN;
+static void frame_age (void);
+static struct frame *frame_evict (bool *busy);
+static struct frame *clock_next (void);
+static void frame_sample (struct frame *);
+static void reset_wss (struct thread *, void *aux);
+
+/* Initializes the frame table and starts the thread that
+   samples accessed bits to estimate working sets. */
+void
+frame_init (void)
+{
+  list_init (&frame_table);
+  lock_init (&frame_lock);
+  clock_hand = list_end (&frame_table);
+  thread_create ("aging", PRI_DEFAULT, aging_thread, NULL);
+}
+
+/* Obtains a frame to hold PAGE for the current process and adds
+   it to the frame table, evicting another page if the user pool
+   is exhausted and no cached shared page can be freed instead.
+   If eviction fails only for the moment, because every candidate
+   is pinned or its owner is busy paging, waits a tick and tries
+   again.  If nothing can be evicted at all, because swap is full
+   or there are no user frames to take, has the OOM killer kill a
+   process to make room.  FLAGS are passed along to
+   palloc_get_page(); PAL_USER is implied.  The frame is returned
+   pinned, so that it cannot be evicted before the caller has
+   filled and mapped it and called frame_unpin().  Returns a null
+   pointer if no frame could be obtained. */
+struct frame *
+frame_alloc (struct page *page, enum palloc_flags flags)
+{
+  void *kpage;
+  struct frame *f;
+
+  for (;;)
+    {
+      bool busy;
+
+      kpage = palloc_get_page (PAL_USER | flags);
+      if (kpage == NULL && share_reclaim ())
+        kpage = palloc_get_page (PAL_USER | flags);
+      if (kpage != NULL)
+        break;
+      f = frame_evict (&busy);
+      if (f != NULL)
+        break;
+      if (busy)
+        timer_sleep (1);
+      else if (!oom_kill ())
+        return NULL;
+    }
+
+  if (kpage != NULL)
+    {
+      f = malloc (sizeof *f);
+      if (f == NULL)
+        {
+          palloc_free_page (kpage);
+          return NULL;
+        }
+      f->kpage = kpage;
+    }
+  else if (flags & PAL_ZERO)
+    memset (f->kpage, 0, PGSIZE);
+  f->page = page;
+  f->owner = process_current ();
+  f->pin_cnt = 1;
+  f->referenced = false;
+  f->sampled = false;
+
+  lock_acquire (&frame_lock);
+  list_push_back (&frame_table, &f->elem);
+  lock_release (&frame_lock);
+  return f;
+}
+
+/* Pins frame F, so that it is not evicted until frame_unpin()
+   has been called once for each call to frame_pin().  The
+   caller must hold the page_lock of F's owner, so that F cannot
+   be in the middle of being evicted. */
+void
+frame_pin (struct frame *f)
+{
+  lock_acquire (&frame_lock);
+  f->pin_cnt++;
+  lock_release (&frame_lock);
+}
+
+/* Drops one pin on frame F.  F becomes eligible for eviction
+   again when no pins remain. */
+void
+frame_unpin (struct frame *f)
+{
+  lock_acquire (&frame_lock);
+  ASSERT (f->pin_cnt > 0);
+  f->pin_cnt--;
+  lock_release (&frame_lock);
+}
+
+/* Makes frame F the next candidate for eviction, unless it is
+   used again before the clock hand reaches it. */
+void
+frame_deactivate (struct frame *f)
+{
+  lock_acquire (&frame_lock);
+  frame_sample (f);
+  f->referenced = false;
+  if (clock_hand != &f->elem)
+    {
+      list_remove (&f->elem);
+      list_insert (clock_hand, &f->elem);
+      clock_hand = &f->elem;
+    }
+  lock_release (&frame_lock);
+}
+
+/* Removes frame F from the frame table and frees it.  The page
+   it held must already be unmapped. */
+void
+frame_free (struct frame *f)
+{
+  lock_acquire (&frame_lock);
+  if (clock_hand == &f->elem)
+    clock_hand = list_next (clock_hand);
+  list_remove (&f->elem);
+  lock_release (&frame_lock);
+
+  palloc_free_page (f->kpage);
+  free (f);
+}
+
+/* Evicts a page and returns its frame to the user pool, for
+   memory that is not managed through the frame table.  Returns
+   false if no page could be evicted. */
+bool
+frame_reclaim (void)
+{
+  bool busy;
+  struct frame *f = frame_evict (&busy);
+  if (f == NULL)
+    return false;
+  palloc_free_page (f->kpage);
+  free (f);
+  return true;
+}
+
+/* Chooses a frame with the clock algorithm, evicts the page in
+   it, and returns the frame, removed from the frame table.  Gives
+   up and returns a null pointer if every frame is pinned or in
+   use by a process that is busy paging, setting *BUSY to true
+   because that may soon change, or if swap is full or the frame
+   table is empty, setting *BUSY to false.
+
+   A frame's owner may be faulting in, or tearing down, its own
+   pages at the same time, so the page is evicted while holding
+   its owner's page_lock.  That lock is only tried, never waited
+   for: the current thread may be holding its own page_lock, and
+   another thread evicting one of our pages may hold it too. */
+static struct frame *
+frame_evict (bool *busy)
+{
+  struct thread *cur = process_current ();
+  struct frame *victim = NULL;
+  struct lock *owner_lock = NULL;
+  size_t scan_cnt;
+
+  *busy = false;
+  lock_acquire (&frame_lock);
+  for (scan_cnt = 2 * list_size (&frame_table); scan_cnt > 0; scan_cnt--)
+    {
+      struct frame *f = clock_next ();
+
+      if (f->pin_cnt > 0)
+        {
+          *busy = true;
+          continue;
+        }
+      frame_sample (f);
+      if (f->referenced)
+        {
+          /* Referenced since the hand last passed: second chance. */
+          f->referenced = false;
+          continue;
+        }
+      if (f->owner != cur)
+        {
+          if (!lock_try_acquire (&f->owner->page_lock))
+            {
+              *busy = true;
+              continue;
+            }
+          owner_lock = &f->owner->page_lock;
+        }
+      victim = f;
+      break;
+    }
+  if (victim != NULL)
+    {
+      clock_hand = list_remove (&victim->elem);
+      victim->pin_cnt = 1;
+    }
+  lock_release (&frame_lock);
+
+  if (victim == NULL)
+    return NULL;
+
+  if (!page_evict (victim->page, victim->owner))
+    {
+      /* Swap is full. */
+      *busy = false;
+      lock_acquire (&frame_lock);
+      list_push_back (&frame_table, &victim->elem);
+      victim->pin_cnt = 0;
+      lock_release (&frame_lock);
+      victim = NULL;
+    }
+  if (owner_lock != NULL)
+    lock_release (owner_lock);
+  return victim;
+}
+
+/* Advances the clock hand and returns the frame it passed over.
+   The frame table must not be empty.  Caller must hold
+   frame_lock. */
+static struct frame *
+clock_next (void)
+{
+  struct frame *f;
+
+  if (clock_hand == list_end (&frame_table))
+    clock_hand = list_begin (&frame_table);
+  f = list_entry (clock_hand, struct frame, elem);
+  clock_hand = list_next (clock_hand);
+  return f;
+}
+
+/* Moves the hardware accessed bit of frame F's page, if set,
+   into both of F's software bits and clears it.  The clock and
+   the aging thread each consume and clear only their own bit, so
+   neither hides a reference from the other.  Caller must hold
+   frame_lock. */
+static void
+frame_sample (struct frame *f)
+{
+  uint32_t *pd = f->owner->pagedir;
+
+  if (pagedir_is_accessed (pd, f->page->upage))
+    {
+      pagedir_set_accessed (pd, f->page->upage, false);
+      f->referenced = true;
+      f->sampled = true;
+    }
+}
+
+/* Samples the accessed bits every AGING_INTERVAL ticks. */
+static void
+aging_thread (void *aux UNUSED)
+{
+  for (;;)
+    {
+      timer_sleep (AGING_INTERVAL);
+      frame_age ();
+    }
+}
+
+/* Ages every page in the frame table: shifts its age right by
+   one and sets the top bit if the page was accessed since the
+   last pass.  A page whose age is nonzero was used in one of the
+   last 8 intervals, so the count of such pages is the process's
+   working set estimate.  Every process's estimate is recounted
+   from zero, including those with no frames left.  Shared text
+   pages are not in the frame table and are not counted. */
+static void
+frame_age (void)
+{
+  enum intr_level old_level;
+  struct list_elem *e;
+
+  lock_acquire (&frame_lock);
+  old_level = intr_disable ();
+  thread_foreach (reset_wss, NULL);
+  intr_set_level (old_level);
+
+  for (e = list_begin (&frame_table); e != list_end (&frame_table);
+       e = list_next (e))
+    {
+      struct frame *f = list_entry (e, struct frame, elem);
+      struct page *p = f->page;
+
+      frame_sample (f);
+      p->age = (p->age >> 1) | (f->sampled ? AGE_REFERENCED : 0);
+      f->sampled = false;
+      if (p->age != 0)
+        f->owner->vmstat.wss++;
+    }
+  lock_release (&frame_lock);
+}
+
+/* Used by frame_age() to zero thread T's working set estimate. */
+static void
+reset_wss (struct thread *t, void *aux UNUSED)
+{
+  t->vmstat.wss = 0;
+}
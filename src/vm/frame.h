@@ -0,0 +1,30 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <list.h>
+#include <stdbool.h>
+#include "threads/palloc.h"
+
+struct page;
+
+/* A frame of physical memory holding one private user page. */
+struct frame
+  {
+    struct list_elem elem;      /* Element in the frame table. */
+    void *kpage;                /* Kernel virtual address. */
+    struct page *page;          /* Page held in this frame. */
+    struct thread *owner;       /* Process that owns PAGE. */
+    unsigned pin_cnt;           /* Exempt from eviction if nonzero. */
+    bool referenced;            /* Used since the clock hand passed? */
+    bool sampled;               /* Used since the last aging pass? */
+  };
+
+void frame_init (void);
+struct frame *frame_alloc (struct page *, enum palloc_flags);
+void frame_pin (struct frame *);
+void frame_unpin (struct frame *);
+void frame_deactivate (struct frame *);
+void frame_free (struct frame *);
+bool frame_reclaim (void);
+
+#endif /* vm/frame.h */
@@ -0,0 +1,218 @@
+#include "vm/lz.h"
+#include <debug.h>
+#include <string.h>
+
+/* A small LZ77 compressor for pages of memory.
+
+   Compressed data is a series of sequences.  Each sequence
+   starts with a token byte.  The token's high 4 bits give the
+   number of literal bytes that follow, and its low 4 bits give
+   the length of the match that follows them, minus MIN_MATCH.
+   A 4-bit field of 15 means the length continues in the bytes
+   after the token (for the literal length) or after the offset
+   (for the match length): each such byte is added to the
+   length, and a byte of 255 means another byte follows.
+
+   After the literals comes a 2-byte little-endian offset back
+   into the output, where the match is copied from, and then any
+   extra match-length bytes.  The last sequence ends after its
+   literals, with no offset and no match.
+
+   This is the same layout as LZ4's block format, which makes
+   decompression a tight loop of memory copies.  Compression
+   finds matches through a single hash table of recent 4-byte
+   strings, so it is fast but not thorough: it is meant to keep
+   pages in RAM cheaply, not to squeeze out every byte. */
+
+/* Shortest match worth encoding. */
+#define MIN_MATCH 4
+
+/* Largest offset that fits in an encoded match. */
+#define MAX_OFFSET 0xffff
+
+/* Token field value meaning "length continues". */
+#define RUN_MASK 15
+
+static inline uint32_t
+read32 (const uint8_t *p)
+{
+  uint32_t x;
+  memcpy (&x, p, sizeof x);
+  return x;
+}
+
+static inline unsigned
+hash32 (uint32_t x)
+{
+  return (x * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/* Returns the number of extra bytes needed to encode a length
+   of LENGTH in a 4-bit token field. */
+static inline size_t
+extra_length_bytes (size_t length)
+{
+  return length < RUN_MASK ? 0 : (length - RUN_MASK) / 255 + 1;
+}
+
+/* Writes the extra bytes that encode LENGTH, which is at least
+   RUN_MASK, at OP.  Returns the new output position. */
+static uint8_t *
+write_length (uint8_t *op, size_t length)
+{
+  for (length -= RUN_MASK; length >= 255; length -= 255)
+    *op++ = 255;
+  *op++ = length;
+  return op;
+}
+
+/* Appends a sequence of LIT_LEN literal bytes from LIT, followed
+   by a match of MATCH_LEN bytes at OFFSET if MATCH_LEN is
+   nonzero, to the output at *OP, which ends at OEND.  Returns
+   false if the output would overflow. */
+static bool
+emit_sequence (uint8_t **op, uint8_t *oend, const uint8_t *lit,
+               size_t lit_len, size_t offset, size_t match_len)
+{
+  size_t code = match_len > 0 ? match_len - MIN_MATCH : 0;
+  size_t need = 1 + extra_length_bytes (lit_len) + lit_len;
+  uint8_t *p = *op;
+
+  if (match_len > 0)
+    need += 2 + extra_length_bytes (code);
+  if (need > (size_t) (oend - p))
+    return false;
+
+  *p++ = ((lit_len < RUN_MASK ? lit_len : RUN_MASK) << 4
+          | (code < RUN_MASK ? code : RUN_MASK));
+  if (lit_len >= RUN_MASK)
+    p = write_length (p, lit_len);
+  memcpy (p, lit, lit_len);
+  p += lit_len;
+
+  if (match_len > 0)
+    {
+      *p++ = offset & 0xff;
+      *p++ = offset >> 8;
+      if (code >= RUN_MASK)
+        p = write_length (p, code);
+    }
+  *op = p;
+  return true;
+}
+
+/* Compresses the SRC_SIZE bytes at SRC into the DST_SIZE bytes
+   at DST, using DICT as working memory.  Returns the compressed
+   size, or 0 if the result would not fit in DST_SIZE bytes. */
+size_t
+lz_compress (const void *src_, size_t src_size,
+             void *dst_, size_t dst_size, struct lz_dict *dict)
+{
+  const uint8_t *src = src_;
+  uint8_t *op = dst_;
+  uint8_t *oend = op + dst_size;
+  size_t anchor = 0;
+  size_t ip = 0;
+
+  ASSERT (src_size <= MAX_OFFSET);
+
+  memset (dict->table, 0, sizeof dict->table);
+  while (ip + MIN_MATCH <= src_size)
+    {
+      uint32_t seq = read32 (src + ip);
+      unsigned h = hash32 (seq);
+      size_t ref = dict->table[h];
+
+      dict->table[h] = ip + 1;
+      if (ref != 0 && read32 (src + ref - 1) == seq)
+        {
+          size_t start = ref - 1;
+          size_t length = MIN_MATCH;
+
+          while (ip + length < src_size
+                 && src[start + length] == src[ip + length])
+            length++;
+          if (!emit_sequence (&op, oend, src + anchor, ip - anchor,
+                              ip - start, length))
+            return 0;
+          ip += length;
+          anchor = ip;
+        }
+      else
+        ip++;
+    }
+
+  if (!emit_sequence (&op, oend, src + anchor, src_size - anchor, 0, 0))
+    return 0;
+  return op - (uint8_t *) dst_;
+}
+
+/* Reads a length continued in extra bytes at *IP, which ends at
+   IEND, and adds it to *LENGTH.  Returns false if the input is
+   truncated. */
+static bool
+read_length (const uint8_t **ip, const uint8_t *iend, size_t *length)
+{
+  uint8_t b;
+
+  do
+    {
+      if (*ip >= iend)
+        return false;
+      b = *(*ip)++;
+      *length += b;
+    }
+  while (b == 255);
+  return true;
+}
+
+/* Decompresses the SRC_SIZE bytes at SRC, which must have been
+   produced by lz_compress(), into DST.  Returns true if the
+   data decompressed to exactly DST_SIZE bytes, false if it is
+   corrupt. */
+bool
+lz_decompress (const void *src_, size_t src_size,
+               void *dst_, size_t dst_size)
+{
+  const uint8_t *ip = src_;
+  const uint8_t *iend = ip + src_size;
+  uint8_t *dst = dst_;
+  uint8_t *op = dst;
+  uint8_t *oend = dst + dst_size;
+
+  while (ip < iend)
+    {
+      uint8_t token = *ip++;
+      size_t lit_len = token >> 4;
+      size_t match_len = (token & RUN_MASK) + MIN_MATCH;
+      size_t offset;
+      const uint8_t *match;
+
+      /* Literals. */
+      if (lit_len == RUN_MASK && !read_length (&ip, iend, &lit_len))
+        return false;
+      if (lit_len > (size_t) (iend - ip) || lit_len > (size_t) (oend - op))
+        return false;
+      memcpy (op, ip, lit_len);
+      ip += lit_len;
+      op += lit_len;
+      if (ip == iend)
+        break;
+
+      /* Match.  The source may overlap the destination, so copy
+         a byte at a time. */
+      if (iend - ip < 2)
+        return false;
+      offset = ip[0] | (ip[1] << 8);
+      ip += 2;
+      if ((token & RUN_MASK) == RUN_MASK
+          && !read_length (&ip, iend, &match_len))
+        return false;
+      if (offset == 0 || offset > (size_t) (op - dst)
+          || match_len > (size_t) (oend - op))
+        return false;
+      for (match = op - offset; match_len > 0; match_len--)
+        *op++ = *match++;
+    }
+  return op == oend;
+}
@@ -0,0 +1,24 @@
+#ifndef VM_LZ_H
+#define VM_LZ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Number of entries in the compressor's match-finding table. */
+#define LZ_HASH_BITS 10
+#define LZ_HASH_SIZE (1 << LZ_HASH_BITS)
+
+/* Working memory for lz_compress().  Too big for a kernel stack,
+   so callers supply it. */
+struct lz_dict
+  {
+    uint16_t table[LZ_HASH_SIZE];   /* Hash of 4 bytes -> position + 1. */
+  };
+
+size_t lz_compress (const void *src, size_t src_size,
+                    void *dst, size_t dst_size, struct lz_dict *);
+bool lz_decompress (const void *src, size_t src_size,
+                    void *dst, size_t dst_size);
+
+#endif /* vm/lz.h */
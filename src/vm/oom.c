@@ -0,0 +1,181 @@
+#include "vm/oom.h"
+#include <debug.h>
+#include <oom.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "filesys/filesys.h"
+#include "threads/interrupt.h"
+#include "threads/loader.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "userprog/process.h"
+
+/* Out-of-memory killer.
+
+   When there is no free frame and no page can be evicted,
+   because swap is full, the process with the highest OOM score
+   is killed to free its memory.  A process's score is the
+   number of private pages it has in memory and in swap, plus its
+   OOM score adjustment in thousandths of all of RAM, so that an
+   adjustment of OOM_ADJ_MAX makes it the first victim and one of
+   OOM_ADJ_MIN exempts it.  Shared text pages do not count, since
+   killing one of the processes that map them frees none.
+
+   A victim is marked as killed and exits the next time it would
+   return to user mode.  Meanwhile, processes that need memory
+   wait for it, for up to OOM_WAIT_TICKS; if it has still not
+   exited by then, perhaps because it is blocked in the kernel,
+   another victim is chosen. */
+
+/* Ticks to wait for a victim to exit before killing another. */
+#define OOM_WAIT_TICKS (TIMER_FREQ / 2)
+
+static struct lock oom_lock;
+static tid_t victim_tid = TID_ERROR;  /* Most recent victim. */
+static int64_t kill_time;             /* When it was killed. */
+
+static long oom_score (const struct thread *);
+static struct thread *select_victim (void);
+static bool victim_alive (void);
+
+/* Initializes the OOM killer. */
+void
+oom_init (void)
+{
+  lock_init (&oom_lock);
+}
+
+/* Called when the current process needs a frame and none can be
+   freed.  Kills the process with the highest OOM score, unless a
+   victim chosen earlier is still exiting.  Returns true if the
+   caller should try again, after having waited a little for the
+   victim's memory.  Returns false if the caller is the victim or
+   no process can be killed, in which case the allocation
+   fails.
+
+   Also returns false at once if the caller holds filesys_lock,
+   since a victim may need that lock to close its files and
+   exit, and would otherwise be given up on while we wait. */
+bool
+oom_kill (void)
+{
+  bool retry;
+
+  if (lock_held_by_current_thread (&filesys_lock))
+    return false;
+
+  lock_acquire (&oom_lock);
+  if (!victim_alive () || timer_elapsed (kill_time) > OOM_WAIT_TICKS)
+    {
+      struct thread *t = select_victim ();
+      if (t == NULL)
+        {
+          lock_release (&oom_lock);
+          return false;
+        }
+
+      printf ("Out of memory: killed %s (tid %d), score %ld: "
+              "%u pages resident, %u in swap, adjustment %d\n",
+              t->name, t->tid, oom_score (t), t->vmstat.rss,
+              t->vmstat.swapped, t->oom_adj);
+      process_kill (t);
+      victim_tid = t->tid;
+      kill_time = timer_ticks ();
+    }
+  retry = victim_tid != process_current ()->tid;
+  lock_release (&oom_lock);
+
+  if (retry)
+    timer_sleep (1);
+  return retry;
+}
+
+/* Sets the current process's OOM score adjustment to ADJ,
+   clamped to the range OOM_ADJ_MIN...OOM_ADJ_MAX, and returns
+   the previous adjustment. */
+int
+oom_set_adj (int adj)
+{
+  struct thread *t = process_current ();
+  int old_adj = t->oom_adj;
+
+  t->oom_adj = (adj < OOM_ADJ_MIN ? OOM_ADJ_MIN
+                : adj > OOM_ADJ_MAX ? OOM_ADJ_MAX
+                : adj);
+  return old_adj;
+}
+
+/* Returns the OOM score of process T. */
+static long
+oom_score (const struct thread *t)
+{
+  long pages = ((long) t->vmstat.rss - t->shared_rss
+                + t->vmstat.swapped);
+  return pages + (long) t->oom_adj * init_ram_pages / OOM_ADJ_MAX;
+}
+
+/* Used by select_victim() to find the process with the highest
+   OOM score. */
+struct victim_search
+  {
+    struct thread *victim;      /* Best candidate so far, or null. */
+    long score;                 /* Its score. */
+  };
+
+/* Considers thread T as a victim for the search in AUX. */
+static void
+consider_victim (struct thread *t, void *aux)
+{
+  struct victim_search *s = aux;
+  long score;
+
+  if (t->pages == NULL || t->killed || t->oom_adj == OOM_ADJ_MIN)
+    return;
+  score = oom_score (t);
+  if (s->victim == NULL || score > s->score)
+    {
+      s->victim = t;
+      s->score = score;
+    }
+}
+
+/* Returns the process with the highest OOM score that has not
+   been killed already, or a null pointer if there is none. */
+static struct thread *
+select_victim (void)
+{
+  struct victim_search s;
+  enum intr_level old_level;
+
+  s.victim = NULL;
+  s.score = 0;
+  old_level = intr_disable ();
+  thread_foreach (consider_victim, &s);
+  intr_set_level (old_level);
+  return s.victim;
+}
+
+/* Used by victim_alive() to look for the most recent victim. */
+static void
+find_victim (struct thread *t, void *aux)
+{
+  bool *alive = aux;
+  if (t->tid == victim_tid && t->pages != NULL)
+    *alive = true;
+}
+
+/* Returns true if the most recent victim has yet to release its
+   memory. */
+static bool
+victim_alive (void)
+{
+  enum intr_level old_level;
+  bool alive = false;
+
+  if (victim_tid == TID_ERROR)
+    return false;
+  old_level = intr_disable ();
+  thread_foreach (find_victim, &alive);
+  intr_set_level (old_level);
+  return alive;
+}
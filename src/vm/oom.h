@@ -0,0 +1,10 @@
+#ifndef VM_OOM_H
+#define VM_OOM_H
+
+#include <stdbool.h>
+
+void oom_init (void);
+bool oom_kill (void);
+int oom_set_adj (int adj);
+
+#endif /* vm/oom.h */
@@ -0,0 +1,996 @@
+#include "vm/page.h"
+#include <debug.h>
+#include <madvise.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include <vdata.h>
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/interrupt.h"
+#include "threads/vaddr.h"
+#include "filesys/file.h"
+#include "vm/frame.h"
+#include "vm/readahead.h"
+#include "vm/share.h"
+#include "vm/swap.h"
+
+/* The PUSHA instruction pushes 32 bytes, so it faults at most
+   this far below the stack pointer. */
+#define STACK_SLOP 32
+
+/* On a fault in a range advised MADV_SEQUENTIAL, the number of
+   following pages to bring back from swap, and the distance
+   behind the fault at which pages are marked for early
+   eviction. */
+#define READAHEAD_PAGES 8
+#define DROP_BEHIND_PAGES 16
+
+/* A fault on a read-only file page also maps the pages around
+   it that are already in memory, within an aligned block of
+   this many pages. */
+#define FAULT_AROUND_PAGES 16
+
+/* Bounds on a file mapping's readahead window, in pages. */
+#define RA_MIN_PAGES 4
+#define RA_MAX_PAGES 16
+
+size_t stack_page_limit = STACK_PAGES_DEFAULT;
+bool page_print_exit_stats;
+
+/* A frame of zeros, mapped read-only into every zero-fill page
+   that has been read but not yet written. */
+static void *zero_kpage;
+
+static bool is_stack_access (const void *addr, const void *esp);
+static hash_hash_func page_hash;
+static hash_less_func page_less;
+static hash_action_func page_destroy;
+static bool do_page_in (const void *fault_addr, bool write,
+                        const void *esp);
+static bool page_map_zero (struct page *);
+static bool page_read_file (struct page *);
+static off_t page_file_ofs (const struct page *);
+static uint32_t page_read_bytes (const struct page *);
+static void file_fault (struct page *);
+static void fault_around (struct page *);
+static void read_ahead (struct mapping *, uint8_t *start, size_t page_cnt);
+static bool page_swap_in (struct page *, bool fault);
+static void page_discard (struct page *);
+static void advise_page (struct page *, int advice);
+static void sequential_fault (struct page *);
+static bool page_install_frame (struct page *, struct frame *);
+static void rss_add (struct thread *);
+
+/* Initializes the supplemental page table module. */
+void
+page_init (void)
+{
+  zero_kpage = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+}
+
+/* Creates and returns an empty supplemental page table, or a
+   null pointer if memory allocation fails. */
+struct hash *
+page_table_create (void)
+{
+  struct hash *pages = malloc (sizeof *pages);
+  if (pages != NULL && !hash_init (pages, page_hash, page_less, NULL))
+    {
+      free (pages);
+      pages = NULL;
+    }
+  return pages;
+}
+
+/* Destroys supplemental page table PAGES, which must belong to
+   the current process, releasing every page in it and then the
+   process's file mappings.  The pages are also unmapped from
+   the process's page directory, so that pagedir_destroy() does
+   not free them a second time. */
+void
+page_table_destroy (struct hash *pages)
+{
+  struct thread *t = process_current ();
+
+  if (pages != NULL)
+    {
+      lock_acquire (&t->page_lock);
+      hash_destroy (pages, page_destroy);
+      lock_release (&t->page_lock);
+      free (pages);
+
+      while (!list_empty (&t->mappings))
+        {
+          struct mapping *m = list_entry (list_pop_front (&t->mappings),
+                                          struct mapping, elem);
+          file_close (m->file);
+          free (m);
+        }
+    }
+}
+
+/* Returns the current process's page containing user virtual
+   address UPAGE, or a null pointer if there is none. */
+struct page *
+page_lookup (const void *upage)
+{
+  struct page p;
+  struct hash_elem *e;
+
+  p.upage = pg_round_down (upage);
+  e = hash_find (process_current ()->pages, &p.hash_elem);
+  return e != NULL ? hash_entry (e, struct page, hash_elem) : NULL;
+}
+
+/* Adds a page at user virtual address UPAGE to the current
+   process, without giving it a frame yet: it is zero-filled
+   when first accessed.  Returns the new page, or a null pointer
+   if UPAGE is already in use or memory allocation fails. */
+struct page *
+page_allocate (void *upage, bool writable)
+{
+  struct page *p;
+
+  ASSERT (pg_ofs (upage) == 0);
+
+  p = malloc (sizeof *p);
+  if (p == NULL)
+    return NULL;
+  p->upage = upage;
+  p->writable = writable;
+  p->age = 0;
+  p->zero_mapped = false;
+  p->advice = MADV_NORMAL;
+  p->frame = NULL;
+  p->shared = NULL;
+  p->swap = NULL;
+  p->map = NULL;
+  p->modified = false;
+  if (hash_insert (process_current ()->pages, &p->hash_elem) != NULL)
+    {
+      free (p);
+      return NULL;
+    }
+  return p;
+}
+
+/* Adds the PAGE_CNT pages starting at user virtual address UPAGE
+   to the current process as zero-fill pages, none of which gets
+   a frame until it is first accessed.  Returns true if
+   successful.  Returns false, with no pages added, if any of the
+   pages is already in use or memory allocation fails. */
+bool
+page_allocate_range (void *upage, size_t page_cnt)
+{
+  struct thread *t = process_current ();
+  size_t i;
+
+  ASSERT (pg_ofs (upage) == 0);
+
+  lock_acquire (&t->page_lock);
+  for (i = 0; i < page_cnt; i++)
+    if (page_allocate ((uint8_t *) upage + i * PGSIZE, true) == NULL)
+      {
+        lock_release (&t->page_lock);
+        page_deallocate_range (upage, i);
+        return false;
+      }
+  lock_release (&t->page_lock);
+  return true;
+}
+
+/* Removes the pages in the PAGE_CNT pages starting at user
+   virtual address UPAGE from the current process, releasing
+   their frames and swap slots.  Addresses without a page are
+   skipped.  Returns true if successful.  Returns false, with no
+   pages removed, if any of the pages is pinned. */
+bool
+page_deallocate_range (void *upage, size_t page_cnt)
+{
+  struct thread *t = process_current ();
+  size_t i;
+
+  ASSERT (pg_ofs (upage) == 0);
+
+  lock_acquire (&t->page_lock);
+  for (i = 0; i < page_cnt; i++)
+    {
+      struct page *p = page_lookup ((uint8_t *) upage + i * PGSIZE);
+      if (p != NULL && p->frame != NULL && p->frame->pin_cnt > 0)
+        {
+          lock_release (&t->page_lock);
+          return false;
+        }
+    }
+  for (i = 0; i < page_cnt; i++)
+    {
+      struct page *p = page_lookup ((uint8_t *) upage + i * PGSIZE);
+      if (p != NULL)
+        {
+          hash_delete (t->pages, &p->hash_elem);
+          page_destroy (&p->hash_elem, NULL);
+        }
+    }
+  lock_release (&t->page_lock);
+  return true;
+}
+
+/* Gives page P of the current process a zeroed frame and maps
+   it.  Returns true if successful, false if memory is
+   exhausted. */
+bool
+page_load (struct page *p)
+{
+  struct frame *f;
+
+  ASSERT (page_kpage (p) == NULL);
+
+  f = frame_alloc (p, PAL_ZERO);
+  return f != NULL && page_install_frame (p, f);
+}
+
+/* Maps page P of the current process to frame F, which must be
+   pinned and already hold P's contents, and unpins F.  Returns
+   true if successful; otherwise, frees F and returns false. */
+static bool
+page_install_frame (struct page *p, struct frame *f)
+{
+  struct thread *t = process_current ();
+
+  if (!pagedir_set_page (t->pagedir, p->upage, f->kpage, p->writable))
+    {
+      frame_free (f);
+      return false;
+    }
+  p->frame = f;
+  frame_unpin (f);
+  rss_add (t);
+  return true;
+}
+
+/* Reads page P of the current process back from swap into a new
+   frame and maps it, counting a page fault if FAULT is true.
+   Returns true if successful, false if memory is exhausted. */
+static bool
+page_swap_in (struct page *p, bool fault)
+{
+  struct thread *t = process_current ();
+  struct frame *f;
+  bool from_disk;
+
+  f = frame_alloc (p, 0);
+  if (f == NULL)
+    return false;
+  from_disk = swap_in (p->swap, f->kpage);
+  if (fault && from_disk)
+    t->vmstat.major_faults++;
+  else if (fault)
+    t->vmstat.minor_faults++;
+  p->swap = NULL;
+  t->vmstat.swap_ins++;
+  t->vmstat.swapped--;
+  return page_install_frame (p, f);
+}
+
+/* Evicts page P, which belongs to process OWNER and is resident
+   in a private frame, and unmaps it.  A file page that has not
+   been written since it was read is simply dropped, to be read
+   again when next needed; any other page goes to swap.  A file
+   page keeps its mapping either way, so that page_discard() can
+   later return it to the file's contents.  The
+   caller must hold OWNER's page_lock, unless OWNER is the current
+   process, and must have removed P's frame from the frame table;
+   the frame is left for the caller to reuse.  Returns false if
+   swap is full, in which case P stays resident. */
+bool
+page_evict (struct page *p, struct thread *owner)
+{
+  struct swap_entry *swap;
+  enum intr_level old_level;
+  bool dirty;
+
+  ASSERT (p->frame != NULL);
+
+  /* Unmap the page first, so that the owner cannot change it
+     while it is being written out.  The owner must not run in
+     between checking the dirty bit and unmapping. */
+  old_level = intr_disable ();
+  dirty = pagedir_is_dirty (owner->pagedir, p->upage);
+  pagedir_clear_page (owner->pagedir, p->upage);
+  intr_set_level (old_level);
+
+  if (p->map != NULL && !p->modified && !dirty)
+    {
+      p->frame = NULL;
+      owner->vmstat.rss--;
+      return true;
+    }
+
+  swap = swap_out (p->frame->kpage);
+  if (swap == NULL)
+    {
+      pagedir_set_page (owner->pagedir, p->upage, p->frame->kpage,
+                        p->writable);
+      return false;
+    }
+  p->swap = swap;
+  p->frame = NULL;
+  p->modified = p->map != NULL;
+  owner->vmstat.rss--;
+  owner->vmstat.swap_outs++;
+  owner->vmstat.swapped++;
+  return true;
+}
+
+/* Returns the kernel virtual address of the frame holding page
+   P, or a null pointer if P is not resident. */
+void *
+page_kpage (const struct page *p)
+{
+  if (p->frame != NULL)
+    return p->frame->kpage;
+  else if (p->shared != NULL)
+    return share_get_kpage (p->shared);
+  else
+    return NULL;
+}
+
+/* Maps page P of the current process, which must not be
+   resident, to the shared zero frame, read-only.  Returns true
+   if successful, false if memory is exhausted. */
+static bool
+page_map_zero (struct page *p)
+{
+  ASSERT (page_kpage (p) == NULL && !p->zero_mapped);
+
+  if (!pagedir_set_page (process_current ()->pagedir, p->upage, zero_kpage,
+                         false))
+    return false;
+  p->zero_mapped = true;
+  return true;
+}
+
+/* Handles a page fault at FAULT_ADDR in the current process,
+   whose user stack pointer is ESP, for a write if WRITE is true
+   or a read otherwise.  Loads the page if the process has one
+   there; otherwise, if the access looks like a push onto the
+   stack, grows the stack to cover it.  A zero-fill page that is
+   read is mapped to the shared zero frame until it is first
+   written.  Returns true if the faulting access may be retried,
+   false if it is invalid. */
+bool
+page_in (const void *fault_addr, bool write, const void *esp)
+{
+  struct thread *t = process_current ();
+  bool success;
+
+  if (t->pages == NULL || !is_user_vaddr (fault_addr))
+    return false;
+
+  /* Wait for any eviction of our pages to finish, and keep our
+     pages from being evicted while we work on them. */
+  lock_acquire (&t->page_lock);
+  success = do_page_in (fault_addr, write, esp);
+  lock_release (&t->page_lock);
+  return success;
+}
+
+/* Does the work for page_in().  Caller must hold the current
+   process's page_lock. */
+static bool
+do_page_in (const void *fault_addr, bool write, const void *esp)
+{
+  struct thread *t = process_current ();
+  struct page *p;
+  bool success;
+
+  p = page_lookup (fault_addr);
+  if (p == NULL)
+    {
+      if (!is_stack_access (fault_addr, esp))
+        return false;
+      p = page_allocate (pg_round_down (fault_addr), true);
+      if (p == NULL)
+        return false;
+    }
+  if (write && !p->writable)
+    return false;
+
+  /* Another thread of the process may have brought the page in
+     while we waited for page_lock.  Then the access can simply be
+     retried, unless it is the first write to a page of zeros. */
+  if (p->zero_mapped && write)
+    {
+      /* First write to a page of zeros: give it its own frame. */
+      pagedir_clear_page (t->pagedir, p->upage);
+      p->zero_mapped = false;
+    }
+  else if (p->zero_mapped || page_kpage (p) != NULL)
+    return pagedir_get_page (t->pagedir, p->upage) != NULL;
+
+  if (p->swap != NULL)
+    success = page_swap_in (p, true);
+  else if (p->map != NULL)
+    {
+      success = page_read_file (p);
+      if (success)
+        file_fault (p);
+    }
+  else
+    {
+      success = write ? page_load (p) : page_map_zero (p);
+      if (success)
+        t->vmstat.minor_faults++;
+    }
+
+  if (success && p->advice == MADV_SEQUENTIAL)
+    sequential_fault (p);
+  return success;
+}
+
+/* Reads page P of the current process from its file mapping and
+   maps it.  A read-only page is mapped from a frame shared with
+   other processes; a writable page gets a private copy, taken
+   from the shared frame if the page was read ahead.  Counts a
+   major fault if the file had to be read, a minor fault
+   otherwise.  Returns true if successful, false if memory is
+   exhausted or the file cannot be read. */
+static bool
+page_read_file (struct page *p)
+{
+  struct thread *t = process_current ();
+  struct inode *inode = file_get_inode (p->map->file);
+  off_t ofs = page_file_ofs (p);
+  uint32_t read_bytes = page_read_bytes (p);
+  struct shared_page *sp;
+  bool did_read;
+
+  if (!p->writable)
+    {
+      sp = share_acquire (inode, ofs, read_bytes, &did_read);
+      if (sp == NULL)
+        return false;
+      if (!pagedir_set_page (t->pagedir, p->upage, share_get_kpage (sp),
+                             false))
+        {
+          share_release (sp);
+          return false;
+        }
+      p->shared = sp;
+      rss_add (t);
+      t->shared_rss++;
+    }
+  else
+    {
+      /* Fill the frame before mapping it: until then it is
+         pinned, so it cannot be evicted half-loaded. */
+      struct frame *f = frame_alloc (p, 0);
+      if (f == NULL)
+        return false;
+      sp = share_lookup (inode, ofs, read_bytes);
+      did_read = sp == NULL;
+      if (sp != NULL)
+        {
+          memcpy (f->kpage, share_get_kpage (sp), PGSIZE);
+          share_release (sp);
+        }
+      else if (file_read_at (p->map->file, f->kpage, read_bytes, ofs)
+               == (off_t) read_bytes)
+        memset ((uint8_t *) f->kpage + read_bytes, 0, PGSIZE - read_bytes);
+      else
+        {
+          frame_free (f);
+          return false;
+        }
+      if (!page_install_frame (p, f))
+        return false;
+    }
+
+  if (did_read)
+    t->vmstat.major_faults++;
+  else
+    t->vmstat.minor_faults++;
+  return true;
+}
+
+/* Returns the offset of page P in its mapping's file. */
+static off_t
+page_file_ofs (const struct page *p)
+{
+  return p->map->ofs + ((uint8_t *) p->upage - p->map->upage);
+}
+
+/* Returns the number of bytes of page P that come from its
+   mapping's file. */
+static uint32_t
+page_read_bytes (const struct page *p)
+{
+  uint32_t left = p->map->read_bytes - ((uint8_t *) p->upage - p->map->upage);
+  return left < PGSIZE ? left : PGSIZE;
+}
+
+/* Called after page P of the current process has been read from
+   its file mapping because of a fault.  Maps the pages around P
+   that are already in memory, so that they will not fault too,
+   and reads ahead the pages after P if P's mapping seems to be
+   accessed sequentially.
+
+   A fault just after the previous one, or within the pages last
+   read ahead, counts as sequential and doubles the readahead
+   window; any other fault halves it.  MADV_RANDOM turns
+   readahead off and MADV_SEQUENTIAL sets the window to its
+   maximum. */
+static void
+file_fault (struct page *p)
+{
+  struct mapping *m = p->map;
+  uint8_t *upage = p->upage;
+
+  if (!p->writable)
+    fault_around (p);
+
+  if (p->advice == MADV_RANDOM)
+    m->ra_window = 0;
+  else if (p->advice == MADV_SEQUENTIAL)
+    m->ra_window = RA_MAX_PAGES;
+  else if (m->last_fault != NULL)
+    {
+      bool sequential = (upage > m->last_fault
+                         && (upage == m->last_fault + PGSIZE
+                             || upage < m->ra_end));
+      if (!sequential)
+        m->ra_window /= 2;
+      else if (m->ra_window < RA_MIN_PAGES)
+        m->ra_window = RA_MIN_PAGES;
+      else if (m->ra_window < RA_MAX_PAGES)
+        m->ra_window *= 2;
+    }
+  m->last_fault = upage;
+
+  if (m->ra_window > 0)
+    read_ahead (m, upage + PGSIZE, m->ra_window);
+}
+
+/* Maps every read-only page of the current process in the
+   aligned block of FAULT_AROUND_PAGES pages around page P that
+   belongs to P's file mapping, is not mapped yet, and whose
+   contents are already in memory.  Pages that would have to be
+   read are left alone. */
+static void
+fault_around (struct page *p)
+{
+  struct thread *t = process_current ();
+  struct mapping *m = p->map;
+  uint8_t *start = (uint8_t *) ROUND_DOWN ((uintptr_t) p->upage,
+                                           FAULT_AROUND_PAGES * PGSIZE);
+  size_t i;
+
+  for (i = 0; i < FAULT_AROUND_PAGES; i++)
+    {
+      struct page *q = page_lookup (start + i * PGSIZE);
+      struct shared_page *sp;
+
+      if (q == NULL || q->map != m || q->writable || page_kpage (q) != NULL)
+        continue;
+      sp = share_lookup (file_get_inode (m->file), page_file_ofs (q),
+                         page_read_bytes (q));
+      if (sp == NULL)
+        continue;
+      if (pagedir_set_page (t->pagedir, q->upage, share_get_kpage (sp),
+                            false))
+        {
+          q->shared = sp;
+          rss_add (t);
+          t->shared_rss++;
+        }
+      else
+        share_release (sp);
+    }
+}
+
+/* Asks for the PAGE_CNT pages of mapping M starting at START,
+   or as many of them as M has, to be read in the background,
+   except for pages that are already in memory or in swap. */
+static void
+read_ahead (struct mapping *m, uint8_t *start, size_t page_cnt)
+{
+  uint8_t *map_end = m->upage + m->page_cnt * PGSIZE;
+  uint8_t *end;
+  uint8_t *upage;
+
+  if (start >= map_end)
+    return;
+  end = page_cnt < (size_t) (map_end - start) / PGSIZE
+        ? start + page_cnt * PGSIZE : map_end;
+
+  for (upage = start; upage < end; upage += PGSIZE)
+    {
+      struct page *q = page_lookup (upage);
+      if (q != NULL && q->map == m && page_kpage (q) == NULL
+          && q->swap == NULL)
+        readahead_request (file_get_inode (m->file), page_file_ofs (q),
+                           page_read_bytes (q));
+    }
+  m->ra_end = end;
+}
+
+/* Makes the SIZE bytes of user memory starting at UADDR in the
+   current process resident, growing the stack if they extend it,
+   and pins them there until page_unpin() is called, so that
+   the kernel can transfer data to or from them without page
+   faults.  Readies the pages for writing if WRITE is true.
+   Pinned ranges may overlap, but each call must be matched by a
+   call to page_unpin() for the same range.
+
+   A page fault while holding a lock that eviction or paging may
+   need, such as the file system's, could deadlock, so any I/O
+   straight into or out of a user buffer must pin it first.
+
+   Returns true if successful.  Returns false, with nothing
+   pinned, if the range is not valid user memory or not writable
+   when WRITE is true, or if memory is exhausted. */
+bool
+page_pin (const void *uaddr, size_t size, bool write)
+{
+  struct thread *t = process_current ();
+  const uint8_t *start = pg_round_down (uaddr);
+  const uint8_t *end = (const uint8_t *) uaddr + size;
+  const uint8_t *upage;
+
+  if (size == 0)
+    return true;
+  if (t->pages == NULL || end < start || end > (uint8_t *) PHYS_BASE)
+    return false;
+
+  lock_acquire (&t->page_lock);
+  for (upage = start; upage < end; upage += PGSIZE)
+    {
+      struct page *p = page_lookup (upage);
+      bool resident;
+
+      /* The kernel data page is always resident, read-only. */
+      if (upage == VDATA_ADDR && !write)
+        continue;
+
+      resident = (p != NULL
+                  && (write
+                      ? p->frame != NULL
+                      : (page_kpage (p) != NULL || p->zero_mapped)));
+      if (!resident)
+        {
+          /* Judge stack growth by the buffer's own address, not
+             its page's, which may lie below the stack pointer. */
+          const void *addr = upage == start ? uaddr : upage;
+          resident = do_page_in (addr, write, thread_current ()->user_esp);
+          p = page_lookup (upage);
+        }
+      if (!resident || (write && !p->writable))
+        {
+          lock_release (&t->page_lock);
+          page_unpin (start, upage - start);
+          return false;
+        }
+
+      /* Frames shared with other processes, and the zero frame,
+         are never evicted while mapped. */
+      if (p->frame != NULL)
+        frame_pin (p->frame);
+    }
+  lock_release (&t->page_lock);
+  return true;
+}
+
+/* Unpins the SIZE bytes of user memory starting at UADDR in the
+   current process, which must have been pinned by page_pin(). */
+void
+page_unpin (const void *uaddr, size_t size)
+{
+  struct thread *t = process_current ();
+  const uint8_t *end = (const uint8_t *) uaddr + size;
+  const uint8_t *upage;
+
+  if (size == 0)
+    return;
+
+  lock_acquire (&t->page_lock);
+  for (upage = pg_round_down (uaddr); upage < end; upage += PGSIZE)
+    {
+      struct page *p = page_lookup (upage);
+      if (p != NULL && p->frame != NULL)
+        frame_unpin (p->frame);
+    }
+  lock_release (&t->page_lock);
+}
+
+/* Called after a fault on page P of the current process, in a
+   range advised MADV_SEQUENTIAL.  Brings the next few pages back
+   from swap before they are touched, and makes a page that the
+   scan has left behind the next candidate for eviction. */
+static void
+sequential_fault (struct page *p)
+{
+  uint8_t *upage = p->upage;
+  struct page *q;
+  size_t i;
+
+  for (i = 1; i <= READAHEAD_PAGES; i++)
+    {
+      if ((size_t) ((uint8_t *) PHYS_BASE - upage) <= i * PGSIZE)
+        break;
+      q = page_lookup (upage + i * PGSIZE);
+      if (q == NULL || q->advice != MADV_SEQUENTIAL)
+        break;
+      if (q->swap != NULL && !page_swap_in (q, false))
+        break;
+    }
+
+  if ((uintptr_t) upage >= DROP_BEHIND_PAGES * PGSIZE)
+    {
+      q = page_lookup (upage - DROP_BEHIND_PAGES * PGSIZE);
+      if (q != NULL && q->frame != NULL && q->advice == MADV_SEQUENTIAL)
+        {
+          q->age = 0;
+          frame_deactivate (q->frame);
+        }
+    }
+}
+
+/* Applies ADVICE, one of the MADV_* constants, to the pages of
+   the current process in the LENGTH bytes starting at ADDR, which
+   must be page-aligned.  Parts of the range that the process has
+   not mapped are ignored.  Returns false if the arguments are
+   invalid. */
+bool
+page_advise (void *addr, size_t length, int advice)
+{
+  struct thread *t = process_current ();
+  uint8_t *start = addr;
+  size_t page_cnt;
+
+  if (t->pages == NULL || pg_ofs (addr) != 0 || !is_user_vaddr (addr)
+      || length > (size_t) ((uint8_t *) PHYS_BASE - start)
+      || advice < MADV_NORMAL || advice > MADV_DONTNEED)
+    return false;
+  page_cnt = DIV_ROUND_UP (length, PGSIZE);
+
+  lock_acquire (&t->page_lock);
+  if (page_cnt <= hash_size (t->pages))
+    {
+      size_t i;
+
+      for (i = 0; i < page_cnt; i++)
+        {
+          struct page *p = page_lookup (start + i * PGSIZE);
+          if (p != NULL)
+            advise_page (p, advice);
+        }
+    }
+  else
+    {
+      /* The range is bigger than the whole address space in use,
+         so visit the pages we have instead of every address. */
+      struct hash_iterator i;
+
+      hash_first (&i, t->pages);
+      while (hash_next (&i))
+        {
+          struct page *p = hash_entry (hash_cur (&i), struct page, hash_elem);
+          if ((uint8_t *) p->upage >= start
+              && (size_t) ((uint8_t *) p->upage - start) < length)
+            advise_page (p, advice);
+        }
+    }
+  lock_release (&t->page_lock);
+  return true;
+}
+
+/* Applies ADVICE to page P of the current process. */
+static void
+advise_page (struct page *p, int advice)
+{
+  switch (advice)
+    {
+    case MADV_NORMAL:
+    case MADV_RANDOM:
+    case MADV_SEQUENTIAL:
+      p->advice = advice;
+      break;
+
+    case MADV_WILLNEED:
+      if (p->swap != NULL)
+        page_swap_in (p, false);
+      else if (p->map != NULL)
+        read_ahead (p->map, p->upage, 1);
+      break;
+
+    case MADV_DONTNEED:
+      page_discard (p);
+      break;
+
+    default:
+      NOT_REACHED ();
+    }
+}
+
+/* Throws away the contents of page P of the current process, so
+   that it is read back from its file mapping, or zero-filled,
+   when next touched.  Pinned pages are left alone. */
+static void
+page_discard (struct page *p)
+{
+  struct thread *t = process_current ();
+
+  if (p->frame != NULL && p->frame->pin_cnt > 0)
+    return;
+
+  if (p->frame != NULL)
+    {
+      pagedir_clear_page (t->pagedir, p->upage);
+      frame_free (p->frame);
+      p->frame = NULL;
+      t->vmstat.rss--;
+    }
+  else if (p->shared != NULL)
+    {
+      pagedir_clear_page (t->pagedir, p->upage);
+      share_release (p->shared);
+      p->shared = NULL;
+      t->vmstat.rss--;
+      t->shared_rss--;
+    }
+  else if (p->zero_mapped)
+    {
+      pagedir_clear_page (t->pagedir, p->upage);
+      p->zero_mapped = false;
+    }
+  if (p->swap != NULL)
+    {
+      swap_discard (p->swap);
+      p->swap = NULL;
+      t->vmstat.swapped--;
+    }
+  p->modified = false;
+}
+
+/* Returns true if an access to ADDR with the stack pointer at
+   ESP should grow the stack.  Besides anything at or above ESP,
+   this allows the few bytes below it that PUSH and PUSHA write
+   before updating ESP, but only within the stack size limit. */
+static bool
+is_stack_access (const void *addr, const void *esp)
+{
+  const uint8_t *stack_bottom
+    = (uint8_t *) PHYS_BASE - stack_page_limit * PGSIZE;
+
+  return ((const uint8_t *) addr >= (const uint8_t *) esp - STACK_SLOP
+          && (const uint8_t *) addr >= stack_bottom);
+}
+
+/* Maps the PAGE_CNT user virtual pages starting at UPAGE in
+   the current process to FILE, starting at page-aligned offset
+   OFS: the first READ_BYTES bytes come from FILE, and the rest
+   are zeros.  Nothing is read yet.  Each page is read from FILE,
+   or zero-filled, when first accessed.  Read-only pages are
+   shared with every other process that maps the same part of
+   the same file; writable pages get private copies.  FILE may
+   not be written while the mapping exists.
+
+   Returns false if memory allocation fails or any of the pages
+   is already in use, in which case some of the pages may have
+   been added anyway. */
+bool
+page_map_file (void *upage, struct file *file, off_t ofs,
+               uint32_t read_bytes, size_t page_cnt, bool writable)
+{
+  struct thread *t = process_current ();
+  struct mapping *m;
+  size_t i;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (ofs % PGSIZE == 0);
+  ASSERT (read_bytes <= page_cnt * PGSIZE);
+
+  m = malloc (sizeof *m);
+  if (m == NULL)
+    return false;
+  m->file = file_reopen (file);
+  if (m->file == NULL)
+    {
+      free (m);
+      return false;
+    }
+  file_deny_write (m->file);
+  m->ofs = ofs;
+  m->upage = upage;
+  m->page_cnt = page_cnt;
+  m->read_bytes = read_bytes;
+  m->last_fault = NULL;
+  m->ra_end = upage;
+  m->ra_window = RA_MIN_PAGES;
+  list_push_back (&t->mappings, &m->elem);
+
+  for (i = 0; i < page_cnt; i++)
+    {
+      struct page *p = page_allocate (m->upage + i * PGSIZE, writable);
+      if (p == NULL)
+        return false;
+      if (i * PGSIZE < read_bytes)
+        p->map = m;
+    }
+  return true;
+}
+
+/* Prints the current process's paging statistics. */
+void
+page_print_stats (void)
+{
+  struct thread *t = process_current ();
+  const struct vmstat *vs = &t->vmstat;
+
+  printf ("%s: vmstat: %u minor faults, %u major faults, "
+          "%u swap-ins, %u swap-outs\n",
+          t->name, vs->minor_faults, vs->major_faults,
+          vs->swap_ins, vs->swap_outs);
+  printf ("%s: vmstat: rss %u pages, peak %u pages, working set %u pages\n",
+          t->name, vs->rss, vs->peak_rss, vs->wss);
+}
+
+/* Counts one more resident page for process T. */
+static void
+rss_add (struct thread *t)
+{
+  if (++t->vmstat.rss > t->vmstat.peak_rss)
+    t->vmstat.peak_rss = t->vmstat.rss;
+}
+
+/* Unmaps and frees page E of the current process. */
+static void
+page_destroy (struct hash_elem *e, void *aux UNUSED)
+{
+  struct page *p = hash_entry (e, struct page, hash_elem);
+  struct thread *t = process_current ();
+
+  if (pagedir_get_page (t->pagedir, p->upage) != NULL)
+    {
+      pagedir_clear_page (t->pagedir, p->upage);
+      if (!p->zero_mapped)
+        t->vmstat.rss--;
+    }
+  if (p->frame != NULL)
+    frame_free (p->frame);
+  if (p->shared != NULL)
+    {
+      share_release (p->shared);
+      t->shared_rss--;
+    }
+  if (p->swap != NULL)
+    {
+      swap_discard (p->swap);
+      t->vmstat.swapped--;
+    }
+  free (p);
+}
+
+/* Returns a hash value for page E. */
+static unsigned
+page_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct page *p = hash_entry (e, struct page, hash_elem);
+  return hash_bytes (&p->upage, sizeof p->upage);
+}
+
+/* Returns true if page A precedes page B. */
+static bool
+page_less (const struct hash_elem *a_, const struct hash_elem *b_,
+           void *aux UNUSED)
+{
+  const struct page *a = hash_entry (a_, struct page, hash_elem);
+  const struct page *b = hash_entry (b_, struct page, hash_elem);
+
+  return a->upage < b->upage;
+}
@@ -0,0 +1,94 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
+#include <hash.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+
+struct file;
+struct thread;
+
+/* Default maximum size of a user stack, in pages (8 MB). */
+#define STACK_PAGES_DEFAULT 2048
+
+/* Maximum size of a user stack, in pages.
+   Controlled by kernel command-line option "-sl=COUNT". */
+extern size_t stack_page_limit;
+
+/* Print each process's paging statistics when it exits?
+   Controlled by kernel command-line option "-vmstat". */
+extern bool page_print_exit_stats;
+
+/* A range of user pages backed by a file, such as a segment of
+   an executable.  Its pages are read from the file when first
+   accessed.
+
+   Each mapping watches the order in which its pages fault, to
+   guess whether the process is working through it sequentially.
+   While it is, RA_WINDOW grows, and that many pages beyond each
+   fault are read ahead in the background; random faults shrink
+   the window again. */
+struct mapping
+  {
+    struct list_elem elem;      /* Element in thread's `mappings'. */
+    struct file *file;          /* File, reopened for the mapping. */
+    off_t ofs;                  /* Offset in FILE of first page. */
+    uint8_t *upage;             /* First user page. */
+    size_t page_cnt;            /* Number of pages. */
+    uint32_t read_bytes;        /* Bytes from FILE; the rest are zero. */
+    uint8_t *last_fault;        /* Page of most recent fault, or null. */
+    uint8_t *ra_end;            /* End of pages already read ahead. */
+    size_t ra_window;           /* Pages to read ahead per fault. */
+  };
+
+/* A user virtual page in a process's supplemental page table.
+
+   A private page is resident when FRAME is non-null, and in swap
+   when SWAP is non-null.  A page of a file mapping (MAP) that is
+   neither is read from the file on first access; once such a
+   page has been written and swapped out, MODIFIED is set, and it
+   goes back to swap rather than being dropped whenever it is
+   evicted, until its contents are discarded.  Other pages are
+   zero-filled: a read maps the shared zero frame (ZERO_MAPPED),
+   and the first write replaces it with a private frame.  A
+   read-only file page is mapped from a frame shared with other
+   processes, in which case SHARED is non-null. */
+struct page
+  {
+    struct hash_elem hash_elem; /* Element in thread's `pages'. */
+    void *upage;                /* User virtual address. */
+    bool writable;              /* Writable by the user process? */
+    uint8_t age;                /* Recent references, newest in MSB. */
+    bool zero_mapped;           /* Mapped to the shared zero frame? */
+    uint8_t advice;             /* MADV_NORMAL, _RANDOM, or _SEQUENTIAL. */
+    struct frame *frame;        /* Private frame, or null. */
+    struct shared_page *shared; /* Shared text page, or null. */
+    struct swap_entry *swap;    /* Where the page was evicted to, or null. */
+    struct mapping *map;        /* File mapping holding contents, or null. */
+    bool modified;              /* Contents differ from MAP's file? */
+  };
+
+void page_init (void);
+struct hash *page_table_create (void);
+void page_table_destroy (struct hash *);
+
+struct page *page_lookup (const void *upage);
+struct page *page_allocate (void *upage, bool writable);
+bool page_allocate_range (void *upage, size_t page_cnt);
+bool page_deallocate_range (void *upage, size_t page_cnt);
+bool page_load (struct page *);
+void *page_kpage (const struct page *);
+bool page_in (const void *fault_addr, bool write, const void *esp);
+bool page_evict (struct page *, struct thread *owner);
+bool page_pin (const void *uaddr, size_t size, bool write);
+void page_unpin (const void *uaddr, size_t size);
+bool page_advise (void *addr, size_t length, int advice);
+bool page_map_file (void *upage, struct file *, off_t ofs,
+                    uint32_t read_bytes, size_t page_cnt, bool writable);
+
+void page_print_stats (void);
+
+#endif /* vm/page.h */
@@ -0,0 +1,87 @@
+#include "vm/readahead.h"
+#include <debug.h>
+#include <list.h>
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "vm/share.h"
+
+/* Asynchronous readahead of executable pages.
+
+   A process that faults on one page of a read-only executable
+   segment asks for the pages after it to be read ahead.  The
+   "readahead" kernel thread reads them into the shared page
+   cache while the process keeps running, so that its later
+   faults on those pages are satisfied from memory. */
+
+/* Maximum number of outstanding requests.  Requests beyond this
+   are dropped: readahead is only a hint. */
+#define MAX_REQUESTS 64
+
+/* A request to read one page. */
+struct request
+  {
+    struct list_elem elem;      /* Element in `requests'. */
+    struct inode *inode;        /* File to read. */
+    off_t ofs;                  /* Page-aligned offset in INODE. */
+    uint32_t read_bytes;        /* Bytes to read. */
+  };
+
+static struct list requests;
+static size_t request_cnt;
+static struct lock request_lock;
+static struct condition request_ready;
+
+static thread_func readahead_thread NO_RETURN;
+
+/* Initializes readahead and starts the thread that does it. */
+void
+readahead_init (void)
+{
+  list_init (&requests);
+  lock_init (&request_lock);
+  cond_init (&request_ready);
+  thread_create ("readahead", PRI_DEFAULT, readahead_thread, NULL);
+}
+
+/* Asks for READ_BYTES bytes of INODE at page-aligned offset OFS
+   to be read into the shared page cache in the background. */
+void
+readahead_request (struct inode *inode, off_t ofs, uint32_t read_bytes)
+{
+  struct request *r;
+
+  lock_acquire (&request_lock);
+  if (request_cnt < MAX_REQUESTS && (r = malloc (sizeof *r)) != NULL)
+    {
+      r->inode = inode_reopen (inode);
+      r->ofs = ofs;
+      r->read_bytes = read_bytes;
+      list_push_back (&requests, &r->elem);
+      request_cnt++;
+      cond_signal (&request_ready, &request_lock);
+    }
+  lock_release (&request_lock);
+}
+
+/* Carries out readahead requests in order. */
+static void
+readahead_thread (void *aux UNUSED)
+{
+  for (;;)
+    {
+      struct request *r;
+
+      lock_acquire (&request_lock);
+      while (list_empty (&requests))
+        cond_wait (&request_ready, &request_lock);
+      r = list_entry (list_pop_front (&requests), struct request, elem);
+      request_cnt--;
+      lock_release (&request_lock);
+
+      share_prefetch (r->inode, r->ofs, r->read_bytes);
+      inode_close (r->inode);
+      free (r);
+    }
+}
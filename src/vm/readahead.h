@@ -0,0 +1,12 @@
+#ifndef VM_READAHEAD_H
+#define VM_READAHEAD_H
+
+#include <stdint.h>
+#include "filesys/off_t.h"
+
+struct inode;
+
+void readahead_init (void);
+void readahead_request (struct inode *, off_t ofs, uint32_t read_bytes);
+
+#endif /* vm/readahead.h */
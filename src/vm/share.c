@@ -0,0 +1,407 @@
+#include "vm/share.h"
+#include <debug.h>
+#include <hash.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "vm/frame.h"
+
+/* A read-only executable page, shared by every process that
+   maps the same page of the same file.
+
+   While any process maps the page, the entry denies writes to
+   the file, so the frame's contents can never go stale.  Every
+   process that maps pages of a file has denied writes to it
+   first, which waits for writes already under way to finish and
+   drop their stale pages, so a page is never picked up in the
+   middle of a write either.  When
+   the last mapping is released, the entry stays in the table as
+   an unmapped page in a small cache, so a process that runs the
+   same program shortly afterward, or that faults on a page read
+   ahead for it, finds the page already in memory.  Writing the
+   file drops its cached pages; cached pages are also the first
+   thing reclaimed when user memory runs out.
+
+   A page is read from its file without holding share_lock.
+   Meanwhile its entry is marked LOADING, and anyone else who
+   wants the page waits for the read to finish. */
+struct shared_page
+  {
+    struct hash_elem elem;      /* Element in `shared_pages'. */
+    struct list_elem list_elem; /* In `cache' or `loading', if either. */
+    struct inode *inode;        /* File the page was read from. */
+    off_t ofs;                  /* Page-aligned offset in INODE. */
+    uint32_t read_bytes;        /* Bytes read; the rest is zeroed. */
+    void *kpage;                /* Kernel virtual address of frame. */
+    int ref_cnt;                /* Number of user mappings. */
+    bool cached;                /* In `cache'? */
+    bool loading;               /* Being read from INODE? */
+    bool stale;                 /* INODE written during read? */
+    bool prefetched;            /* Read ahead and not yet mapped? */
+  };
+
+/* Maximum number of unmapped pages kept in the cache. */
+#define CACHE_PAGES 32
+
+/* Shared pages, keyed by (inode, ofs, read_bytes). */
+static struct hash shared_pages;
+
+/* Unmapped pages, least recently released first. */
+static struct list cache;
+static size_t cache_cnt;
+
+/* Pages being read in. */
+static struct list loading;
+
+static struct lock share_lock;
+static struct condition share_loaded;   /* Signaled when a read ends. */
+
+/* Statistics. */
+static long long share_hit_cnt;     /* # of lookups that found a frame. */
+static long long share_miss_cnt;    /* # of lookups that read the file. */
+static long long prefetch_cnt;      /* # of pages read ahead. */
+static long long prefetch_hit_cnt;  /* # of read-ahead pages later used. */
+
+static hash_hash_func shared_page_hash;
+static hash_less_func shared_page_less;
+static struct shared_page *find (struct inode *, off_t, uint32_t);
+static struct shared_page *start_load (struct inode *, off_t, uint32_t);
+static bool finish_load (struct shared_page *, bool prefetch);
+static void ref_get (struct shared_page *);
+static void cache_add (struct shared_page *);
+static void cache_drop (struct shared_page *);
+
+/* Initializes the shared page table. */
+void
+share_init (void)
+{
+  hash_init (&shared_pages, shared_page_hash, shared_page_less, NULL);
+  list_init (&cache);
+  list_init (&loading);
+  lock_init (&share_lock);
+  cond_init (&share_loaded);
+}
+
+/* Returns the shared page holding READ_BYTES bytes of INODE
+   starting at page-aligned offset OFS, followed by zeros to the
+   end of the page, reading it from INODE if it is not already
+   in memory.  Sets *DID_READ to true if it had to be read.  The
+   caller must already have denied writes to INODE, and must
+   eventually release the returned page with share_release().
+   Returns a null pointer if memory is exhausted or the file
+   cannot be read. */
+struct shared_page *
+share_acquire (struct inode *inode, off_t ofs, uint32_t read_bytes,
+               bool *did_read)
+{
+  struct shared_page *sp;
+
+  ASSERT (ofs % PGSIZE == 0);
+  ASSERT (read_bytes <= PGSIZE);
+
+  *did_read = false;
+  lock_acquire (&share_lock);
+  while ((sp = find (inode, ofs, read_bytes)) != NULL && sp->loading)
+    cond_wait (&share_loaded, &share_lock);
+  if (sp != NULL)
+    {
+      ref_get (sp);
+      share_hit_cnt++;
+      lock_release (&share_lock);
+      return sp;
+    }
+
+  /* Not in memory: read it in. */
+  sp = start_load (inode, ofs, read_bytes);
+  lock_release (&share_lock);
+  if (sp == NULL)
+    return NULL;
+
+  *did_read = true;
+  return finish_load (sp, false) ? sp : NULL;
+}
+
+/* Like share_acquire(), but returns a null pointer instead of
+   reading the page or waiting for it to be read. */
+struct shared_page *
+share_lookup (struct inode *inode, off_t ofs, uint32_t read_bytes)
+{
+  struct shared_page *sp;
+
+  lock_acquire (&share_lock);
+  sp = find (inode, ofs, read_bytes);
+  if (sp != NULL && !sp->loading)
+    {
+      ref_get (sp);
+      share_hit_cnt++;
+    }
+  else
+    sp = NULL;
+  lock_release (&share_lock);
+  return sp;
+}
+
+/* Reads READ_BYTES bytes of INODE at OFS into the cache, unless
+   they are already in memory, without mapping them anywhere. */
+void
+share_prefetch (struct inode *inode, off_t ofs, uint32_t read_bytes)
+{
+  struct shared_page *sp;
+
+  lock_acquire (&share_lock);
+  sp = find (inode, ofs, read_bytes) == NULL
+       ? start_load (inode, ofs, read_bytes) : NULL;
+  lock_release (&share_lock);
+
+  if (sp != NULL)
+    finish_load (sp, true);
+}
+
+/* Returns the kernel virtual address of the frame that holds
+   SP's contents. */
+void *
+share_get_kpage (const struct shared_page *sp)
+{
+  return sp->kpage;
+}
+
+/* Drops one mapping of SP.  Once no process maps it, writes to
+   its file are allowed again and the page moves to the cache. */
+void
+share_release (struct shared_page *sp)
+{
+  lock_acquire (&share_lock);
+  ASSERT (sp->ref_cnt > 0);
+  if (--sp->ref_cnt == 0)
+    {
+      inode_allow_write (sp->inode);
+      cache_add (sp);
+    }
+  lock_release (&share_lock);
+}
+
+/* Drops every cached page of INODE, whose contents have
+   changed, and keeps any page of INODE being read now from
+   being used. */
+void
+share_invalidate (struct inode *inode)
+{
+  struct list_elem *e, *next;
+
+  lock_acquire (&share_lock);
+  for (e = list_begin (&cache); e != list_end (&cache); e = next)
+    {
+      struct shared_page *sp = list_entry (e, struct shared_page, list_elem);
+      next = list_next (e);
+      if (sp->inode == inode)
+        cache_drop (sp);
+    }
+  for (e = list_begin (&loading); e != list_end (&loading); e = list_next (e))
+    {
+      struct shared_page *sp = list_entry (e, struct shared_page, list_elem);
+      if (sp->inode == inode)
+        sp->stale = true;
+    }
+  lock_release (&share_lock);
+}
+
+/* Frees the least recently used cached page.  Returns false if
+   the cache is empty. */
+bool
+share_reclaim (void)
+{
+  bool reclaimed = false;
+
+  lock_acquire (&share_lock);
+  if (!list_empty (&cache))
+    {
+      cache_drop (list_entry (list_front (&cache), struct shared_page,
+                              list_elem));
+      reclaimed = true;
+    }
+  lock_release (&share_lock);
+  return reclaimed;
+}
+
+/* Prints shared page statistics. */
+void
+share_print_stats (void)
+{
+  printf ("Share: %lld pages shared, %lld pages read\n",
+          share_hit_cnt, share_miss_cnt);
+  printf ("Share: %lld pages read ahead, %lld used\n",
+          prefetch_cnt, prefetch_hit_cnt);
+}
+
+/* Returns the shared page for (INODE, OFS, READ_BYTES), or a
+   null pointer if there is none.  Caller must hold share_lock. */
+static struct shared_page *
+find (struct inode *inode, off_t ofs, uint32_t read_bytes)
+{
+  struct shared_page key;
+  struct hash_elem *e;
+
+  key.inode = inode;
+  key.ofs = ofs;
+  key.read_bytes = read_bytes;
+  e = hash_find (&shared_pages, &key.elem);
+  return e != NULL ? hash_entry (e, struct shared_page, elem) : NULL;
+}
+
+/* Adds an entry for (INODE, OFS, READ_BYTES), which must not be
+   in the table, marked as loading.  The caller must then release
+   share_lock and call finish_load().  Returns a null pointer if
+   memory is exhausted.  Caller must hold share_lock. */
+static struct shared_page *
+start_load (struct inode *inode, off_t ofs, uint32_t read_bytes)
+{
+  struct shared_page *sp = malloc (sizeof *sp);
+  if (sp == NULL)
+    return NULL;
+
+  sp->inode = inode_reopen (inode);
+  sp->ofs = ofs;
+  sp->read_bytes = read_bytes;
+  sp->kpage = NULL;
+  sp->ref_cnt = 0;
+  sp->cached = false;
+  sp->loading = true;
+  sp->stale = false;
+  sp->prefetched = false;
+  hash_insert (&shared_pages, &sp->elem);
+  list_push_back (&loading, &sp->list_elem);
+  return sp;
+}
+
+/* Reads the contents of SP, which start_load() returned, and
+   wakes anyone waiting for it.  If PREFETCH is true, puts SP in
+   the cache; otherwise, maps it once for the caller.  Returns
+   true if successful.  On failure, or if the file was written in
+   the meantime, frees SP and returns false.  Must be called
+   without share_lock. */
+static bool
+finish_load (struct shared_page *sp, bool prefetch)
+{
+  bool ok;
+
+  /* Reading ahead is not worth evicting anything for. */
+  sp->kpage = palloc_get_page (PAL_USER);
+  if (sp->kpage == NULL && !prefetch
+      && (share_reclaim () || frame_reclaim ()))
+    sp->kpage = palloc_get_page (PAL_USER);
+  ok = (sp->kpage != NULL
+        && inode_read_at (sp->inode, sp->kpage, sp->read_bytes, sp->ofs)
+           == (off_t) sp->read_bytes);
+  if (ok)
+    memset ((uint8_t *) sp->kpage + sp->read_bytes, 0,
+            PGSIZE - sp->read_bytes);
+
+  lock_acquire (&share_lock);
+  list_remove (&sp->list_elem);
+  sp->loading = false;
+  cond_broadcast (&share_loaded, &share_lock);
+  if (!ok || sp->stale)
+    {
+      ASSERT (sp->ref_cnt == 0);
+      hash_delete (&shared_pages, &sp->elem);
+      if (sp->kpage != NULL)
+        palloc_free_page (sp->kpage);
+      inode_close (sp->inode);
+      free (sp);
+      ok = false;
+    }
+  else if (prefetch)
+    {
+      sp->prefetched = true;
+      prefetch_cnt++;
+      cache_add (sp);
+    }
+  else
+    {
+      ref_get (sp);
+      share_miss_cnt++;
+    }
+  lock_release (&share_lock);
+  return ok;
+}
+
+/* Adds a mapping of SP.  Caller must hold share_lock. */
+static void
+ref_get (struct shared_page *sp)
+{
+  ASSERT (!sp->loading);
+
+  if (sp->cached)
+    {
+      list_remove (&sp->list_elem);
+      sp->cached = false;
+      cache_cnt--;
+    }
+  if (sp->ref_cnt++ == 0)
+    inode_deny_write (sp->inode);
+  if (sp->prefetched)
+    {
+      sp->prefetched = false;
+      prefetch_hit_cnt++;
+    }
+}
+
+/* Puts SP, which no process maps, at the end of the cache,
+   dropping the oldest cached page if the cache is full.  Caller
+   must hold share_lock. */
+static void
+cache_add (struct shared_page *sp)
+{
+  ASSERT (sp->ref_cnt == 0 && !sp->cached);
+
+  list_push_back (&cache, &sp->list_elem);
+  sp->cached = true;
+  if (++cache_cnt > CACHE_PAGES)
+    cache_drop (list_entry (list_front (&cache), struct shared_page,
+                            list_elem));
+}
+
+/* Removes cached page SP from the table and frees it.  Caller
+   must hold share_lock. */
+static void
+cache_drop (struct shared_page *sp)
+{
+  ASSERT (sp->cached);
+
+  list_remove (&sp->list_elem);
+  sp->cached = false;
+  cache_cnt--;
+  hash_delete (&shared_pages, &sp->elem);
+  palloc_free_page (sp->kpage);
+  inode_close (sp->inode);
+  free (sp);
+}
+
+/* Returns a hash value for shared page E. */
+static unsigned
+shared_page_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct shared_page *sp = hash_entry (e, struct shared_page, elem);
+  return hash_int ((int) inode_get_inumber (sp->inode)
+                   ^ sp->ofs ^ (sp->read_bytes << 20));
+}
+
+/* Returns true if shared page A precedes shared page B. */
+static bool
+shared_page_less (const struct hash_elem *a_, const struct hash_elem *b_,
+                  void *aux UNUSED)
+{
+  const struct shared_page *a = hash_entry (a_, struct shared_page, elem);
+  const struct shared_page *b = hash_entry (b_, struct shared_page, elem);
+
+  if (a->inode != b->inode)
+    return a->inode < b->inode;
+  else if (a->ofs != b->ofs)
+    return a->ofs < b->ofs;
+  else
+    return a->read_bytes < b->read_bytes;
+}
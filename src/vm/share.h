@@ -0,0 +1,23 @@
+#ifndef VM_SHARE_H
+#define VM_SHARE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+
+struct inode;
+struct shared_page;
+
+void share_init (void);
+struct shared_page *share_acquire (struct inode *, off_t ofs,
+                                   uint32_t read_bytes, bool *did_read);
+struct shared_page *share_lookup (struct inode *, off_t ofs,
+                                  uint32_t read_bytes);
+void share_prefetch (struct inode *, off_t ofs, uint32_t read_bytes);
+void *share_get_kpage (const struct shared_page *);
+void share_release (struct shared_page *);
+void share_invalidate (struct inode *);
+bool share_reclaim (void);
+void share_print_stats (void);
+
+#endif /* vm/share.h */
@@ -0,0 +1,271 @@
+#include "vm/swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <list.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/block.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "vm/lz.h"
+#include "vm/zpool.h"
+
+/* Swap space for evicted anonymous pages.
+
+   Swap has two tiers.  An evicted page is compressed and kept in
+   RAM, in the compressed tier, if it compresses to at most
+   ZPOOL_MAX_SIZE bytes and the tier has room.  Otherwise it is
+   written to the swap disk.  When the compressed tier is full,
+   the pages that have been in it longest are decompressed and
+   spilled to disk to make room, on the theory that the pages
+   evicted longest ago are the least likely to be wanted back.
+
+   Reading a page back from the compressed tier costs a
+   decompression instead of eight sector reads, so a process
+   whose working set is a little larger than memory keeps
+   running at close to full speed. */
+
+/* Number of sectors in a page. */
+#define PAGE_SECTORS (PGSIZE / BLOCK_SECTOR_SIZE)
+
+/* An evicted page. */
+struct swap_entry
+  {
+    struct list_elem elem;      /* Element in `zswap_lru' if in RAM. */
+    void *data;                 /* Compressed data, or null if on disk. */
+    size_t size;                /* Size of DATA in bytes. */
+    size_t slot;                /* Page-sized slot on swap disk. */
+  };
+
+size_t zswap_page_limit;
+
+/* Swap disk and its slots, one bit per page: true if in use. */
+static struct block *swap_block;
+static struct bitmap *swap_slots;
+
+/* Entries in the compressed tier, oldest first. */
+static struct list zswap_lru;
+
+/* Protects all of the above. */
+static struct lock swap_lock;
+
+/* Buffers used while holding swap_lock. */
+static struct lz_dict lz_dict;
+static uint8_t zbuf[ZPOOL_MAX_SIZE];
+static void *spill_page;
+
+/* Statistics. */
+static long long disk_out_cnt;      /* Pages written to disk. */
+static long long disk_in_cnt;       /* Pages read from disk. */
+static long long zswap_out_cnt;     /* Pages stored compressed. */
+static long long zswap_in_cnt;      /* Pages read from compressed tier. */
+static long long zswap_reject_cnt;  /* Pages too big after compression. */
+static long long spill_cnt;         /* Pages spilled from tier to disk. */
+static long long zswap_bytes;       /* Total compressed size stored. */
+
+static size_t disk_write (const void *kpage);
+static void disk_read (size_t slot, void *kpage);
+static bool zswap_spill (void);
+
+/* Initializes swap, using the swap block device if there is one
+   and a compressed tier of up to zswap_page_limit pages. */
+void
+swap_init (void)
+{
+  swap_block = block_get_role (BLOCK_SWAP);
+  if (swap_block != NULL)
+    {
+      swap_slots = bitmap_create (block_size (swap_block) / PAGE_SECTORS);
+      if (swap_slots == NULL)
+        PANIC ("couldn't allocate swap slot bitmap");
+    }
+
+  list_init (&zswap_lru);
+  lock_init (&swap_lock);
+  zpool_init (zswap_page_limit);
+  if (zswap_page_limit > 0)
+    spill_page = palloc_get_page (PAL_ASSERT);
+}
+
+/* Saves the page at KPAGE in swap.  Returns a handle for getting
+   it back with swap_in(), or a null pointer if swap is full. */
+struct swap_entry *
+swap_out (const void *kpage)
+{
+  struct swap_entry *e;
+
+  e = malloc (sizeof *e);
+  if (e == NULL)
+    return NULL;
+
+  lock_acquire (&swap_lock);
+  if (zswap_page_limit > 0)
+    {
+      size_t size = lz_compress (kpage, PGSIZE, zbuf, sizeof zbuf, &lz_dict);
+      if (size > 0)
+        {
+          void *data = zpool_alloc (size);
+          while (data == NULL && zswap_spill ())
+            data = zpool_alloc (size);
+          if (data != NULL)
+            {
+              memcpy (data, zbuf, size);
+              e->data = data;
+              e->size = size;
+              list_push_back (&zswap_lru, &e->elem);
+              zswap_out_cnt++;
+              zswap_bytes += size;
+              lock_release (&swap_lock);
+              return e;
+            }
+        }
+      else
+        zswap_reject_cnt++;
+    }
+
+  e->data = NULL;
+  e->slot = disk_write (kpage);
+  lock_release (&swap_lock);
+
+  if (e->slot == BITMAP_ERROR)
+    {
+      free (e);
+      return NULL;
+    }
+  return e;
+}
+
+/* Reads the page saved as E into KPAGE and frees E.  Returns true
+   if the page had to be read from disk, false if it was still in
+   the compressed tier. */
+bool
+swap_in (struct swap_entry *e, void *kpage)
+{
+  bool from_disk;
+
+  lock_acquire (&swap_lock);
+  from_disk = e->data == NULL;
+  if (!from_disk)
+    {
+      if (!lz_decompress (e->data, e->size, kpage, PGSIZE))
+        PANIC ("corrupt page in compressed swap");
+      list_remove (&e->elem);
+      zpool_free (e->data);
+      zswap_in_cnt++;
+    }
+  else
+    {
+      disk_read (e->slot, kpage);
+      bitmap_reset (swap_slots, e->slot);
+    }
+  lock_release (&swap_lock);
+
+  free (e);
+  return from_disk;
+}
+
+/* Frees E without reading it back. */
+void
+swap_discard (struct swap_entry *e)
+{
+  lock_acquire (&swap_lock);
+  if (e->data != NULL)
+    {
+      list_remove (&e->elem);
+      zpool_free (e->data);
+    }
+  else
+    bitmap_reset (swap_slots, e->slot);
+  lock_release (&swap_lock);
+
+  free (e);
+}
+
+/* Prints swap statistics. */
+void
+swap_print_stats (void)
+{
+  long long in_cnt = zswap_in_cnt + disk_in_cnt;
+
+  printf ("Swap: %lld pages to disk, %lld pages from disk\n",
+          disk_out_cnt, disk_in_cnt);
+  if (zswap_page_limit > 0)
+    {
+      long long ratio = zswap_bytes > 0
+                        ? zswap_out_cnt * PGSIZE * 100 / zswap_bytes : 0;
+      long long hit_rate = in_cnt > 0 ? zswap_in_cnt * 100 / in_cnt : 0;
+
+      printf ("Swap: compressed %lld pages at %lld.%02lld:1, "
+              "%lld rejected, %lld spilled to disk\n",
+              zswap_out_cnt, ratio / 100, ratio % 100,
+              zswap_reject_cnt, spill_cnt);
+      printf ("Swap: %lld%% of swap-ins from compressed tier, "
+              "%zu pages in tier\n",
+              hit_rate, zpool_page_cnt ());
+    }
+}
+
+/* Moves the oldest page in the compressed tier to disk.
+   Returns false if the tier is empty or the disk is full.
+   Caller must hold swap_lock. */
+static bool
+zswap_spill (void)
+{
+  struct swap_entry *e;
+  size_t slot;
+
+  if (list_empty (&zswap_lru))
+    return false;
+  e = list_entry (list_front (&zswap_lru), struct swap_entry, elem);
+
+  if (!lz_decompress (e->data, e->size, spill_page, PGSIZE))
+    PANIC ("corrupt page in compressed swap");
+  slot = disk_write (spill_page);
+  if (slot == BITMAP_ERROR)
+    return false;
+
+  list_remove (&e->elem);
+  zpool_free (e->data);
+  e->data = NULL;
+  e->slot = slot;
+  spill_cnt++;
+  return true;
+}
+
+/* Writes KPAGE to a free slot on the swap disk and returns the
+   slot, or BITMAP_ERROR if there is no free slot.  Caller must
+   hold swap_lock. */
+static size_t
+disk_write (const void *kpage)
+{
+  size_t slot;
+  size_t i;
+
+  if (swap_block == NULL)
+    return BITMAP_ERROR;
+  slot = bitmap_scan_and_flip (swap_slots, 0, 1, false);
+  if (slot == BITMAP_ERROR)
+    return BITMAP_ERROR;
+
+  for (i = 0; i < PAGE_SECTORS; i++)
+    block_write (swap_block, slot * PAGE_SECTORS + i,
+                 (const uint8_t *) kpage + i * BLOCK_SECTOR_SIZE);
+  disk_out_cnt++;
+  return slot;
+}
+
+/* Reads swap disk slot SLOT into KPAGE.  Caller must hold
+   swap_lock. */
+static void
+disk_read (size_t slot, void *kpage)
+{
+  size_t i;
+
+  for (i = 0; i < PAGE_SECTORS; i++)
+    block_read (swap_block, slot * PAGE_SECTORS + i,
+                (uint8_t *) kpage + i * BLOCK_SECTOR_SIZE);
+  disk_in_cnt++;
+}
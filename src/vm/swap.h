@@ -0,0 +1,20 @@
+#ifndef VM_SWAP_H
+#define VM_SWAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Maximum number of pages of RAM the compressed swap tier may
+   use.  0 disables the tier.  Controlled by kernel command-line
+   option "-zswap=PAGES". */
+extern size_t zswap_page_limit;
+
+struct swap_entry;
+
+void swap_init (void);
+struct swap_entry *swap_out (const void *kpage);
+bool swap_in (struct swap_entry *, void *kpage);
+void swap_discard (struct swap_entry *);
+void swap_print_stats (void);
+
+#endif /* vm/swap.h */
@@ -0,0 +1,161 @@
+#include "vm/zpool.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Slab store for compressed pages.
+
+   Allocations are rounded up to a multiple of ZPOOL_ALIGN bytes,
+   and each rounded size has its own class of slabs.  A slab is
+   one kernel page holding a header followed by equal-sized
+   chunks, so a chunk's slab is found by rounding its address
+   down to a page boundary, and a chunk needs no header of its
+   own.  Free chunks of a slab are kept on a singly linked list
+   threaded through the chunks themselves.
+
+   A slab with free chunks is on its class's list of partial
+   slabs; a slab with no chunks in use is returned to the page
+   allocator at once, so the pool never holds more pages than its
+   contents need, rounded up per class.
+
+   The pool is not synchronized: callers must serialize access. */
+
+/* Number of size classes. */
+#define CLASS_CNT (ZPOOL_MAX_SIZE / ZPOOL_ALIGN)
+
+/* Header at the start of every slab page. */
+struct slab
+  {
+    struct list_elem elem;      /* Element in class's `partial' list. */
+    size_t class;               /* Index into `classes'. */
+    size_t used;                /* Number of chunks allocated. */
+    void *free;                 /* First free chunk, or null. */
+  };
+
+/* Offset of the first chunk in a slab. */
+#define CHUNK_OFS ROUND_UP (sizeof (struct slab), ZPOOL_ALIGN)
+
+/* A size class. */
+struct zpool_class
+  {
+    size_t chunk_size;          /* Bytes per chunk. */
+    size_t chunk_cnt;           /* Chunks per slab. */
+    struct list partial;        /* Slabs with at least one free chunk. */
+  };
+
+static struct zpool_class classes[CLASS_CNT];
+
+static size_t page_cnt;         /* Slab pages currently allocated. */
+static size_t page_limit;       /* Maximum value of page_cnt. */
+
+static struct slab *slab_create (struct zpool_class *);
+
+/* Initializes the pool to use at most PAGE_LIMIT pages. */
+void
+zpool_init (size_t page_limit_)
+{
+  size_t i;
+
+  for (i = 0; i < CLASS_CNT; i++)
+    {
+      struct zpool_class *c = &classes[i];
+      c->chunk_size = (i + 1) * ZPOOL_ALIGN;
+      c->chunk_cnt = (PGSIZE - CHUNK_OFS) / c->chunk_size;
+      list_init (&c->partial);
+    }
+  page_limit = page_limit_;
+}
+
+/* Allocates and returns a block of at least SIZE bytes, which
+   must be between 1 and ZPOOL_MAX_SIZE.  Returns a null pointer
+   if the pool is at its page limit and has no free chunk of the
+   right size. */
+void *
+zpool_alloc (size_t size)
+{
+  struct zpool_class *c;
+  struct slab *s;
+  void *chunk;
+
+  ASSERT (size > 0 && size <= ZPOOL_MAX_SIZE);
+
+  c = &classes[(size - 1) / ZPOOL_ALIGN];
+  if (!list_empty (&c->partial))
+    s = list_entry (list_front (&c->partial), struct slab, elem);
+  else
+    {
+      s = slab_create (c);
+      if (s == NULL)
+        return NULL;
+    }
+
+  chunk = s->free;
+  s->free = *(void **) chunk;
+  if (++s->used == c->chunk_cnt)
+    list_remove (&s->elem);
+  return chunk;
+}
+
+/* Frees CHUNK, which must have been returned by zpool_alloc(). */
+void
+zpool_free (void *chunk)
+{
+  struct slab *s = pg_round_down (chunk);
+  struct zpool_class *c = &classes[s->class];
+
+  ASSERT (s->used > 0);
+
+  if (s->used-- == c->chunk_cnt)
+    list_push_front (&c->partial, &s->elem);
+  if (s->used == 0)
+    {
+      list_remove (&s->elem);
+      palloc_free_page (s);
+      page_cnt--;
+    }
+  else
+    {
+      *(void **) chunk = s->free;
+      s->free = chunk;
+    }
+}
+
+/* Returns the number of pages the pool occupies. */
+size_t
+zpool_page_cnt (void)
+{
+  return page_cnt;
+}
+
+/* Allocates a new slab for class C, with every chunk free, and
+   adds it to C's partial list.  Returns the slab, or a null
+   pointer if the pool is at its limit or memory is exhausted. */
+static struct slab *
+slab_create (struct zpool_class *c)
+{
+  struct slab *s;
+  uint8_t *chunk;
+  size_t i;
+
+  if (page_cnt >= page_limit)
+    return NULL;
+  s = palloc_get_page (0);
+  if (s == NULL)
+    return NULL;
+  page_cnt++;
+
+  s->class = c - classes;
+  s->used = 0;
+  s->free = NULL;
+  chunk = (uint8_t *) s + CHUNK_OFS + c->chunk_cnt * c->chunk_size;
+  for (i = 0; i < c->chunk_cnt; i++)
+    {
+      chunk -= c->chunk_size;
+      *(void **) chunk = s->free;
+      s->free = chunk;
+    }
+  list_push_front (&c->partial, &s->elem);
+  return s;
+}
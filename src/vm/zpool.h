@@ -0,0 +1,19 @@
+#ifndef VM_ZPOOL_H
+#define VM_ZPOOL_H
+
+#include <stddef.h>
+
+/* Granularity of allocations from the pool, in bytes. */
+#define ZPOOL_ALIGN 64
+
+/* Largest allocation the pool supports, in bytes.  Storing a
+   compressed page any bigger would save too little to be worth
+   it. */
+#define ZPOOL_MAX_SIZE 3072
+
+void zpool_init (size_t page_limit);
+void *zpool_alloc (size_t size);
+void zpool_free (void *);
+size_t zpool_page_cnt (void);
+
+#endif /* vm/zpool.h */